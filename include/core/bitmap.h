@@ -0,0 +1,111 @@
+/**
+ * @file bitmap.h
+ * @brief Compressed bitmaps over row numbers (Roaring-style).
+ *
+ * A `Bitmap` is a set of 32-bit row numbers. The row space is split into chunks
+ * of 65536 rows, and every non-empty chunk is stored in the cheaper of two
+ * containers:
+ * - **Array:** a sorted list of the 16-bit low halves, for sparse chunks
+ * (up to 4096 rows).
+ * - **Bitset:** 1024 64-bit words, for dense chunks.
+ *
+ * Set operations (AND, OR, ANDNOT) work chunk by chunk, with merge loops on
+ * arrays and word-wide loops on bitsets, and counting variants give the size of
+ * a result without building it. The Dataset keeps one bitmap per flight status,
+ * origin, destination, airline and aircraft (see `dataset_flight_bitmap()`), so
+ * multi-predicate filters and counts never touch the flight rows.
+ *
+ * Every function accepts NULL as the empty set.
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <glib.h>
+
+/**
+ * @typedef Bitmap
+ * @brief Opaque handle for a compressed set of row numbers.
+ */
+typedef struct bitmap Bitmap;
+
+/**
+ * @brief Callback for `bitmap_foreach()`.
+ * @param row       A row number in the set.
+ * @param user_data The pointer passed to `bitmap_foreach()`.
+ */
+typedef void (*BitmapFunc)(guint32 row, gpointer user_data);
+
+/**
+ * @brief Creates an empty bitmap.
+ * @return A new bitmap. Free it with `bitmap_free()`.
+ */
+Bitmap *bitmap_new(void);
+
+/**
+ * @brief Frees a bitmap.
+ * @param bm The bitmap. If NULL, does nothing.
+ */
+void bitmap_free(Bitmap *bm);
+
+/**
+ * @brief Appends a row to the set.
+ *
+ * Rows must be appended in strictly increasing order, which is how indexes are
+ * built (one pass over the rows). Out-of-order rows are ignored.
+ *
+ * @param bm  The bitmap.
+ * @param row The row number.
+ */
+void bitmap_append(Bitmap *bm, guint32 row);
+
+/**
+ * @brief Checks whether @p row is in the set.
+ */
+gboolean bitmap_contains(const Bitmap *bm, guint32 row);
+
+/**
+ * @brief Returns the number of rows in the set.
+ */
+guint64 bitmap_cardinality(const Bitmap *bm);
+
+/**
+ * @brief Returns a new bitmap with the rows present in both @p a and @p b.
+ */
+Bitmap *bitmap_and(const Bitmap *a, const Bitmap *b);
+
+/**
+ * @brief Returns a new bitmap with the rows present in @p a, @p b or both.
+ */
+Bitmap *bitmap_or(const Bitmap *a, const Bitmap *b);
+
+/**
+ * @brief Returns a new bitmap with the rows of @p a that are not in @p b.
+ */
+Bitmap *bitmap_andnot(const Bitmap *a, const Bitmap *b);
+
+/**
+ * @brief Counts the rows present in both @p a and @p b, without building the result.
+ */
+guint64 bitmap_and_cardinality(const Bitmap *a, const Bitmap *b);
+
+/**
+ * @brief Counts the rows of @p a that are not in @p b, without building the result.
+ */
+guint64 bitmap_andnot_cardinality(const Bitmap *a, const Bitmap *b);
+
+/**
+ * @brief Calls @p func for every row in the set, in increasing order.
+ */
+void bitmap_foreach(const Bitmap *bm, BitmapFunc func, gpointer user_data);
+
+/**
+ * @brief Copies the rows of the set into a new array, in increasing order.
+ *
+ * @param bm    The bitmap.
+ * @param count [out] Receives the number of rows.
+ * @return A new array of row numbers (free with `g_free()`), or NULL if the set is empty.
+ */
+guint32 *bitmap_to_array(const Bitmap *bm, guint *count);
+
+#endif // BITMAP_H
@@ -0,0 +1,90 @@
+/**
+ * @file concurrent_map.h
+ * @brief Insert-mostly hash map for parallel builds, sealed into a `LookupTable`.
+ *
+ * `GHashTable` only supports one writer at a time, so parallel builders either
+ * keep one table per worker and merge them, or serialize on a lock. A
+ * `ConcurrentMap` lets every worker insert into the same table:
+ * - Its slots are the flat array of a `LookupTable`, sized up front for a
+ * maximum number of entries, so it never has to grow.
+ * - Inserting claims an empty slot with a single compare-and-swap; lookups take
+ * no lock at all.
+ * - Entries are never removed or replaced: an insert on an existing key returns
+ * the value already stored (get-or-insert), which is what grouping needs.
+ *
+ * Once the writers are done, `concurrent_map_seal()` hands the slot array over
+ * to a read-only `LookupTable` without copying it, so lookups (and batch
+ * lookups) after the build pay no synchronization at all.
+ */
+
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include <glib.h>
+#include "core/lookup_table.h"
+
+/**
+ * @typedef ConcurrentMap
+ * @brief Opaque handle for a concurrent insert-mostly map.
+ */
+typedef struct concurrent_map ConcurrentMap;
+
+/**
+ * @brief Creates an empty map.
+ *
+ * @param type          The kind of keys.
+ * @param max_entries   Upper bound on the number of distinct keys (the map does not grow).
+ * @param key_destroy   Function called on keys when the map (or its sealed table) is freed, or NULL.
+ * @param value_destroy Function called on values when the map (or its sealed table) is freed, or NULL.
+ * @return A new map. Free it with `concurrent_map_free()` or seal it with `concurrent_map_seal()`.
+ */
+ConcurrentMap *concurrent_map_new(LookupKeyType type, guint max_entries,
+                                  GDestroyNotify key_destroy, GDestroyNotify value_destroy);
+
+/**
+ * @brief Frees a map, and its keys and values if it owns them.
+ * @param map The map. If NULL, does nothing.
+ */
+void concurrent_map_free(ConcurrentMap *map);
+
+/**
+ * @brief Inserts an entry unless the key is already present. Thread-safe.
+ *
+ * When the key is already present, nothing is stored and the existing value is
+ * returned; @p key and @p value still belong to the caller, who can compare the
+ * result with @p value to know whether they were taken.
+ *
+ * The map never grows: inserting more distinct keys than it has slots is a
+ * sizing bug in the caller, reported with `g_critical()` (fatal under
+ * `G_DEBUG=fatal-criticals`) rather than treated as a normal outcome.
+ *
+ * @param map   The map.
+ * @param key   The key (a NULL string key is ignored).
+ * @param value The value (must not be NULL).
+ * @return The value stored under @p key, or NULL if the key was NULL or the map is full.
+ */
+gpointer concurrent_map_insert(ConcurrentMap *map, gpointer key, gpointer value);
+
+/**
+ * @brief Looks up a key. Thread-safe, lock-free.
+ * @return The value, or NULL if @p key is absent.
+ */
+gpointer concurrent_map_lookup(const ConcurrentMap *map, gconstpointer key);
+
+/**
+ * @brief Returns the number of entries.
+ */
+guint concurrent_map_size(const ConcurrentMap *map);
+
+/**
+ * @brief Turns the map into a read-only `LookupTable`.
+ *
+ * Must be called once every writer has finished. The slots are moved, not
+ * copied; the map is freed and the table inherits its destroy functions.
+ *
+ * @param map The map (consumed).
+ * @return The sealed table. Free it with `lookup_table_free()`.
+ */
+LookupTable *concurrent_map_seal(ConcurrentMap *map);
+
+#endif // CONCURRENT_MAP_H
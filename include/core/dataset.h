@@ -18,6 +18,9 @@
 #define DATASET_H
 
 #include <glib.h>
+#include <time.h>
+#include "core/string_dict.h"
+#include "core/bitmap.h"
 
 // --- Forward Declarations ---
 
@@ -67,9 +70,32 @@ typedef struct dataset Dataset;
  * }
  * dataset_iterator_free(it);
  * @endcode
+ *
+ * Hot loops (query initialization, index builds) should prefer the typed batch
+ * variants, which copy up to @c DATASET_BATCH_SIZE entity references per call
+ * into a caller-provided array:
+ * @code
+ * DatasetIterator *it = dataset_flight_iterator_new(ds);
+ * const Flight *batch[DATASET_BATCH_SIZE];
+ * guint n;
+ * while ((n = dataset_flight_iterator_next_batch(it, batch, DATASET_BATCH_SIZE)) > 0) {
+ *   for (guint i = 0; i < n; i++) {
+ *     // Process batch[i]
+ *   }
+ * }
+ * dataset_iterator_free(it);
+ * @endcode
  */
 typedef struct dataset_iter DatasetIterator;
 
+/**
+ * @brief Recommended capacity for the arrays passed to the batch iterators.
+ *
+ * Large enough to amortize the per-call overhead, small enough for the batch
+ * to stay resident in L1 while it is being processed.
+ */
+#define DATASET_BATCH_SIZE 256
+
 /**
  * @typedef DatasetStringIterator
  * @brief Opaque handle for String List Iterators.
@@ -206,6 +232,41 @@ const Reservation *dataset_get_reservation(const Dataset *ds, const char *id);
  */
 const AirportPassengerStats *dataset_get_airport_stats(const Dataset *ds, const char *code);
 
+/**
+ * @brief Retrieves many Flights at once.
+ *
+ * Equivalent to calling `dataset_get_flight()` for every ID, but the probes are
+ * issued in groups with their memory prefetched (see `lookup_table_get_batch()`),
+ * so the cache misses of a group overlap. Prefer it for hash joins such as
+ * resolving the legs of every reservation.
+ *
+ * @param ds  The dataset instance.
+ * @param ids The Flight IDs (NULL entries resolve to NULL).
+ * @param n   Number of IDs.
+ * @param out [out] Receives the Flight of each ID, or NULL if not found.
+ */
+void dataset_get_flights_batch(const Dataset *ds, const char *const *ids, guint n, const Flight **out);
+
+/**
+ * @brief Retrieves many Passengers at once (batched `dataset_get_passenger()`).
+ *
+ * @param ds  The dataset instance.
+ * @param ids The Passenger document numbers.
+ * @param n   Number of IDs.
+ * @param out [out] Receives the Passenger of each ID, or NULL if not found.
+ */
+void dataset_get_passengers_batch(const Dataset *ds, const int *ids, guint n, const Passenger **out);
+
+/**
+ * @brief Retrieves many Reservations at once (batched `dataset_get_reservation()`).
+ *
+ * @param ds  The dataset instance.
+ * @param ids The Reservation IDs (NULL entries resolve to NULL).
+ * @param n   Number of IDs.
+ * @param out [out] Receives the Reservation of each ID, or NULL if not found.
+ */
+void dataset_get_reservations_batch(const Dataset *ds, const char *const *ids, guint n, const Reservation **out);
+
 /**
  * @brief Creates a new iterator for the list of unique Airport Codes.
  *
@@ -237,6 +298,29 @@ DatasetStringIterator *dataset_aircraft_manufacturers_iter_new(Dataset *ds);
  */
 DatasetStringIterator *dataset_nationalities_iter_new(Dataset *ds);
 
+/**
+ * @brief Returns the dictionary of unique Airport Codes.
+ *
+ * Dictionaries support O(log n) prefix lookups (exact or case-insensitive) and
+ * fuzzy matching, returning spans into the Dataset's own storage.
+ *
+ * @param ds The dataset instance.
+ * @return The dictionary, owned by the Dataset, or NULL if not loaded.
+ */
+const StringDict *dataset_airport_codes_dict(const Dataset *ds);
+
+/**
+ * @brief Returns the dictionary of unique Aircraft Manufacturers.
+ * @see dataset_airport_codes_dict()
+ */
+const StringDict *dataset_aircraft_manufacturers_dict(const Dataset *ds);
+
+/**
+ * @brief Returns the dictionary of unique Passenger Nationalities.
+ * @see dataset_airport_codes_dict()
+ */
+const StringDict *dataset_nationalities_dict(const Dataset *ds);
+
 /**
  * @brief Advances the string iterator and retrieves the next string.
  *
@@ -297,6 +381,50 @@ DatasetIterator *dataset_passenger_iterator_new(const Dataset *ds);
  */
 const void *dataset_iterator_next(DatasetIterator *it);
 
+/**
+ * @brief Advances a Flight iterator by up to @p max entities at once.
+ *
+ * Copies the next references of the underlying collection into @p out. The
+ * traversal order is the same as the one produced by `dataset_iterator_next()`.
+ *
+ * @param it  An iterator created by `dataset_flight_iterator_new()`.
+ * @param out [out] Array with room for at least @p max pointers.
+ * @param max Maximum number of references to copy (usually `DATASET_BATCH_SIZE`).
+ * @return The number of references written to @p out. Returns 0 once the
+ * iteration is complete or if @p it is NULL.
+ */
+guint dataset_flight_iterator_next_batch(DatasetIterator *it, const Flight **out, guint max);
+
+/**
+ * @brief Advances an Aircraft iterator by up to @p max entities at once.
+ *
+ * @param it  An iterator created by `dataset_aircraft_iterator_new()`.
+ * @param out [out] Array with room for at least @p max pointers.
+ * @param max Maximum number of references to copy.
+ * @return The number of references written to @p out, 0 when exhausted.
+ */
+guint dataset_aircraft_iterator_next_batch(DatasetIterator *it, const Aircraft **out, guint max);
+
+/**
+ * @brief Advances a Reservation iterator by up to @p max entities at once.
+ *
+ * @param it  An iterator created by `dataset_reservation_iterator_new()`.
+ * @param out [out] Array with room for at least @p max pointers.
+ * @param max Maximum number of references to copy.
+ * @return The number of references written to @p out, 0 when exhausted.
+ */
+guint dataset_reservation_iterator_next_batch(DatasetIterator *it, const Reservation **out, guint max);
+
+/**
+ * @brief Advances a Passenger iterator by up to @p max entities at once.
+ *
+ * @param it  An iterator created by `dataset_passenger_iterator_new()`.
+ * @param out [out] Array with room for at least @p max pointers.
+ * @param max Maximum number of references to copy.
+ * @return The number of references written to @p out, 0 when exhausted.
+ */
+guint dataset_passenger_iterator_next_batch(DatasetIterator *it, const Passenger **out, guint max);
+
 /**
  * @brief Frees the memory allocated for an Entity Iterator.
  *
@@ -304,4 +432,148 @@ const void *dataset_iterator_next(DatasetIterator *it);
  */
 void dataset_iterator_free(DatasetIterator *it);
 
+// --- Row Spans ---
+
+/**
+ * @brief Exposes the whole Flights collection as a contiguous, read-only span.
+ *
+ * The Dataset keeps a dense array of entity references next to each lookup table,
+ * in iteration order. This accessor returns it directly (zero-copy), which lets
+ * callers index or partition the collection without an iterator.
+ *
+ * @param ds    The dataset instance.
+ * @param count [out] Receives the number of elements in the span (0 if empty).
+ * @return A pointer to the first reference, or `NULL` if the collection is not loaded.
+ * @warning The span is owned by the Dataset and is invalidated by `cleanupDataset()`.
+ */
+const Flight *const *dataset_flight_rows(const Dataset *ds, guint *count);
+
+/**
+ * @brief Exposes the whole Aircraft collection as a contiguous, read-only span.
+ * @see dataset_flight_rows()
+ */
+const Aircraft *const *dataset_aircraft_rows(const Dataset *ds, guint *count);
+
+/**
+ * @brief Exposes the whole Reservations collection as a contiguous, read-only span.
+ * @see dataset_flight_rows()
+ */
+const Reservation *const *dataset_reservation_rows(const Dataset *ds, guint *count);
+
+/**
+ * @brief Exposes the whole Passengers collection as a contiguous, read-only span.
+ * @see dataset_flight_rows()
+ */
+const Passenger *const *dataset_passenger_rows(const Dataset *ds, guint *count);
+
+// --- Flight Posting Lists ---
+
+/**
+ * @brief Attributes by which flights are grouped (see `dataset_flight_bitmap()`).
+ */
+typedef enum
+{
+    /** Flights grouped by origin airport code. */
+    FLIGHT_KEY_ORIGIN,
+
+    /** Flights grouped by destination airport code. */
+    FLIGHT_KEY_DESTINATION,
+
+    /** Flights grouped by airline name. */
+    FLIGHT_KEY_AIRLINE,
+
+    /** Flights grouped by aircraft ID. */
+    FLIGHT_KEY_AIRCRAFT,
+
+    /** Number of keys (not a valid key). */
+    FLIGHT_KEY_COUNT
+} DatasetFlightKey;
+
+// --- Flight Bitmaps ---
+
+/**
+ * @brief Returns the flight rows sharing a given origin, destination, airline or aircraft.
+ *
+ * Bit `i` stands for `dataset_flight_rows()[i]`. Bitmaps are built once after load
+ * (see `dataset_build_flight_indexes()`) and can be combined with
+ * the `bitmap_*` operations, e.g. `bitmap_andnot_cardinality()` against the
+ * "Cancelled" status bitmap to count the flights that actually operated.
+ *
+ * @param ds    The dataset instance.
+ * @param key   The attribute to group by.
+ * @param value The attribute value (e.g., an airport code).
+ * @return The bitmap, owned by the Dataset, or NULL if no flight matches (NULL is
+ * accepted by every `bitmap_*` function as the empty set).
+ */
+const Bitmap *dataset_flight_bitmap(const Dataset *ds, DatasetFlightKey key, const char *value);
+
+/**
+ * @brief Returns the flight rows with a given status.
+ *
+ * @param ds     The dataset instance.
+ * @param status A status as returned by `getFlightStatus()` (e.g., "Cancelled").
+ * @return The bitmap, owned by the Dataset, or NULL if no flight has that status.
+ * @see dataset_flight_bitmap()
+ */
+const Bitmap *dataset_flight_status_bitmap(const Dataset *ds, const char *status);
+
+/**
+ * @brief Creates an iterator over the distinct values of a flight key.
+ *
+ * Values are yielded in ascending `strcmp` order, each exactly once.
+ *
+ * @param ds  The dataset instance.
+ * @param key The attribute whose values to enumerate.
+ * @return A new iterator, or NULL if the indexes were not built.
+ */
+DatasetStringIterator *dataset_flight_keys_iter_new(const Dataset *ds, DatasetFlightKey key);
+
+// --- Time-Ordered Flights ---
+
+/**
+ * @brief Returns the flights whose scheduled departure falls in `[start, end)`.
+ *
+ * The dataset keeps a permutation of all flights sorted by scheduled departure,
+ * so the window is located with two binary searches and returned without copying:
+ * the cost is O(log N), and reading the result is proportional to the size of the
+ * window. The permutation is sorted by the first call (thread-safe), so a load
+ * that never asks for a time window does not pay for it.
+ * Flights with equal departures keep the collection's iteration order.
+ *
+ * @param ds    The dataset instance.
+ * @param start Inclusive lower bound (Unix time).
+ * @param end   Exclusive upper bound (Unix time). Pass `day + 86400` to include a whole day.
+ * @param count [out] Receives the number of flights in the span (0 if none).
+ * @return A pointer to the first flight of the window, or `NULL` if it is empty.
+ * @warning The span is owned by the Dataset and is invalidated by `cleanupDataset()`.
+ */
+const Flight *const *dataset_flights_in_range(const Dataset *ds, time_t start, time_t end, guint *count);
+
+/**
+ * @brief Same as `dataset_flights_in_range()`, but on the actual departure time.
+ *
+ * Flights without an actual departure (e.g. cancelled, "N/A") are not part of
+ * this ordering.
+ */
+const Flight *const *dataset_flights_in_actual_range(const Dataset *ds, time_t start, time_t end, guint *count);
+
+// --- Passenger Reservations ---
+
+/**
+ * @brief Returns every reservation booked by a passenger.
+ *
+ * Backed by a CSR (offsets + references) reverse index built once after load
+ * (see `dataset_build_passenger_index()`), so the cost is one hash probe plus
+ * the size of the result. Reservations are ordered by the scheduled departure
+ * of their first flight, ties broken by reservation ID.
+ *
+ * @param ds         The dataset instance.
+ * @param documentNo The passenger's document number.
+ * @param count      [out] Receives the number of reservations (0 if none).
+ * @return A pointer to the first reservation reference, or `NULL` if the passenger
+ * is unknown or has no bookings.
+ * @warning The span is owned by the Dataset and is invalidated by `cleanupDataset()`.
+ */
+const Reservation *const *dataset_passenger_reservations(const Dataset *ds, int documentNo, guint *count);
+
 #endif // DATASET_H
\ No newline at end of file
@@ -77,6 +77,60 @@ void dataset_set_aircrafts(Dataset *ds, GHashTable *aircrafts);
  */
 void dataset_set_reservations(Dataset *ds, GHashTable *reservations);
 
+/**
+ * @brief Overrides the row order of the Flights collection.
+ *
+ * By default, the rows behind iterators and `dataset_flight_rows()` follow the
+ * hash table's iteration order. A loader that already laid the entities out in
+ * a meaningful order (e.g., a frozen image) installs that order instead.
+ *
+ * @param ds The dataset instance.
+ * @param rows A `GPtrArray*` of `Flight*`, holding every entry of the Flights table.
+ * - Ownership: Transferred to `ds`.
+ */
+void dataset_set_flight_rows(Dataset *ds, GPtrArray *rows);
+
+/**
+ * @brief Overrides the row order of the Passengers collection.
+ * @see dataset_set_flight_rows()
+ */
+void dataset_set_passenger_rows(Dataset *ds, GPtrArray *rows);
+
+/**
+ * @brief Overrides the row order of the Aircrafts collection.
+ * @see dataset_set_flight_rows()
+ */
+void dataset_set_aircraft_rows(Dataset *ds, GPtrArray *rows);
+
+/**
+ * @brief Overrides the row order of the Reservations collection.
+ * @see dataset_set_flight_rows()
+ */
+void dataset_set_reservation_rows(Dataset *ds, GPtrArray *rows);
+
+/**
+ * @brief Attaches the memory block the entities are stored in.
+ *
+ * Used when the entity tables do not own their values (their values point into
+ * one contiguous block instead of individual allocations). The block is released
+ * after every table, when the Dataset is cleared or freed.
+ *
+ * @param ds      The dataset instance.
+ * @param block   The backing memory.
+ * @param destroy Function used to release @p block (may be NULL).
+ */
+void dataset_set_backing(Dataset *ds, gpointer block, GDestroyNotify destroy);
+
+/**
+ * @brief Releases everything the Dataset holds, leaving it empty.
+ *
+ * The Dataset itself stays valid, as if freshly returned by `initDataset()`,
+ * and can be populated again with the setters above.
+ *
+ * @param ds The dataset instance. If NULL, does nothing.
+ */
+void dataset_clear(Dataset *ds);
+
 /**
  * @brief Injects pre-calculated airport statistics into the Dataset.
  *
@@ -90,36 +144,64 @@ void dataset_set_reservations(Dataset *ds, GHashTable *reservations);
 void dataset_set_airport_stats(Dataset *ds, GHashTable *stats);
 
 /**
- * @brief Injects the sorted list of unique Airport Codes.
+ * @brief Injects the list of unique Airport Codes.
  *
- * Used for validation and autocomplete features.
+ * Used for validation and autocomplete features. The strings are copied into a
+ * sorted, deduplicated `StringDict`; the order of @p codes does not matter.
  *
  * @param ds The dataset instance.
  * @param codes A `GPtrArray*` of strings (airport codes).
- * - Ownership: Transferred to `ds`.
+ * - Ownership: Transferred to `ds`, which frees it once the dictionary is built.
  */
 void dataset_set_airport_codes(Dataset *ds, GPtrArray *codes);
 
 /**
- * @brief Injects the sorted list of unique Aircraft Manufacturers.
+ * @brief Injects the list of Aircraft Manufacturers (stored as a `StringDict`).
  *
  * Used for filtering queries (e.g., Query 2) and autocomplete.
  *
  * @param ds The dataset instance.
  * @param manufacturers A `GPtrArray*` of strings.
- * - Ownership: Transferred to `ds`.
+ * - Ownership: Transferred to `ds`, which frees it once the dictionary is built.
  */
 void dataset_set_aircraft_manufacturers(Dataset *ds, GPtrArray *manufacturers);
 
 /**
- * @brief Injects the sorted list of unique Nationalities.
+ * @brief Injects the list of Nationalities (stored as a `StringDict`).
  *
  * Used for autocomplete in interactive mode.
  *
  * @param ds The dataset instance.
  * @param nationalities A `GPtrArray*` of strings.
- * - Ownership: Transferred to `ds`.
+ * - Ownership: Transferred to `ds`, which frees it once the dictionary is built.
  */
 void dataset_set_nationalities(Dataset *ds, GPtrArray *nationalities);
 
+/**
+ * @brief Builds the flight indexes: row bitmaps by key and by status.
+ *
+ * Performs a single pass over the Flights collection to fill the row bitmaps
+ * (by origin, destination, airline, aircraft, plus a bitmap per status). The
+ * time-ordered permutations are not built here, but by the first
+ * `dataset_flights_in_range()` or `dataset_flights_in_actual_range()` call. Must be called after `dataset_set_flights()` (and after
+ * `dataset_set_flight_rows()`, since bitmaps refer to row numbers); calling it
+ * again rebuilds everything from scratch.
+ *
+ * @param ds The dataset instance.
+ * @see dataset_flight_bitmap(), dataset_flights_in_range()
+ */
+void dataset_build_flight_indexes(Dataset *ds);
+
+/**
+ * @brief Builds the passenger -> reservations reverse index.
+ *
+ * Must be called after both `dataset_set_passengers()` and
+ * `dataset_set_reservations()` (and after the flights, which are used to order
+ * each passenger's bookings). Calling it again rebuilds the index.
+ *
+ * @param ds The dataset instance.
+ * @see dataset_passenger_reservations()
+ */
+void dataset_build_passenger_index(Dataset *ds);
+
 #endif // DATASET_LOADER_H
\ No newline at end of file
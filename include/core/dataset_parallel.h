@@ -0,0 +1,155 @@
+/**
+ * @file dataset_parallel.h
+ * @brief Data-parallel scans over the Dataset collections.
+ *
+ * This module partitions a collection into contiguous chunks and processes them
+ * on a pool of worker threads. Each worker owns a private accumulator ("local
+ * state"), so the scan body never needs locks. Once every worker is done, the
+ * locals are handed back to the calling thread, one at a time and in chunk
+ * order, through a user-supplied combine callback.
+ *
+ * Because chunks are contiguous and combined in order, any reduction whose merge
+ * step is order-preserving (e.g. appending) produces exactly the same result as
+ * the equivalent sequential loop.
+ *
+ * Typical usage:
+ * @code
+ * static gpointer local_new(gpointer user_data) { return g_new0(MyCounts, 1); }
+ * static void body(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data) {
+ *   for (guint i = 0; i < count; i++) {
+ *     const Flight *f = rows[i];
+ *     // Accumulate into local
+ *   }
+ * }
+ * static void combine(gpointer local, gpointer user_data) {
+ *   // Merge local into user_data, then free local
+ * }
+ *
+ * DatasetParallelOps ops = {.local_new = local_new, .body = body, .combine = combine};
+ * dataset_parallel_foreach_flight(ds, &ops, &result);
+ * @endcode
+ */
+
+#ifndef DATASET_PARALLEL_H
+#define DATASET_PARALLEL_H
+
+#include <glib.h>
+#include <core/dataset.h>
+
+/**
+ * @brief Minimum number of rows assigned to a worker.
+ *
+ * Collections smaller than twice this value are scanned inline on the calling
+ * thread, since spawning threads would cost more than the scan itself. Can be
+ * overridden per scan through `DatasetParallelOps.grain`.
+ */
+#define DATASET_PARALLEL_MIN_CHUNK 4096
+
+/**
+ * @brief Set of callbacks describing a parallel scan.
+ *
+ * - **local_new** (optional): Creates the private accumulator of one chunk. Runs
+ *   on the worker thread. When NULL, @c body and @c combine receive NULL as local.
+ * - **body** (required): Processes the rows `rows[0 .. count-1]`, which are the
+ *   elements `[start, start + count)` of the whole collection. Runs on a worker
+ *   thread, concurrently with other chunks: it must only write to @p local or to
+ *   disjoint slots of shared output indexed by @p start.
+ * - **combine** (optional): Merges one local into the final result and releases
+ *   it. Runs on the calling thread, sequentially, in ascending chunk order.
+ * - **grain** (optional): Minimum number of rows per worker. 0 means
+ *   `DATASET_PARALLEL_MIN_CHUNK`; use a small value when each row is expensive
+ *   (e.g. a row is a whole posting list).
+ */
+typedef struct
+{
+    gpointer (*local_new)(gpointer user_data);
+    void (*body)(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data);
+    void (*combine)(gpointer local, gpointer user_data);
+    guint grain;
+} DatasetParallelOps;
+
+/**
+ * @brief Returns the number of worker threads used by the parallel scans.
+ *
+ * Defaults to the number of online processors.
+ */
+guint dataset_parallel_get_workers(void);
+
+/**
+ * @brief Overrides the number of worker threads used by the parallel scans.
+ *
+ * @param workers The new worker count. A value of 0 restores the default
+ * (number of online processors); 1 forces every scan to run inline.
+ */
+void dataset_parallel_set_workers(guint workers);
+
+/**
+ * @brief Runs a parallel scan over an arbitrary array of references.
+ *
+ * This is the generic entry point used by the typed variants below. It blocks
+ * until every chunk has been processed and combined.
+ *
+ * @param rows      The array to scan (may be NULL if @p count is 0).
+ * @param count     Number of elements in @p rows.
+ * @param ops       The scan callbacks.
+ * @param user_data Opaque pointer forwarded to every callback.
+ */
+void dataset_parallel_foreach_rows(const void *const *rows, guint count,
+                                   const DatasetParallelOps *ops, gpointer user_data);
+
+/**
+ * @brief Callback processing one task of `dataset_parallel_foreach_index()`.
+ *
+ * @param index     The task index, in `[0, count)`.
+ * @param user_data Opaque pointer given to `dataset_parallel_foreach_index()`.
+ */
+typedef void (*DatasetIndexFunc)(guint index, gpointer user_data);
+
+/**
+ * @brief Runs independent tasks of uneven cost on the worker threads.
+ *
+ * Scans split their rows evenly up front, which is right when every row costs
+ * about the same. Here, each worker starts with an even share of the indexes
+ * but takes them one at a time, and a worker that runs out steals the upper
+ * half of the remaining indexes of another worker. A few expensive tasks thus
+ * never leave the other workers idle.
+ *
+ * Tasks run concurrently and in no particular order: @p task must only write
+ * to state owned by its index. Blocks until every task has run.
+ *
+ * @param count     Number of tasks.
+ * @param task      Called once per index.
+ * @param user_data Opaque pointer forwarded to @p task.
+ */
+void dataset_parallel_foreach_index(guint count, DatasetIndexFunc task, gpointer user_data);
+
+/**
+ * @brief Runs a parallel scan over every Flight of the dataset.
+ *
+ * Rows are visited in the same order as `dataset_flight_iterator_new()`.
+ *
+ * @param ds        The dataset instance.
+ * @param ops       The scan callbacks. Rows are `const Flight *`.
+ * @param user_data Opaque pointer forwarded to every callback.
+ */
+void dataset_parallel_foreach_flight(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data);
+
+/**
+ * @brief Runs a parallel scan over every Aircraft of the dataset.
+ * @see dataset_parallel_foreach_flight()
+ */
+void dataset_parallel_foreach_aircraft(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data);
+
+/**
+ * @brief Runs a parallel scan over every Reservation of the dataset.
+ * @see dataset_parallel_foreach_flight()
+ */
+void dataset_parallel_foreach_reservation(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data);
+
+/**
+ * @brief Runs a parallel scan over every Passenger of the dataset.
+ * @see dataset_parallel_foreach_flight()
+ */
+void dataset_parallel_foreach_passenger(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data);
+
+#endif // DATASET_PARALLEL_H
@@ -0,0 +1,124 @@
+/**
+ * @file lookup_table.h
+ * @brief Open-addressing lookup table with batched, prefetching probes.
+ *
+ * A `LookupTable` maps keys (strings or integers) to values, borrowed unless the
+ * table was created with destroy functions.
+ * It is filled once and then only read, which allows a flat layout: a single
+ * power-of-two array of slots `{hash, key, value}` probed linearly.
+ *
+ * The flat layout is what makes batch lookups possible. A hash join (e.g., every
+ * reservation looking up its flights) normally waits on one cache miss per key;
+ * `lookup_table_get_batch()` instead runs a group of keys in three stages:
+ * 1. hash every key and prefetch its home slot;
+ * 2. prefetch the stored key of each slot whose hash matches;
+ * 3. resolve each key, by which time most of the memory is already in cache.
+ * The misses of the whole group overlap instead of being paid one after the other.
+ *
+ * Tables filled concurrently come from `concurrent_map_seal()`.
+ */
+
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+
+#include <glib.h>
+
+/**
+ * @brief Number of keys a batch lookup keeps in flight at once.
+ */
+#define LOOKUP_BATCH_GROUP 16
+
+/**
+ * @brief Kind of keys stored in a table.
+ */
+typedef enum
+{
+  /** NUL-terminated strings, compared with `strcmp`. */
+  LOOKUP_KEY_STRING,
+
+  /** Integers stored with `GINT_TO_POINTER()`. */
+  LOOKUP_KEY_INT
+} LookupKeyType;
+
+/**
+ * @typedef LookupTable
+ * @brief Opaque handle for an open-addressing lookup table.
+ */
+typedef struct lookup_table LookupTable;
+
+/**
+ * @brief Creates an empty table.
+ *
+ * @param type     The kind of keys.
+ * @param expected Expected number of entries (the table grows if exceeded).
+ * @return A new table. Free it with `lookup_table_free()`.
+ */
+LookupTable *lookup_table_new(LookupKeyType type, guint expected);
+
+/**
+ * @brief Creates an empty table that owns its keys and/or values.
+ *
+ * @param type          The kind of keys.
+ * @param expected      Expected number of entries (the table grows if exceeded).
+ * @param key_destroy   Function called on keys when the table is freed, or NULL.
+ * @param value_destroy Function called on values when the table is freed, or NULL.
+ * @return A new table. Free it with `lookup_table_free()`.
+ */
+LookupTable *lookup_table_new_full(LookupKeyType type, guint expected,
+                                   GDestroyNotify key_destroy, GDestroyNotify value_destroy);
+
+/**
+ * @brief Creates a table holding every entry of a `GHashTable`.
+ *
+ * Keys and values are borrowed from @p table, which must outlive the result.
+ *
+ * @param table The source table (may be NULL, yielding an empty table).
+ * @param type  The kind of keys of @p table.
+ */
+LookupTable *lookup_table_new_from_hash(GHashTable *table, LookupKeyType type);
+
+/**
+ * @brief Frees a table, and its keys and values if it owns them.
+ * @param table The table. If NULL, does nothing.
+ */
+void lookup_table_free(LookupTable *table);
+
+/**
+ * @brief Inserts (or replaces) an entry.
+ *
+ * As with `g_hash_table_insert()`, replacing an entry keeps the old key, and an
+ * owning table destroys the new key and the old value.
+ *
+ * @param table The table.
+ * @param key   The key (borrowed unless the table owns keys; must outlive the table).
+ * @param value The value.
+ */
+void lookup_table_insert(LookupTable *table, gconstpointer key, gpointer value);
+
+/**
+ * @brief Looks up a single key.
+ * @return The value, or NULL if @p key is absent.
+ */
+gpointer lookup_table_get(const LookupTable *table, gconstpointer key);
+
+/**
+ * @brief Looks up @p n keys at once, overlapping their cache misses.
+ *
+ * @param table The table.
+ * @param keys  The keys (NULL entries resolve to NULL).
+ * @param n     Number of keys.
+ * @param out   [out] Receives the value of each key, or NULL if absent.
+ */
+void lookup_table_get_batch(const LookupTable *table, const gconstpointer *keys, guint n, gpointer *out);
+
+/**
+ * @brief Returns the number of entries.
+ */
+guint lookup_table_size(const LookupTable *table);
+
+/**
+ * @brief Calls @p func for every entry, in slot order.
+ */
+void lookup_table_foreach(const LookupTable *table, GHFunc func, gpointer user_data);
+
+#endif // LOOKUP_TABLE_H
@@ -0,0 +1,57 @@
+/**
+ * @file lookup_table_internal.h
+ * @brief Internal layout of the `LookupTable`, shared with the concurrent map.
+ *
+ * `ConcurrentMap` (`src/core/concurrent_map.c`) fills the same slot array
+ * concurrently and hands it over to a `LookupTable` when sealed, so both
+ * modules need the slot layout and the hash function.
+ *
+ * @warning **Internal Header**: Do not include this file in public API headers or
+ * consumer modules. Use the opaque `LookupTable` typedef from `lookup_table.h` instead.
+ */
+
+#ifndef LOOKUP_TABLE_INTERNAL_H
+#define LOOKUP_TABLE_INTERNAL_H
+
+#include <glib.h>
+#include "core/lookup_table.h"
+
+/**
+ * @brief One entry of the table. A `hash` of 0 marks an empty slot.
+ */
+typedef struct
+{
+  guint64 hash;
+  gconstpointer key;
+  gpointer value;
+} LookupSlot;
+
+/**
+ * @brief Hashes a key. Never returns 0.
+ */
+guint64 lookup_table_hash(LookupKeyType type, gconstpointer key);
+
+/**
+ * @brief Checks whether two keys are equal.
+ */
+gboolean lookup_table_keys_equal(LookupKeyType type, gconstpointer a, gconstpointer b);
+
+/**
+ * @brief Returns the slot capacity used for @p n entries (a power of two).
+ */
+guint64 lookup_table_capacity_for(guint n);
+
+/**
+ * @brief Wraps an already filled slot array into a table.
+ *
+ * @param type          The kind of keys.
+ * @param slots         The slots (ownership is transferred; freed with `g_free()`).
+ * @param capacity      Number of slots (a power of two).
+ * @param size          Number of used slots.
+ * @param key_destroy   Function called on keys when the table is freed, or NULL.
+ * @param value_destroy Function called on values when the table is freed, or NULL.
+ */
+LookupTable *lookup_table_adopt(LookupKeyType type, LookupSlot *slots, guint64 capacity, guint size,
+                                GDestroyNotify key_destroy, GDestroyNotify value_destroy);
+
+#endif // LOOKUP_TABLE_INTERNAL_H
@@ -0,0 +1,33 @@
+/**
+ * @file radix_sort.h
+ * @brief Parallel, stable LSD radix sort of references keyed by 64-bit integers.
+ *
+ * Used to build the time-ordered flight permutations, where the key is a
+ * timestamp column. The sort processes the key one byte at a time (8 passes at
+ * most). Every pass is split across the worker pool of `dataset_parallel.h`:
+ * each chunk builds a digit histogram, the histograms are turned into per-chunk
+ * output offsets, and each chunk scatters its own elements. Passes in which
+ * every key shares the same digit (e.g. the high bytes of a timestamp) are skipped.
+ *
+ * Being stable, elements with equal keys keep their input order.
+ */
+
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <glib.h>
+
+/**
+ * @brief Sorts @p items by the corresponding @p keys, in ascending key order.
+ *
+ * Both arrays are permuted in place and in lockstep: after the call, `keys` is
+ * ascending and `items[i]` is still associated with `keys[i]`. Negative keys are
+ * ordered before positive ones.
+ *
+ * @param keys  The sort keys (length @p n).
+ * @param items The references to permute alongside the keys (length @p n).
+ * @param n     Number of elements.
+ */
+void radix_sort_by_key(gint64 *keys, gconstpointer *items, guint n);
+
+#endif // RADIX_SORT_H
@@ -12,6 +12,8 @@
 #define STATISTICS_H
 
 #include <glib.h>
+#include "core/dataset.h"
+#include <time.h>
 
 /**
  * @typedef AirportPassengerStats
@@ -42,18 +44,18 @@ void freeAirportPassengerStats(gpointer data);
  *
  * Iterates through all reservations, resolves the associated flights, and updates
  * the arrival/departure counts for the corresponding origin and destination airports.
+ * Flights are resolved in batches with `dataset_get_flights_batch()`.
  *
  * @note This is a computationally intensive operation typically performed once during
  * the dataset loading phase.
  *
- * @param reservations The hash table containing all `Reservation` entities.
- * @param flights The hash table containing all `Flight` entities.
+ * @param ds The dataset, with its flights and reservations already set.
  * @return A new `GHashTable` where:
  * - **Key**: `gchar*` - The Airport Code (e.g., "LIS").
  * - **Value**: `AirportPassengerStats*` - The computed statistics.
  * The caller is responsible for destroying this table using `g_hash_table_destroy()`.
  */
-GHashTable *calculate_airport_traffic(const GHashTable *reservations, const GHashTable *flights);
+GHashTable *calculate_airport_traffic(const Dataset *ds);
 
 /**
  * @brief Getter for the total number of arriving passengers.
@@ -73,4 +75,51 @@ long getAirportArrivals(const AirportPassengerStats *s);
  */
 long getAirportDepartures(const AirportPassengerStats *s);
 
+/**
+ * @typedef AirportDailyTraffic
+ * @brief Opaque day-by-day passenger traffic of a single airport.
+ *
+ * Holds the distinct days on which the airport had traffic, in ascending order,
+ * and prefix sums of its arrivals and departures over them. The traffic of any
+ * date window then takes two binary searches and two subtractions.
+ */
+typedef struct airport_daily_traffic AirportDailyTraffic;
+
+/**
+ * @brief Memory cleanup function for AirportDailyTraffic (compatible with `GDestroyNotify`).
+ *
+ * @param data A pointer to the `AirportDailyTraffic` structure to free. If NULL, does nothing.
+ */
+void freeAirportDailyTraffic(gpointer data);
+
+/**
+ * @brief Calculates the day-by-day traffic of all airports based on reservations.
+ *
+ * Counts the same legs as `calculate_airport_traffic()`, dated by the flight:
+ * departures on the day of the actual departure from the origin, arrivals on
+ * the day of the actual arrival at the destination. Legs without a known time
+ * are left out.
+ *
+ * @param ds The dataset, with its flights and reservations already set.
+ * @return A new `GHashTable` where:
+ * - **Key**: `gchar*` - The Airport Code (e.g., "LIS").
+ * - **Value**: `AirportDailyTraffic*` - The airport's traffic.
+ * The caller is responsible for destroying this table using `g_hash_table_destroy()`.
+ */
+GHashTable *calculate_airport_daily_traffic(const Dataset *ds);
+
+/**
+ * @brief Gets the passengers arrived at and departed from an airport within a date window.
+ *
+ * @note Time Complexity: O(log D), D being the number of days with traffic.
+ *
+ * @param t          The airport's traffic (NULL counts as none).
+ * @param from       First day of the window (any time within it).
+ * @param to         Last day of the window, included (any time within it).
+ * @param arrivals   [out] Passengers arrived in the window (0 if @p to is before @p from).
+ * @param departures [out] Passengers departed in the window.
+ */
+void getAirportTrafficBetween(const AirportDailyTraffic *t, time_t from, time_t to, long *arrivals,
+                              long *departures);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file string_dict.h
+ * @brief Immutable, sorted and deduplicated string dictionaries.
+ *
+ * A `StringDict` stores a set of strings in a single contiguous pool, together
+ * with two sorted views over it:
+ * - **Exact order:** sorted with `strcmp`, used for case-sensitive lookups.
+ * - **Folded order:** sorted with ASCII case-insensitive comparison.
+ *
+ * Because each view is sorted, all entries sharing a prefix are contiguous: a
+ * prefix lookup is two binary searches (O(log n)) and its result is returned as
+ * a span into the view, without copying. A fuzzy search (bounded edit distance)
+ * is provided as a fallback for misspelled input.
+ *
+ * Dictionaries back the airport code, manufacturer and nationality lists of
+ * the Dataset, and are consumed directly by the interactive autocomplete.
+ */
+
+#ifndef STRING_DICT_H
+#define STRING_DICT_H
+
+#include <glib.h>
+
+/**
+ * @typedef StringDict
+ * @brief Opaque handle for an immutable string dictionary.
+ */
+typedef struct string_dict StringDict;
+
+/**
+ * @brief Builds a dictionary from a list of strings.
+ *
+ * Strings are copied into the dictionary's pool; duplicates and NULL entries
+ * are dropped. The source array is left untouched.
+ *
+ * @param strings An array of `char*` (may be NULL, yielding an empty dictionary).
+ * @return A new dictionary. Free it with `string_dict_free()`.
+ */
+StringDict *string_dict_new(const GPtrArray *strings);
+
+/**
+ * @brief Frees a dictionary and its string pool.
+ * @param dict The dictionary. If NULL, does nothing.
+ */
+void string_dict_free(StringDict *dict);
+
+/**
+ * @brief Returns the number of distinct strings in the dictionary.
+ */
+guint string_dict_size(const StringDict *dict);
+
+/**
+ * @brief Returns all entries, in `strcmp` order.
+ *
+ * @param dict  The dictionary.
+ * @param count [out] Receives the number of entries.
+ * @return A span of entries owned by the dictionary, or NULL if it is empty.
+ */
+const char *const *string_dict_entries(const StringDict *dict, guint *count);
+
+/**
+ * @brief Checks whether @p str is in the dictionary (case-sensitive, O(log n)).
+ */
+gboolean string_dict_contains(const StringDict *dict, const char *str);
+
+/**
+ * @brief Returns every entry starting with @p prefix (case-sensitive).
+ *
+ * @param dict   The dictionary.
+ * @param prefix The prefix to look for. An empty prefix matches every entry.
+ * @param count  [out] Receives the number of matches.
+ * @return A span of matches in `strcmp` order, owned by the dictionary, or NULL if none.
+ */
+const char *const *string_dict_prefix(const StringDict *dict, const char *prefix, guint *count);
+
+/**
+ * @brief Returns every entry starting with @p prefix, ignoring ASCII case.
+ *
+ * @param dict   The dictionary.
+ * @param prefix The prefix to look for.
+ * @param count  [out] Receives the number of matches.
+ * @return A span of matches in case-insensitive order, owned by the dictionary, or NULL if none.
+ */
+const char *const *string_dict_prefix_ci(const StringDict *dict, const char *prefix, guint *count);
+
+/**
+ * @brief Finds the entries whose beginning is within @p maxDistance edits of @p query.
+ *
+ * The distance is the case-insensitive Levenshtein distance between @p query and
+ * the closest prefix of the entry, so partially typed words still match
+ * ("portgu" finds "Portugal"). This is a linear scan and is meant as a fallback
+ * when no prefix match exists.
+ *
+ * @param dict        The dictionary.
+ * @param query       The (possibly misspelled) input.
+ * @param maxDistance Maximum number of insertions, deletions or substitutions.
+ * @return A new `GPtrArray` of entries (owned by the dictionary), ordered by distance
+ * and then alphabetically. The caller frees the array itself with `g_ptr_array_free(arr, TRUE)`.
+ */
+GPtrArray *string_dict_fuzzy(const StringDict *dict, const char *query, guint maxDistance);
+
+#endif // STRING_DICT_H
@@ -94,4 +94,17 @@ int compare_time_t(time_t t1, time_t t2);
  */
 time_t parse_unix_date(const char *dt, int *cancelFlag);
 
+/**
+ * @brief Parses a date argument of a command, validating it first.
+ *
+ * Unlike @ref parse_unix_date, which trusts its input, any string is accepted:
+ * it must be exactly "yyyy-mm-dd" and a real calendar date.
+ *
+ * @param token The string to parse (NUL-terminated).
+ * @param day   [out] The seconds since the epoch of the start of that day.
+ *
+ * @return TRUE if @p token is a valid date, FALSE otherwise.
+ */
+gboolean parse_date_argument(const char *token, time_t *day);
+
 #endif
@@ -19,8 +19,9 @@
  *
  * Because GNU Readline's generator functions follow a fixed signature that precludes
  * passing the @c Dataset pointer directly, this function caches references to the
- * necessary data arrays (airport codes, manufacturers, nationalities) within the
- * completion module's local scope.
+ * Dataset's dictionaries (airport codes, manufacturers, nationalities) within the
+ * completion module's local scope. Nothing is copied: the Dataset must stay alive
+ * until the context is replaced (or cleared by passing @c NULL).
  *
  * @note This function **must** be called whenever a new dataset is loaded or reloaded
  * to ensure autocomplete suggestions remain synchronized with the actual data.
@@ -85,8 +86,9 @@ char **view_completion(const char *str, int start, int end);
 /**
  * @brief Context-aware completion hook for Airport Codes (Query 1).
  *
- * Iterates through the sorted list of **valid Airport IATA codes** present in the
- * currently loaded dataset to provide suggestions.
+ * Looks up the **valid Airport IATA codes** present in the currently loaded dataset.
+ * Matches are tried as an exact prefix, then ignoring case, and finally with a
+ * small edit distance so that typos still produce suggestions.
  *
  * @param str The partial string to match.
  * @param start Start index of the word.
@@ -98,8 +100,8 @@ char **airport_code_completion(const char *str, int start, int end);
 /**
  * @brief Context-aware completion hook for Aircraft Manufacturers (Query 2).
  *
- * Iterates through the sorted list of **valid Manufacturers** present in the
- * currently loaded dataset.
+ * Looks up the **valid Manufacturers** present in the currently loaded dataset,
+ * with the same matching rules as airport_code_completion().
  *
  * @param str The partial string to match.
  * @param start Start index of the word.
@@ -111,8 +113,8 @@ char **aircraft_manufs_completion(const char *str, int start, int end);
 /**
  * @brief Context-aware completion hook for Passenger Nationalities (Query 6).
  *
- * Iterates through the sorted list of **valid Nationalities** present in the
- * currently loaded dataset.
+ * Looks up the **valid Nationalities** present in the currently loaded dataset,
+ * with the same matching rules as airport_code_completion().
  *
  * @param str The partial string to match.
  * @param start Start index of the word.
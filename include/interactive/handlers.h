@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <glib.h>
 #include "core/dataset.h"
+#include "core/lookup_table.h"
 #include "queries/query4.h"
 
 /**
@@ -99,13 +100,13 @@ int query5wrapper(char *arg1, FILE *stream, GList *airlineDelays,
  *
  * @param arg1 The Nationality string (e.g., "Portuguese").
  * @param stream The output stream to write results to.
- * @param natTable Hash Table mapping nationalities to specific airport count structures.
+ * @param natTable Lookup table mapping nationalities to specific airport count structures.
  * @param isSpecial Formatting flag.
  *
  * @return 0 on success (data found and printed).
  * @return Non-zero if the nationality does not exist in the dataset.
  */
-int query6wrapper(char *arg1, FILE *stream, GHashTable *natTable,
+int query6wrapper(char *arg1, FILE *stream, const LookupTable *natTable,
                   int isSpecial);
 
 #endif // HANDLERS_H
\ No newline at end of file
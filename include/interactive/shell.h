@@ -23,11 +23,13 @@
  * It manages the application lifecycle state, including:
  * - initializing the autocomplete context.
  * - Managing the command history file (`.apphistory`).
- * - Reloading the dataset dynamically without restarting the program.
+ * - Reloading the dataset dynamically without restarting the program. New datasets
+ *   are loaded on a background thread while queries keep running against the current
+ *   one, and are swapped in (see `queries/generation.h`) once fully built.
  *
- * @param ds_ref A **handle** (double pointer) to the active Dataset instance.
- * Passed as a double pointer to allow the shell to destroy the existing dataset
- * and allocate a new one if the user executes the `dataset` command to switch paths.
+ * @param ds_ref A **handle** (double pointer) to the initial Dataset instance.
+ * The shell takes ownership of the dataset and sets `*ds_ref` to NULL; every dataset
+ * it uses is freed before this function returns.
  *
  * @param dataset_path_ptr A **handle** (double pointer) to the current dataset path string.
  * This string is updated and reallocated if the user successfully loads a new dataset.
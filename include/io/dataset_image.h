@@ -0,0 +1,145 @@
+/**
+ * @file dataset_image.h
+ * @brief Contiguous, relocatable images of a loaded Dataset.
+ *
+ * Once parsed, a Dataset is made of millions of small heap allocations (one per
+ * entity and one per string). A *Dataset image* packs the same data into a single
+ * block of memory:
+ * - **Header:** magic, version, total size and the location of every section.
+ * - **String pool:** every distinct string, NUL-terminated, stored once.
+ * - **Entity records:** fixed-size records per entity type, laid out for scan
+ * locality (flights by scheduled departure, passengers by document number,
+ * airports by code, aircrafts by ID). Reservations keep the Dataset's row order,
+ * so that order-sensitive aggregations (Query 4) give the same results.
+ * - **Reservation legs and dictionaries:** arrays of string references.
+ *
+ * Records never hold pointers: strings are referenced by their offset in the
+ * pool, and sections by their offset from the start of the block. An image can
+ * therefore be written to disk, mapped at any address (or into another process)
+ * and used as-is.
+ *
+ * Attaching an image to a Dataset creates the entity structs in a few contiguous
+ * arrays whose strings point straight into the image, then rebuilds the derived
+ * indexes (flight bitmaps, passenger index, airport statistics) over
+ * those arrays.
+ */
+
+#ifndef DATASET_IMAGE_H
+#define DATASET_IMAGE_H
+
+#include <glib.h>
+#include "core/dataset.h"
+
+/**
+ * @typedef DatasetImage
+ * @brief Opaque handle to a Dataset image (owned or borrowed memory block).
+ */
+typedef struct dataset_image DatasetImage;
+
+/**
+ * @brief Packs a loaded Dataset into a new image.
+ *
+ * The Dataset is only read; it remains valid and unchanged.
+ *
+ * @param ds The dataset to pack.
+ * @return A new image, or NULL if @p ds is NULL or its strings exceed the 4 GiB pool limit.
+ */
+DatasetImage *dataset_image_build(const Dataset *ds);
+
+/**
+ * @brief Selects the flights and reservations packed by `dataset_image_build_filtered()`.
+ *
+ * A NULL callback keeps every row of its kind.
+ */
+typedef struct
+{
+    gboolean (*keep_flight)(const Flight *f, gpointer user_data);
+    gboolean (*keep_reservation)(const Reservation *r, gpointer user_data);
+    gpointer user_data;
+} DatasetImageFilter;
+
+/**
+ * @brief Packs a subset of a loaded Dataset into a new image.
+ *
+ * Only the selected flights and reservations are packed; passengers, airports,
+ * aircrafts and dictionaries are always packed whole. Reservations keep their
+ * row order, and their legs are kept even when the flights are not.
+ *
+ * @param ds     The dataset to pack.
+ * @param filter The row selection (NULL packs everything, like `dataset_image_build()`).
+ * @return A new image, or NULL if @p ds is NULL or its strings exceed the 4 GiB pool limit.
+ */
+DatasetImage *dataset_image_build_filtered(const Dataset *ds, const DatasetImageFilter *filter);
+
+/**
+ * @brief Wraps an existing memory block holding an image.
+ *
+ * The header and section bounds are validated before anything is returned.
+ *
+ * @param data    Start of the image. Must be 8-byte aligned.
+ * @param size    Size of the block, in bytes.
+ * @param release Called with @p owner when the image is freed (may be NULL).
+ * @param owner   Handle passed to @p release (e.g., a mapping).
+ * @return A new image, or NULL if the block is not a valid image. On failure,
+ * @p release is not called.
+ */
+DatasetImage *dataset_image_wrap(gconstpointer data, gsize size, GDestroyNotify release, gpointer owner);
+
+/**
+ * @brief Maps an image previously written with `dataset_image_write()`.
+ *
+ * The file is mapped read-only; nothing is copied.
+ *
+ * @param path The image file.
+ * @return A new image, or NULL if the file cannot be mapped or is not a valid image.
+ */
+DatasetImage *dataset_image_open(const char *path);
+
+/**
+ * @brief Writes an image to a file, byte for byte.
+ *
+ * @param img  The image.
+ * @param path Destination file (created or truncated).
+ * @return TRUE on success.
+ */
+gboolean dataset_image_write(const DatasetImage *img, const char *path);
+
+/**
+ * @brief Returns the raw bytes of an image.
+ *
+ * @param img  The image.
+ * @param size [out] Receives the size of the block, in bytes.
+ * @return The start of the block, owned by the image.
+ */
+gconstpointer dataset_image_data(const DatasetImage *img, gsize *size);
+
+/**
+ * @brief Frees an image (and releases its memory block).
+ * @param img The image. If NULL, does nothing.
+ */
+void dataset_image_free(DatasetImage *img);
+
+/**
+ * @brief Populates an empty Dataset from an image.
+ *
+ * The Dataset takes ownership of @p img, which must stay mapped for as long as
+ * the Dataset lives; it is released by `cleanupDataset()`.
+ *
+ * @param ds  An empty dataset (fresh from `initDataset()` or `dataset_clear()`).
+ * @param img The image. Freed on failure.
+ * @return TRUE on success. On failure, @p ds is left untouched.
+ */
+gboolean dataset_image_attach(Dataset *ds, DatasetImage *img);
+
+/**
+ * @brief Compacts a loaded Dataset in place.
+ *
+ * Packs @p ds into an image, releases the original allocations and attaches the
+ * image back. Queries see the same data, now stored contiguously.
+ *
+ * @param ds The dataset to freeze.
+ * @return TRUE on success. On failure, @p ds is left as it was.
+ */
+gboolean dataset_freeze(Dataset *ds);
+
+#endif // DATASET_IMAGE_H
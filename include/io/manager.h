@@ -25,13 +25,37 @@
  * 2. **Dependent Entities**: Flights (depends on Airports and Aircrafts).
  * 3. **Highly Dependent Entities**: Reservations (depends on Users and Flights).
  *
+ * Once everything is parsed, the Dataset is frozen into a contiguous image
+ * (see `dataset_freeze()`) and its derived indexes are built.
+ *
  * @param ds [in,out] The dataset instance to populate. Must be initialized via `initDataset()`.
  * @param errorsFlag [out] Pointer to an integer. The function sets this to 1 if *any* parser
  * encounters invalid lines or file errors.
  * @param filePath [in] The root directory path containing the CSV files (e.g., "data/").
  * @param enable_timing [in] If `TRUE`, prints performance metrics (execution time per file) to stdout.
  * Useful for profiling the parsing bottleneck.
+ * @return `TRUE` if every CSV file could be read. Invalid lines (see @p errorsFlag) do not make it fail;
+ * a missing file does, and leaves that collection empty.
+ */
+gboolean loadAllDatasets(Dataset *ds, int *errorsFlag, const char *filePath, gboolean enable_timing);
+
+/**
+ * @brief Loads the dataset through a shared-memory segment.
+ *
+ * If a segment named @p sharedName has been published from the same CSV files
+ * (see `shared_dataset.h`), attaches it read-only and skips parsing entirely. Otherwise, loads the
+ * CSV files with `loadAllDatasets()` and publishes the result under that name
+ * for the next processes. The error files are only written by the process that
+ * parses the CSVs; attaching processes inherit its error flag.
+ *
+ * @param ds [in,out] The dataset instance to populate. Must be initialized via `initDataset()`.
+ * @param errorsFlag [out] Set to 1 if the parse (in this or the publishing process) found invalid lines.
+ * @param filePath [in] The root directory path containing the CSV files.
+ * @param sharedName [in] The shared-memory object name (e.g., "/flights-dataset"),
+ * or NULL to simply call `loadAllDatasets()`.
+ * @param enable_timing [in] If `TRUE`, prints performance metrics to stdout.
  */
-void loadAllDatasets(Dataset *ds, int *errorsFlag, const char *filePath, gboolean enable_timing);
+void loadSharedDataset(Dataset *ds, int *errorsFlag, const char *filePath, const char *sharedName,
+                       gboolean enable_timing);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+/**
+ * @file output_builder.h
+ * @brief Formatting of query results into a caller-provided buffer.
+ *
+ * The result lines are made of strings, integers and fixed-point numbers joined
+ * by a separator (';', or '=' for the special variant of a command). Building
+ * them with `g_strdup_printf()` and `fprintf()` costs heap allocations, format
+ * parsing and locale handling on every command. An `OutputBuilder` appends the
+ * fields to a buffer owned by the caller (usually on the stack) instead, with
+ * hand-rolled number formatting, and hands the bytes to the output stream only
+ * when the buffer fills up or on `output_builder_flush()`.
+ *
+ * The separator is chosen once, when the builder is initialized, so results never
+ * need rewriting afterwards. Numbers come out exactly as `printf()` would print
+ * them in the "C" locale.
+ */
+
+#ifndef OUTPUT_BUILDER_H
+#define OUTPUT_BUILDER_H
+
+#include <glib.h>
+#include <stdio.h>
+
+/**
+ * @brief Suggested size for the buffer of a builder.
+ */
+#define OUTPUT_BUILDER_SIZE 4096
+
+/**
+ * @brief A result being formatted. Fill it with `output_builder_init()`.
+ */
+typedef struct
+{
+    char *data;     /**< The caller's buffer. */
+    gsize capacity; /**< Size of @p data. */
+    gsize length;   /**< Bytes not yet written out. */
+    char separator; /**< Written by `output_builder_separator()`. */
+    FILE *sink;     /**< Where the bytes go. */
+} OutputBuilder;
+
+/**
+ * @brief Prepares a builder.
+ *
+ * @param b         The builder.
+ * @param buffer    Working space, e.g. `char buffer[OUTPUT_BUILDER_SIZE]` (at least 64 bytes).
+ * @param capacity  Size of @p buffer.
+ * @param isSpecial Non-zero for the '=' separator, zero for ';'.
+ * @param sink      The output stream.
+ */
+void output_builder_init(OutputBuilder *b, char *buffer, gsize capacity, int isSpecial, FILE *sink);
+
+/**
+ * @brief Appends a string (nothing if it is NULL).
+ */
+void output_builder_string(OutputBuilder *b, const char *str);
+
+/**
+ * @brief Appends @p len bytes.
+ */
+void output_builder_bytes(OutputBuilder *b, const char *data, gsize len);
+
+/**
+ * @brief Appends one character.
+ */
+void output_builder_char(OutputBuilder *b, char c);
+
+/**
+ * @brief Appends the separator chosen at initialization.
+ */
+void output_builder_separator(OutputBuilder *b);
+
+/**
+ * @brief Appends an integer, as "%lld" would.
+ */
+void output_builder_int(OutputBuilder *b, gint64 value);
+
+/**
+ * @brief Appends an integer padded with zeros to @p width digits, as "%0*lld" would.
+ */
+void output_builder_int_padded(OutputBuilder *b, gint64 value, guint width);
+
+/**
+ * @brief Appends a number with @p decimals decimal places, as "%.*f" would.
+ *
+ * @param b        The builder.
+ * @param value    The number.
+ * @param decimals Decimal places (at most 9).
+ */
+void output_builder_fixed(OutputBuilder *b, gdouble value, guint decimals);
+
+/**
+ * @brief Writes the buffered bytes to the output stream.
+ */
+void output_builder_flush(OutputBuilder *b);
+
+#endif // OUTPUT_BUILDER_H
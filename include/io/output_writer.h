@@ -0,0 +1,106 @@
+/**
+ * @file output_writer.h
+ * @brief Asynchronous, buffered writing of the command results.
+ *
+ * Each command used to `fopen()` its own result file and `fprintf()` into it,
+ * which costs several metadata syscalls per command; for cheap queries (Q1,
+ * Q6) this dominates the run. The output writer moves that work off the query
+ * threads:
+ * - Queries write into an in-memory buffer, taken from a fixed pool and seen
+ * as an ordinary `FILE *`. Once a command is done, its buffer is submitted.
+ * - A dedicated writer thread takes the submitted buffers in batches, writes
+ * them out, and returns them to the pool. When every buffer is in flight,
+ * `output_writer_acquire()` waits for one, which bounds the memory used.
+ *
+ * Two layouts are available:
+ * - **OUTPUT_FILES:** one `commandN_output.txt` per command, as before.
+ * - **OUTPUT_PACKED:** every result goes into a single `commands_output.txt`,
+ * in completion order, and `commands_output.idx` tells where each one is.
+ * The index is an array of `OutputIndexEntry` records, sorted by command number.
+ */
+
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <glib.h>
+#include <stdio.h>
+
+/**
+ * @typedef OutputWriter
+ * @brief Opaque handle for the writer thread and its buffer pool.
+ */
+typedef struct output_writer OutputWriter;
+
+/**
+ * @typedef OutputBuffer
+ * @brief Opaque handle for one pooled result buffer.
+ */
+typedef struct output_buffer OutputBuffer;
+
+/**
+ * @brief Layout of the result files.
+ */
+typedef enum
+{
+    OUTPUT_FILES, /**< One `commandN_output.txt` file per command. */
+    OUTPUT_PACKED /**< A single results file plus an offset index. */
+} OutputMode;
+
+/**
+ * @brief One record of the packed index (`commands_output.idx`), in host byte order.
+ */
+typedef struct
+{
+    guint32 command; /**< The command number (its line in the commands file). */
+    guint32 length;  /**< Size of its result, in bytes. */
+    guint64 offset;  /**< Position of its result in `commands_output.txt`. */
+} OutputIndexEntry;
+
+/**
+ * @brief Starts a writer thread.
+ *
+ * @param directory The directory receiving the result files (e.g., "resultados").
+ * @param mode      The layout of the result files.
+ * @return A new writer, or NULL if the directory (or, in packed mode, the
+ * results file) cannot be opened.
+ */
+OutputWriter *output_writer_new(const char *directory, OutputMode mode);
+
+/**
+ * @brief Takes an empty buffer from the pool, waiting if every buffer is in flight.
+ *
+ * Thread-safe.
+ *
+ * @param writer  The writer.
+ * @param command The command number the result belongs to.
+ * @return The buffer; write the result through `output_buffer_stream()`.
+ */
+OutputBuffer *output_writer_acquire(OutputWriter *writer, int command);
+
+/**
+ * @brief Returns the stream writing into a buffer.
+ *
+ * The stream stays owned by the buffer: do not close it.
+ */
+FILE *output_buffer_stream(OutputBuffer *buffer);
+
+/**
+ * @brief Hands a filled buffer over to the writer thread. Thread-safe.
+ *
+ * @param writer The writer.
+ * @param buffer The buffer (no longer usable by the caller).
+ */
+void output_writer_submit(OutputWriter *writer, OutputBuffer *buffer);
+
+/**
+ * @brief Waits until every submitted buffer has been written out.
+ */
+void output_writer_flush(OutputWriter *writer);
+
+/**
+ * @brief Writes out the pending buffers (and the packed index), stops the thread and frees the writer.
+ * @param writer The writer. If NULL, does nothing.
+ */
+void output_writer_free(OutputWriter *writer);
+
+#endif // OUTPUT_WRITER_H
@@ -0,0 +1,92 @@
+/**
+ * @file shared_dataset.h
+ * @brief Publishing a loaded Dataset in named shared memory, for other processes to attach.
+ *
+ * Several jobs often run against the same dataset at once. Instead of each one
+ * reparsing the CSV files into a private copy, the first job publishes its
+ * Dataset image (see `dataset_image.h`) into a POSIX shared-memory object, and
+ * the following jobs map that object read-only and attach it directly:
+ * - The segment holds a header (magic, parser error flag, the CSV files it was
+ * parsed from, image location) followed by the image. Images contain offsets,
+ * never pointers, so the mapping address does not matter.
+ * - A segment is only attached by a job reading the same CSV files: same
+ * canonical directory, and same size and modification time for each file.
+ * Any other job parses the files itself.
+ * - The magic is written last, so a half-written segment is never attached.
+ * - Every string of the Dataset lives in the shared mapping, so the page cache
+ * holds a single copy for all jobs. Each job still builds its own entity
+ * structs, indexes and query contexts over it.
+ *
+ * The segment outlives the publishing process, and is not replaced while it
+ * exists: remove it with `dataset_shared_unlink()` (`--unlink-shared=NAME` on
+ * the command line) once its files change, so that the next job publishes them.
+ */
+
+#ifndef SHARED_DATASET_H
+#define SHARED_DATASET_H
+
+#include <glib.h>
+#include "core/dataset.h"
+
+#define SHARED_SOURCE_FILES 5
+#define SHARED_SOURCE_PATH_MAX 4096
+
+/**
+ * @brief Identifies the CSV files a dataset is parsed from.
+ *
+ * Fixed-size and free of padding, so it is stored as is in the segment header
+ * and compared byte by byte.
+ */
+typedef struct
+{
+    char path[SHARED_SOURCE_PATH_MAX];          /**< Canonical dataset directory, zero-padded. */
+    guint64 sizes[SHARED_SOURCE_FILES];        /**< Size of each CSV file. */
+    gint64 mtimes[SHARED_SOURCE_FILES];        /**< Modification time of each file, in ns (-1 if missing). */
+} DatasetSource;
+
+/**
+ * @brief Describes the CSV files currently found in a dataset directory.
+ *
+ * Call it before parsing them: a file modified during the parse then no longer
+ * matches, and its stale image is never attached.
+ *
+ * @param source      [out] The description.
+ * @param datasetPath The dataset directory, as given on the command line.
+ */
+void dataset_source_read(DatasetSource *source, const char *datasetPath);
+
+/**
+ * @brief Publishes a loaded Dataset under a shared-memory name.
+ *
+ * Fails without touching anything if the name is already taken, so concurrent
+ * publishers are safe: exactly one of them creates the segment.
+ *
+ * @param ds     The loaded dataset (only read).
+ * @param name   The shared-memory object name (e.g., "/flights-dataset").
+ * @param source The files @p ds was parsed from, read before parsing them.
+ * @param errors The parser error flag, handed over to the attaching processes.
+ * @return TRUE if the segment was created and filled.
+ */
+gboolean dataset_shared_publish(const Dataset *ds, const char *name, const DatasetSource *source, int errors);
+
+/**
+ * @brief Attaches a published Dataset, read-only.
+ *
+ * @param ds     An empty dataset (fresh from `initDataset()`).
+ * @param name   The shared-memory object name.
+ * @param source The files the caller would parse; the segment must have been published from them.
+ * @param errors [out] Receives the error flag of the publisher's parse (may be NULL).
+ * @return TRUE on success. On failure (no segment, incomplete or invalid
+ * segment, segment published from other files), @p ds is left untouched.
+ */
+gboolean dataset_shared_attach(Dataset *ds, const char *name, const DatasetSource *source, int *errors);
+
+/**
+ * @brief Removes a published segment. Processes already attached keep their mapping.
+ *
+ * @param name The shared-memory object name.
+ * @return TRUE if the segment existed and was removed.
+ */
+gboolean dataset_shared_unlink(const char *name);
+
+#endif // SHARED_DATASET_H
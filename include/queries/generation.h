@@ -0,0 +1,155 @@
+/**
+ * @file generation.h
+ * @brief Reference-counted Dataset + QueryManager generations.
+ *
+ * A *generation* bundles a fully loaded `Dataset` with the `QueryManager` whose
+ * contexts are built from it. Generations are immutable once published and are
+ * shared through reference counting: whoever runs a query first acquires a
+ * reference to the current generation, and releases it when done. The memory of
+ * a generation is only reclaimed when its last reference is dropped.
+ *
+ * This allows a new dataset to be loaded in the background (see
+ * `generation_build_start()`) while queries keep running against the current
+ * generation, and to swap it in atomically through a `GenerationSlot` once ready.
+ */
+
+#ifndef GENERATION_H
+#define GENERATION_H
+
+#include <glib.h>
+#include <core/dataset.h>
+#include <queries/queries.h>
+
+/**
+ * @typedef Generation
+ * @brief Opaque handle to an immutable Dataset + QueryManager pair.
+ */
+typedef struct generation Generation;
+
+/**
+ * @typedef GenerationSlot
+ * @brief Opaque holder of the *current* generation, safe to share across threads.
+ */
+typedef struct generation_slot GenerationSlot;
+
+/**
+ * @typedef GenerationBuild
+ * @brief Opaque handle to a generation being built on a background thread.
+ */
+typedef struct generation_build GenerationBuild;
+
+// --- Generations ---
+
+/**
+ * @brief Wraps a loaded dataset into a new generation.
+ *
+ * Creates the `QueryManager` for @p ds; its query contexts are built lazily, by
+ * `query_manager_prepare()` or the first command of each query. The generation
+ * takes ownership of the dataset, which is destroyed along with it.
+ *
+ * @param ds A fully loaded dataset. Ownership is transferred.
+ * @return A new generation with a reference count of 1, or NULL if @p ds is NULL.
+ */
+Generation *generation_new(Dataset *ds);
+
+/**
+ * @brief Acquires an additional reference to a generation.
+ * @return @p gen itself, for convenience.
+ */
+Generation *generation_ref(Generation *gen);
+
+/**
+ * @brief Releases a reference. The last release destroys the QueryManager and the Dataset.
+ * @param gen The generation (NULL is ignored).
+ */
+void generation_unref(Generation *gen);
+
+/**
+ * @brief Returns the dataset of a generation (owned by the generation).
+ */
+Dataset *generation_get_dataset(const Generation *gen);
+
+/**
+ * @brief Returns the query manager of a generation (owned by the generation).
+ */
+QueryManager *generation_get_manager(const Generation *gen);
+
+/**
+ * @brief Returns the sequence number of a generation (1 for the first one created).
+ */
+guint generation_get_id(const Generation *gen);
+
+// --- Slot (current generation) ---
+
+/**
+ * @brief Creates a slot holding @p initial as the current generation.
+ *
+ * @param initial The first generation (may be NULL). The slot takes over the caller's reference.
+ * @return A new slot. Free it with `generation_slot_free()`.
+ */
+GenerationSlot *generation_slot_new(Generation *initial);
+
+/**
+ * @brief Acquires a reference to the current generation.
+ *
+ * The returned generation stays valid, even if another one is published in the
+ * meantime, until it is passed to `generation_unref()`.
+ *
+ * @return A new reference to the current generation, or NULL if the slot is empty.
+ */
+Generation *generation_slot_acquire(GenerationSlot *slot);
+
+/**
+ * @brief Atomically replaces the current generation.
+ *
+ * The slot's reference to the previous generation is dropped: it is freed now if
+ * no query holds it, or when the last in-flight query releases it.
+ *
+ * @param slot The slot.
+ * @param gen  The new generation. The slot takes over the caller's reference.
+ */
+void generation_slot_publish(GenerationSlot *slot, Generation *gen);
+
+/**
+ * @brief Releases the slot and its reference to the current generation.
+ */
+void generation_slot_free(GenerationSlot *slot);
+
+// --- Background Builds ---
+
+/**
+ * @brief Starts loading a dataset and building its query contexts on a background thread.
+ *
+ * All query contexts are prepared before the build completes, so the generation
+ * is ready to answer as soon as it is published.
+ *
+ * @param dataset_path Directory containing the CSV files (copied).
+ * @return A handle to poll with `generation_build_is_done()` and to complete with
+ * `generation_build_finish()`.
+ */
+GenerationBuild *generation_build_start(const char *dataset_path);
+
+/**
+ * @brief Checks, without blocking, whether a background build has completed.
+ */
+gboolean generation_build_is_done(GenerationBuild *build);
+
+/**
+ * @brief Waits for a background build and releases the handle.
+ *
+ * A build fails only when a CSV file could not be read at all (see
+ * `loadAllDatasets()`), e.g. for a wrong path. A dataset with invalid lines
+ * still makes a generation, as it does at startup; @p errors reports them.
+ *
+ * @param build  The build handle (freed by this call).
+ * @param errors [out] Optional. Receives the loader error flag (invalid lines were skipped).
+ * @return The new generation (reference owned by the caller), or NULL if loading failed.
+ */
+Generation *generation_build_finish(GenerationBuild *build, gint *errors);
+
+/**
+ * @brief Returns the dataset path a build was started with (owned by the handle).
+ */
+const char *generation_build_get_path(const GenerationBuild *build);
+
+#endif // GENERATION_H
@@ -2,8 +2,15 @@
 #define QUERIES_H
 
 #include <core/dataset.h>
+#include <queries/query_module.h>
+#include <io/output_writer.h>
 #include <stdio.h>
 
+/**
+ * @brief Number of registered query modules.
+ */
+#define QUERY_MODULE_COUNT 7
+
 /**
  * @brief Opaque handle for the Query Manager.
  * Defines the type so it can be used in queries.c.
@@ -12,13 +19,90 @@ typedef struct QueryManager QueryManager;
 
 /**
  * @brief Callback for performance monitoring (stats).
+ *
+ * @p cached is TRUE when the command was answered from the result cache, so
+ * @p elapsed does not reflect the cost of the query itself.
+ */
+typedef void (*QueryStatsCallback)(int queryNum, int lineNum, double elapsed, gboolean cached, void *ctx);
+
+/**
+ * @brief Builds the contexts of the given queries ahead of their first command.
+ *
+ * A query manager builds the context of a query module on the first command
+ * of that query; this function builds several ones concurrently instead.
+ * Modules not listed are left untouched, and repeated or unknown ids are ignored.
+ *
+ * @param qm       The query manager.
+ * @param queryIds The query numbers about to be used (e.g., those of a commands file).
+ * @param count    Number of entries in @p queryIds.
+ */
+void query_manager_prepare(QueryManager *qm, const int *queryIds, guint count);
+
+/**
+ * @brief Drops every result cached by a query manager.
+ *
+ * The manager keeps the rendered output of recent commands, keyed by query,
+ * variant and arguments, and answers repeated commands from it. The cache is
+ * also dropped when the manager is used with a different dataset; call this
+ * function if the dataset it was built for is modified in place.
+ */
+void query_manager_cache_clear(QueryManager *qm);
+
+/**
+ * @brief Reads the result cache counters of a query manager.
+ *
+ * Per command, the same information reaches the `QueryStatsCallback` of a run.
+ *
+ * @param qm     The query manager.
+ * @param hits   [out] Optional. Commands answered from the cache.
+ * @param misses [out] Optional. Commands that had to be computed.
  */
-typedef void (*QueryStatsCallback)(int queryNum, int lineNum, double elapsed, void *ctx);
+void query_manager_cache_stats(QueryManager *qm, guint64 *hits, guint64 *misses);
+
+/**
+ * @brief A command line, split into query number, variant and arguments.
+ *
+ * The arguments point into the parsed line, which must outlive the command.
+ */
+typedef struct
+{
+    int queryNumber;
+    int isSpecial; /**< 1 for the 'S' variant (e.g., "1S LIS"). */
+    char *arg1;    /**< First argument, or NULL. */
+    char *arg2;    /**< Second argument (queries 2, 3 and 4 only), or NULL. */
+} QueryCommand;
+
+/**
+ * @brief Fills @p mods with every registered query module, in query order.
+ */
+void query_modules_collect(QueryModule mods[QUERY_MODULE_COUNT]);
+
+/**
+ * @brief Parses one line of the commands file.
+ *
+ * The line is modified in place (line terminator removed, arguments split).
+ *
+ * @param line The line read from the commands file.
+ * @param cmd  [out] The parsed command.
+ * @return 1 if a command was parsed, 0 if the line holds no command (it still
+ * takes a command number), -1 if the line is empty (it takes none).
+ */
+int query_command_parse(char *line, QueryCommand *cmd);
 
 /**
  * @brief Executes all queries listed in the commands file.
+ *
+ * Results go to one file per command in "resultados".
  */
 void runAllQueries(Dataset *ds, const char *filePath,
                    QueryStatsCallback callback, void *ctx);
 
+/**
+ * @brief Executes all queries listed in the commands file, writing the results through @p writer.
+ *
+ * Every result has been written out by the time the callbacks fire.
+ */
+void runAllQueriesWith(Dataset *ds, const char *filePath, OutputWriter *writer,
+                       QueryStatsCallback callback, void *ctx);
+
 #endif // QUERIES_H
\ No newline at end of file
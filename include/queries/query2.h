@@ -10,8 +10,18 @@
  * flight frequency. To answer this efficiently (O(N log N) or better per query):
  * 1. **Pre-Calculation Phase (Init):** We iterate the entire dataset once to count
  * flights per aircraft, storing the results in a direct-mapped array (`flightCounts`).
- * 2. **Query Phase (Run):** We filter the aircraft list (if a model argument is provided),
- * create a temporary list of candidates, sort them by flight count, and return the top N.
+ * The aircraft with flights are then ranked once: globally, and per manufacturer
+ * (a hash of manufacturer -> slice of a second index array).
+ * 2. **Query Phase (Run):** The answer is the first N entries of the global ranking,
+ * or of the manufacturer's one, written straight to the output (O(N), no allocations).
+ * `query2()` keeps the heap-based selection for callers that hold no module context.
+ *
+ * @section q2_window Date Windows
+ * Two dates after the optional manufacturer ("2 10 Airbus 2023-01-01 2023-06-30")
+ * rank the aircraft by the flights that actually departed within that window.
+ * Init also keeps the sorted departure times of every aircraft, so its count in
+ * a window is two binary searches; the all-time ranking is walked in order and
+ * the walk stops as soon as an all-time count cannot reach the current top N.
  */
 
 #ifndef QUERY2_H
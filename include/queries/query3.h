@@ -12,8 +12,18 @@
  * 1. **Pre-Calculation (Init):** We map every airport to a **Fenwick Tree (Binary Indexed Tree)**.
  * The tree indexes time (dates), allowing us to calculate the cumulative delay rating
  * between any two dates in logarithmic time.
- * 2. **Query Phase (Run):** For a given date range [A, B], we query the Fenwick Tree
- * of every airport to find the range sum. We compare these sums to find the maximum.
+ * 2. **Range Backend (Init):** The counts of the trees are laid out on one day axis (the
+ * days with departures from any airport). Normally this is a dense prefix matrix, one
+ * contiguous int32 row per day and a column per airport. When days x airports grows
+ * too large, it falls back to block leaders instead: the days are split into blocks,
+ * and for every run of whole blocks we store the airport with the most departures in
+ * it (smallest code on ties).
+ * 3. **Query Phase (Run):** For a given date range [A, B], the dense backend finds the two
+ * rows by binary search, then subtracts one from the other across all airports and takes
+ * the first maximum (airports are in code order). The sparse backend only considers the
+ * leader of the whole blocks inside the range and the airports with departures on the
+ * days left over at its ends, whose Fenwick Trees give their exact counts. `query3()`
+ * still compares the range sums of every airport, for callers without the module context.
  */
 
 #ifndef QUERY3_H
@@ -5,8 +5,8 @@
  * This module identifies the top N airlines with the highest average flight delays.
  *
  * @section q5_algo Algorithm Overview
- * 1. **Pre-Calculation (Init):** The module iterates over all flights to compute the
- * accumulated delay for each airline. It filters only "Delayed" flights.
+ * 1. **Pre-Calculation (Init):** For each airline, the module intersects its flight
+ * bitmap with the "Delayed" status bitmap and accumulates the delay of those flights.
  * 2. **Metric:** The metric used is the average delay (Total Delay / Count), rounded to
  * 3 decimal places.
  * 3. **Query Phase (Run):** The pre-calculated list is sorted by this average delay
@@ -26,10 +26,10 @@
 /**
  * @brief Computes aggregated delay statistics for all airlines.
  *
- * @param flightsArray A GPtrArray containing Flight* pointers.
+ * @param ds The dataset (read-only).
  * @return A GList* of internal AirlineDelayPrepared structures.
  */
-GList *prepareAirlineDelays(GPtrArray *flightsArray);
+GList *prepareAirlineDelays(const Dataset *ds);
 
 /**
  * @brief Executes Query 5.
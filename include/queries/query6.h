@@ -9,7 +9,9 @@
  * 1. **Pre-Calculation (Init):** We iterate through all reservations. For each reservation,
  * we resolve the Passenger's nationality and the flight's destination.
  * 2. **Storage:** We build a nested Hash Table structure:
- * `Nationality -> { DestinationAirport -> Count }`
+ * `Nationality -> { DestinationAirport -> Count }`. The workers share the outer
+ * map (a `ConcurrentMap`, sealed into a `LookupTable` once built) and lock a
+ * nationality only while adding to its histogram.
  * 3. **Query Phase (Run):** When a nationality is requested, we look up its airport histogram
  * and iterate to find the airport with the maximum count.
  */
@@ -18,6 +20,7 @@
 #define QUERY6_H
 
 #include <core/dataset.h>
+#include <core/lookup_table.h>
 #include <glib.h>
 #include <stdio.h>
 #include "queries/query_module.h"
@@ -27,21 +30,22 @@
  * @brief Initializes the data structure for Nationality analysis.
  *
  * @param ds The dataset.
- * @return A GHashTable mapping Nationality (string) -> internal NationalityData struct.
+ * @return A LookupTable mapping Nationality (string) -> internal NationalityData struct.
+ * Free it with `lookup_table_free()`.
  */
-GHashTable *prepareNationalityData(const Dataset *ds);
+LookupTable *prepareNationalityData(const Dataset *ds);
 
 /**
  * @brief Executes Query 6.
  * Finds the most visited airport for the given nationality.
  *
- * @param natTable    The pre-calculated hash table.
+ * @param natTable    The pre-calculated lookup table.
  * @param nationality The nationality to query (e.g., "PORTUGAL").
  * @param output      The output file stream.
  * @param isSpecial   Flag for 'S' variant (separator formatting).
  * @return 1 if a result was found and printed, 0 otherwise.
  */
-int query_Q6(GHashTable *natTable, const char *nationality, FILE *output, int isSpecial);
+int query_Q6(const LookupTable *natTable, const char *nationality, FILE *output, int isSpecial);
 
 /**
  * @brief Factory function to retrieve the Module definition for Query 6.
@@ -0,0 +1,47 @@
+/**
+ * @file query7.h
+ * @brief Logic for Query 7: Passenger Itinerary.
+ *
+ * This module lists every booking of a given passenger, with the flights of each
+ * booking, their schedule and the amount spent.
+ *
+ * @section q7_algo Algorithm Overview
+ * 1. **Lookup:** The passenger's reservations are fetched from the Dataset's
+ * passenger -> reservations reverse index, which already returns them in
+ * chronological order (by the scheduled departure of their first flight).
+ * 2. **Query Phase (Run):** Each reservation's flights are resolved by ID. The cost
+ * is proportional to the passenger's own bookings, never to the dataset size.
+ *
+ * @section q7_output Output Format
+ * - A header line: `document;first name;last name;reservations;total spent`.
+ * - One line per flight leg, in itinerary order:
+ *   `reservation;flight;origin;destination;departure;arrival;status;price`,
+ *   where `price` is the price of the whole reservation the leg belongs to.
+ * - An empty line if the passenger does not exist.
+ */
+
+#ifndef QUERY7_H
+#define QUERY7_H
+
+#include <core/dataset.h>
+#include <stdio.h>
+#include "queries/query_module.h"
+
+/**
+ * @brief Executes Query 7.
+ * Prints the full itinerary of a passenger.
+ *
+ * @param ds         The dataset.
+ * @param documentNo The passenger's document number.
+ * @param output     The output file stream.
+ * @param isSpecial  Flag for 'S' variant (separator formatting).
+ * @return 1 if the passenger exists and was printed, 0 otherwise.
+ */
+int query7(const Dataset *ds, int documentNo, FILE *output, int isSpecial);
+
+/**
+ * @brief Factory function to retrieve the Module definition for Query 7.
+ */
+QueryModule get_query7_module(void);
+
+#endif // QUERY7_H
@@ -16,6 +16,7 @@
 #define QUERY_MODULE_H
 
 #include <core/dataset.h>
+#include <glib.h>
 #include <stdio.h>
 
 /**
@@ -64,6 +65,53 @@ typedef void (*QueryRunFunc)(void *ctx, Dataset *ds, char *arg1, char *arg2, int
  */
 typedef void (*QueryDestroyFunc)(void *ctx);
 
+/**
+ * @typedef QueryMergeFunc
+ * @brief Function pointer signature for merging sharded results.
+ *
+ * When the dataset is partitioned across worker processes (see `sharding.h`),
+ * every shard runs the module's `partial` function (a `QueryRunFunc`) on its
+ * own slice of the data and sends back a partial result: tab-separated text
+ * lines whose meaning is private to the module. The coordinator hands the
+ * partials of all shards to this function, which writes the final answer,
+ * byte for byte what `run` writes on the whole dataset.
+ *
+ * @param partials  The partial result of each shard (never NULL; may be empty).
+ * @param count     Number of shards.
+ * @param arg1      The first argument of the command (may be NULL).
+ * @param arg2      The second argument of the command (may be NULL).
+ * @param isSpecial The 'S' variant flag.
+ * @param output    The file stream where the final result must be written.
+ */
+typedef void (*QueryMergeFunc)(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                               FILE *output);
+
+/**
+ * @typedef QueryShardExportFunc
+ * @brief Function pointer signature for exporting the shards' precomputed data.
+ *
+ * Some answers cannot be rebuilt from a slice of the rows (e.g., a ranking over
+ * all the reservations of a week). Such a module computes, on the coordinator
+ * and over the whole dataset, the part of its context each shard will own.
+ *
+ * @param ds       The whole dataset (only read).
+ * @param payloads [out] Receives one payload per shard, handed to `QueryShardInitFunc` in that shard.
+ * @param nShards  Number of shards.
+ */
+typedef void (*QueryShardExportFunc)(const Dataset *ds, GBytes **payloads, guint nShards);
+
+/**
+ * @typedef QueryShardInitFunc
+ * @brief Function pointer signature for initializing a module inside a shard.
+ *
+ * Replaces `init` in the shards when the module exports per-shard payloads.
+ *
+ * @param ds      The shard's dataset.
+ * @param payload The bytes exported by `QueryShardExportFunc` for this shard.
+ * @return The module's private context (see `QueryInitFunc`).
+ */
+typedef void *(*QueryShardInitFunc)(Dataset *ds, GBytes *payload);
+
 /**
  * @struct QueryModule
  * @brief Represents a self-contained Query Plugin.
@@ -97,6 +145,29 @@ typedef struct
      * Can be NULL if `init` was NULL or if no dynamic memory is held in the context.
      */
     QueryDestroyFunc destroy;
+
+    /**
+     * @brief Pointer to the per-shard execution logic, for sharded runs.
+     * Can be NULL together with `merge` if the query cannot be sharded.
+     */
+    QueryRunFunc partial;
+
+    /**
+     * @brief Pointer to the logic combining the shards' partial results.
+     */
+    QueryMergeFunc merge;
+
+    /**
+     * @brief Pointer to the payload export, run on the coordinator.
+     * Can be NULL: the shards then call `init` on their own slice.
+     */
+    QueryShardExportFunc shard_export;
+
+    /**
+     * @brief Pointer to the shard-side initialization from an exported payload.
+     * Must be set when `shard_export` is.
+     */
+    QueryShardInitFunc shard_init;
 } QueryModule;
 
 #endif // QUERY_MODULE_H
\ No newline at end of file
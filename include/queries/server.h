@@ -0,0 +1,68 @@
+/**
+ * @file server.h
+ * @brief Long-running query server over a Unix domain socket, and its client.
+ *
+ * A batch run pays for loading the dataset and building the query contexts
+ * every time. In server mode, the process does that once and then answers
+ * commands from any number of local clients:
+ * - Clients send lines in the format of the commands file (e.g., "1S LIS").
+ * Only lines holding a command are expected, but any line gets an answer.
+ * - Every line is executed on a shared thread pool, against the read-only
+ * query contexts (see `queries.h`), so one client's commands run concurrently
+ * with each other and with other clients' ones. Replies therefore come back
+ * in completion order, each tagged with the position of its line in the
+ * client's stream (`QueryReplyHeader`, then the result bytes).
+ * - The client reads a commands file, sends its commands and writes each
+ * reply to the usual `resultados` file, numbered as `runAllQueries()` does.
+ *
+ * The server stops on SIGINT or SIGTERM: it stops reading from the clients,
+ * answers the commands already received, then exits.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <glib.h>
+#include "core/dataset.h"
+#include "io/output_writer.h"
+#include "queries/queries.h"
+
+/**
+ * @brief Header of one reply, in host byte order; `length` result bytes follow.
+ */
+typedef struct
+{
+    guint32 sequence; /**< Position of the answered line in the client's stream, from 0. */
+    gint32 status;    /**< As `query_command_parse()`: 1 for a command, 0 or -1 otherwise (no bytes follow). */
+    guint32 length;   /**< Size of the result. */
+    guint32 cached;   /**< 1 if the result came from the server's result cache. */
+} QueryReplyHeader;
+
+/**
+ * @brief Serves commands on a Unix domain socket until SIGINT or SIGTERM.
+ *
+ * The socket file is created (a stale one is replaced) and removed on exit.
+ *
+ * @param ds          The loaded dataset (only read).
+ * @param socketPath  Path of the socket file (e.g., "/tmp/flights.sock").
+ * @return TRUE on a clean shutdown, FALSE if the socket could not be set up.
+ */
+gboolean query_server_run(Dataset *ds, const char *socketPath);
+
+/**
+ * @brief Sends the commands of a file to a server and writes the results.
+ *
+ * Same results and callbacks as `runAllQueriesWith()`; the elapsed time is
+ * measured from the moment the command is sent.
+ *
+ * @param socketPath Path of the server's socket file.
+ * @param filePath   The commands file.
+ * @param writer     Where the results go.
+ * @param callback   Optional statistics callback.
+ * @param ctx        Passed to @p callback.
+ * @return TRUE if every command was answered.
+ */
+gboolean query_client_run(const char *socketPath, const char *filePath, OutputWriter *writer,
+                          QueryStatsCallback callback, void *ctx);
+
+#endif // SERVER_H
@@ -0,0 +1,76 @@
+/**
+ * @file sharding.h
+ * @brief Sharded, multi-process query execution, partitioned by airport.
+ *
+ * A single process keeps every index of the whole dataset in its own memory.
+ * The sharded mode splits the data across worker processes instead:
+ * - Flights are partitioned by origin airport (a hash of the code), and every
+ * reservation goes to the shards owning at least one of its flights.
+ * Passengers, airports, aircrafts and dictionaries are small and replicated.
+ * - The coordinator parses and validates the CSV files once, as usual, then
+ * sends each worker the image of its slice (see `dataset_image.h`) over a
+ * socket. Workers attach it and build the query contexts of their slice only.
+ * - Every command is sent to all the workers; each one runs the module's
+ * `partial` function and the coordinator combines the replies with the
+ * module's `merge` function (see `query_module.h`). The output files are
+ * byte-identical to those of `runAllQueries()`.
+ *
+ * Workers are forked before the coordinator loads anything, so they start
+ * from a small process with no threads.
+ */
+
+#ifndef SHARDING_H
+#define SHARDING_H
+
+#include <glib.h>
+#include "core/dataset.h"
+#include "queries/queries.h"
+
+/**
+ * @typedef ShardPool
+ * @brief Opaque handle for the coordinator's set of worker processes.
+ */
+typedef struct shard_pool ShardPool;
+
+/**
+ * @brief Forks the worker processes.
+ *
+ * Must be called before any thread is started. In the workers, this function
+ * never returns: they serve commands until the pool is freed, then exit.
+ *
+ * @param nShards Number of workers (at least 1).
+ * @return The pool, or NULL if the workers could not be started.
+ */
+ShardPool *shard_pool_spawn(guint nShards);
+
+/**
+ * @brief Partitions a loaded dataset and sends each worker its slice.
+ *
+ * Once this returns, the coordinator no longer needs @p ds and may free it.
+ *
+ * @param pool The pool.
+ * @param ds   The whole dataset (only read).
+ * @return TRUE if every worker received its slice.
+ */
+gboolean shard_pool_distribute(ShardPool *pool, const Dataset *ds);
+
+/**
+ * @brief Executes all queries listed in the commands file on the workers.
+ *
+ * Same results and callbacks as `runAllQueriesWith()`; the workers keep no
+ * result cache, so `cached` is always FALSE. A command missing the answer of a
+ * worker (e.g., one that crashed) would be wrong: the run stops there instead,
+ * and neither that command nor the following ones get a result.
+ *
+ * @return TRUE if every command was answered.
+ */
+gboolean runShardedQueries(ShardPool *pool, const char *filePath, OutputWriter *writer,
+                           QueryStatsCallback callback, void *ctx);
+
+/**
+ * @brief Stops the workers, waits for them to exit and frees the pool.
+ * @param pool The pool. If NULL, does nothing.
+ */
+void shard_pool_free(ShardPool *pool);
+
+#endif // SHARDING_H
@@ -28,11 +28,14 @@ void stats_add_result(TestStats *stats, int query_type, int command_number, int
 /**
  * @brief Records the execution time of a query type.
  *
+ * Commands answered from the result cache are counted, but left out of the runtime.
+ *
  * @param stats Pointer to the TestStats.
  * @param query_type The type/number of the query.
  * @param time_seconds Execution time in seconds.
+ * @param cached TRUE if the command was answered from the result cache.
  */
-void stats_add_timing(TestStats *stats, int query_type, double time_seconds);
+void stats_add_timing(TestStats *stats, int query_type, double time_seconds, gboolean cached);
 
 /**
  * @brief Prints a detailed statistics report.
@@ -0,0 +1,552 @@
+#include "core/bitmap.h"
+#include <glib.h>
+#include <string.h>
+
+#define ARRAY_MAX 4096    // Largest array container; denser chunks become bitsets
+#define BITSET_WORDS 1024 // 65536 bits
+
+typedef struct
+{
+  guint16 key;         // High 16 bits of the rows in this chunk
+  guint32 cardinality;
+  guint16 *array;      // Sorted low halves (when words is NULL)
+  guint32 capacity;    // Allocated length of array
+  guint64 *words;      // Bitset (when not NULL)
+} Container;
+
+struct bitmap
+{
+  Container *containers; // Sorted by key
+  guint count;
+  guint capacity;
+  gint64 last;           // Last appended row, -1 if none
+};
+
+// --- Containers ---
+
+static void container_clear(Container *c)
+{
+  g_free(c->array);
+  g_free(c->words);
+  c->array = NULL;
+  c->words = NULL;
+  c->cardinality = 0;
+  c->capacity = 0;
+}
+
+static gboolean container_contains(const Container *c, guint16 low)
+{
+  if (c->words)
+    return (c->words[low >> 6] >> (low & 63)) & 1;
+
+  guint32 lo = 0, hi = c->cardinality;
+  while (lo < hi)
+  {
+    guint32 mid = lo + (hi - lo) / 2;
+    if (c->array[mid] < low)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < c->cardinality && c->array[lo] == low;
+}
+
+static guint64 *words_from_array(const guint16 *array, guint32 n)
+{
+  guint64 *words = g_new0(guint64, BITSET_WORDS);
+  for (guint32 i = 0; i < n; i++)
+    words[array[i] >> 6] |= (guint64)1 << (array[i] & 63);
+  return words;
+}
+
+static guint64 *words_copy(const Container *c)
+{
+  if (c->words)
+    return g_memdup2(c->words, BITSET_WORDS * sizeof(guint64));
+  return words_from_array(c->array, c->cardinality);
+}
+
+static guint32 words_popcount(const guint64 *words)
+{
+  guint32 total = 0;
+  for (int w = 0; w < BITSET_WORDS; w++)
+    total += (guint32)__builtin_popcountll(words[w]);
+  return total;
+}
+
+static void container_to_bitset(Container *c)
+{
+  guint64 *words = words_from_array(c->array, c->cardinality);
+  g_free(c->array);
+  c->array = NULL;
+  c->capacity = 0;
+  c->words = words;
+}
+
+static void container_copy(Container *dst, const Container *src)
+{
+  *dst = *src;
+  if (src->words)
+  {
+    dst->words = g_memdup2(src->words, BITSET_WORDS * sizeof(guint64));
+  }
+  else
+  {
+    dst->array = g_memdup2(src->array, src->cardinality * sizeof(guint16));
+    dst->capacity = src->cardinality;
+  }
+}
+
+// --- Building ---
+
+static Container *bitmap_push(Bitmap *bm, guint16 key)
+{
+  if (bm->count == bm->capacity)
+  {
+    bm->capacity = bm->capacity ? bm->capacity * 2 : 4;
+    bm->containers = g_renew(Container, bm->containers, bm->capacity);
+  }
+  Container *c = &bm->containers[bm->count++];
+  memset(c, 0, sizeof(*c));
+  c->key = key;
+  return c;
+}
+
+// Takes ownership of array (n entries); empty results are dropped
+static void push_array(Bitmap *out, guint16 key, guint16 *array, guint32 n)
+{
+  if (n == 0)
+  {
+    g_free(array);
+    return;
+  }
+  Container *c = bitmap_push(out, key);
+  c->array = array;
+  c->cardinality = n;
+  c->capacity = n;
+}
+
+// Takes ownership of words; sparse results are turned back into arrays
+static void push_words(Bitmap *out, guint16 key, guint64 *words)
+{
+  guint32 n = words_popcount(words);
+  if (n == 0)
+  {
+    g_free(words);
+    return;
+  }
+  Container *c = bitmap_push(out, key);
+  c->cardinality = n;
+  if (n > ARRAY_MAX)
+  {
+    c->words = words;
+    return;
+  }
+
+  c->array = g_new(guint16, n);
+  c->capacity = n;
+  guint32 k = 0;
+  for (guint32 w = 0; w < BITSET_WORDS; w++)
+  {
+    guint64 bits = words[w];
+    while (bits)
+    {
+      c->array[k++] = (guint16)(w * 64 + (guint32)__builtin_ctzll(bits));
+      bits &= bits - 1;
+    }
+  }
+  g_free(words);
+}
+
+Bitmap *bitmap_new(void)
+{
+  Bitmap *bm = g_new0(Bitmap, 1);
+  bm->last = -1;
+  return bm;
+}
+
+void bitmap_free(Bitmap *bm)
+{
+  if (!bm)
+    return;
+  for (guint i = 0; i < bm->count; i++)
+    container_clear(&bm->containers[i]);
+  g_free(bm->containers);
+  g_free(bm);
+}
+
+void bitmap_append(Bitmap *bm, guint32 row)
+{
+  if (!bm || (gint64)row <= bm->last)
+    return;
+  bm->last = row;
+
+  guint16 key = (guint16)(row >> 16);
+  guint16 low = (guint16)(row & 0xFFFF);
+
+  Container *c = (bm->count > 0 && bm->containers[bm->count - 1].key == key)
+                     ? &bm->containers[bm->count - 1]
+                     : bitmap_push(bm, key);
+
+  if (!c->words && c->cardinality == ARRAY_MAX)
+    container_to_bitset(c);
+
+  if (c->words)
+  {
+    c->words[low >> 6] |= (guint64)1 << (low & 63);
+  }
+  else
+  {
+    if (c->cardinality == c->capacity)
+    {
+      c->capacity = c->capacity ? MIN(c->capacity * 2, ARRAY_MAX) : 4;
+      c->array = g_renew(guint16, c->array, c->capacity);
+    }
+    c->array[c->cardinality] = low;
+  }
+  c->cardinality++;
+}
+
+// --- Queries ---
+
+static const Container *find_container(const Bitmap *bm, guint16 key)
+{
+  guint lo = 0, hi = bm->count;
+  while (lo < hi)
+  {
+    guint mid = lo + (hi - lo) / 2;
+    if (bm->containers[mid].key < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (lo < bm->count && bm->containers[lo].key == key) ? &bm->containers[lo] : NULL;
+}
+
+gboolean bitmap_contains(const Bitmap *bm, guint32 row)
+{
+  if (!bm)
+    return FALSE;
+  const Container *c = find_container(bm, (guint16)(row >> 16));
+  return c && container_contains(c, (guint16)(row & 0xFFFF));
+}
+
+guint64 bitmap_cardinality(const Bitmap *bm)
+{
+  if (!bm)
+    return 0;
+  guint64 total = 0;
+  for (guint i = 0; i < bm->count; i++)
+    total += bm->containers[i].cardinality;
+  return total;
+}
+
+// --- Set Operations ---
+
+static guint32 intersect_count(const Container *a, const Container *b)
+{
+  if (a->words && b->words)
+  {
+    guint32 n = 0;
+    for (int w = 0; w < BITSET_WORDS; w++)
+      n += (guint32)__builtin_popcountll(a->words[w] & b->words[w]);
+    return n;
+  }
+  if (a->words || b->words)
+  {
+    const Container *arr = a->words ? b : a;
+    const Container *set = a->words ? a : b;
+    guint32 n = 0;
+    for (guint32 i = 0; i < arr->cardinality; i++)
+      n += container_contains(set, arr->array[i]);
+    return n;
+  }
+
+  guint32 i = 0, j = 0, n = 0;
+  while (i < a->cardinality && j < b->cardinality)
+  {
+    if (a->array[i] < b->array[j])
+      i++;
+    else if (a->array[i] > b->array[j])
+      j++;
+    else
+    {
+      n++;
+      i++;
+      j++;
+    }
+  }
+  return n;
+}
+
+static void intersect_into(Bitmap *out, const Container *a, const Container *b)
+{
+  if (a->words && b->words)
+  {
+    guint64 *words = g_new(guint64, BITSET_WORDS);
+    for (int w = 0; w < BITSET_WORDS; w++)
+      words[w] = a->words[w] & b->words[w];
+    push_words(out, a->key, words);
+    return;
+  }
+
+  // At least one side is an array: the result is never larger than it
+  const Container *arr = (!a->words && (b->words || a->cardinality <= b->cardinality)) ? a : b;
+  const Container *other = arr == a ? b : a;
+  guint16 *result = g_new(guint16, arr->cardinality);
+  guint32 n = 0;
+
+  if (other->words)
+  {
+    for (guint32 i = 0; i < arr->cardinality; i++)
+    {
+      if (container_contains(other, arr->array[i]))
+        result[n++] = arr->array[i];
+    }
+  }
+  else
+  {
+    guint32 i = 0, j = 0;
+    while (i < arr->cardinality && j < other->cardinality)
+    {
+      if (arr->array[i] < other->array[j])
+        i++;
+      else if (arr->array[i] > other->array[j])
+        j++;
+      else
+      {
+        result[n++] = arr->array[i];
+        i++;
+        j++;
+      }
+    }
+  }
+  push_array(out, a->key, result, n);
+}
+
+static void union_into(Bitmap *out, const Container *a, const Container *b)
+{
+  if (a->words || b->words || a->cardinality + b->cardinality > ARRAY_MAX)
+  {
+    guint64 *words = words_copy(a);
+    if (b->words)
+    {
+      for (int w = 0; w < BITSET_WORDS; w++)
+        words[w] |= b->words[w];
+    }
+    else
+    {
+      for (guint32 i = 0; i < b->cardinality; i++)
+        words[b->array[i] >> 6] |= (guint64)1 << (b->array[i] & 63);
+    }
+    push_words(out, a->key, words);
+    return;
+  }
+
+  guint16 *result = g_new(guint16, a->cardinality + b->cardinality);
+  guint32 i = 0, j = 0, n = 0;
+  while (i < a->cardinality || j < b->cardinality)
+  {
+    if (j >= b->cardinality || (i < a->cardinality && a->array[i] < b->array[j]))
+      result[n++] = a->array[i++];
+    else if (i >= a->cardinality || b->array[j] < a->array[i])
+      result[n++] = b->array[j++];
+    else
+    {
+      result[n++] = a->array[i];
+      i++;
+      j++;
+    }
+  }
+  push_array(out, a->key, result, n);
+}
+
+static void difference_into(Bitmap *out, const Container *a, const Container *b)
+{
+  if (a->words)
+  {
+    guint64 *words = words_copy(a);
+    if (b->words)
+    {
+      for (int w = 0; w < BITSET_WORDS; w++)
+        words[w] &= ~b->words[w];
+    }
+    else
+    {
+      for (guint32 i = 0; i < b->cardinality; i++)
+        words[b->array[i] >> 6] &= ~((guint64)1 << (b->array[i] & 63));
+    }
+    push_words(out, a->key, words);
+    return;
+  }
+
+  guint16 *result = g_new(guint16, a->cardinality);
+  guint32 n = 0;
+  for (guint32 i = 0; i < a->cardinality; i++)
+  {
+    if (!container_contains(b, a->array[i]))
+      result[n++] = a->array[i];
+  }
+  push_array(out, a->key, result, n);
+}
+
+static void copy_into(Bitmap *out, const Container *c)
+{
+  Container *dst = bitmap_push(out, c->key);
+  container_copy(dst, c);
+}
+
+Bitmap *bitmap_and(const Bitmap *a, const Bitmap *b)
+{
+  Bitmap *out = bitmap_new();
+  if (!a || !b)
+    return out;
+
+  guint i = 0, j = 0;
+  while (i < a->count && j < b->count)
+  {
+    const Container *ca = &a->containers[i];
+    const Container *cb = &b->containers[j];
+    if (ca->key < cb->key)
+      i++;
+    else if (ca->key > cb->key)
+      j++;
+    else
+    {
+      intersect_into(out, ca, cb);
+      i++;
+      j++;
+    }
+  }
+  return out;
+}
+
+Bitmap *bitmap_or(const Bitmap *a, const Bitmap *b)
+{
+  Bitmap *out = bitmap_new();
+  guint na = a ? a->count : 0;
+  guint nb = b ? b->count : 0;
+
+  guint i = 0, j = 0;
+  while (i < na || j < nb)
+  {
+    if (j >= nb || (i < na && a->containers[i].key < b->containers[j].key))
+      copy_into(out, &a->containers[i++]);
+    else if (i >= na || b->containers[j].key < a->containers[i].key)
+      copy_into(out, &b->containers[j++]);
+    else
+    {
+      union_into(out, &a->containers[i], &b->containers[j]);
+      i++;
+      j++;
+    }
+  }
+  return out;
+}
+
+Bitmap *bitmap_andnot(const Bitmap *a, const Bitmap *b)
+{
+  Bitmap *out = bitmap_new();
+  if (!a)
+    return out;
+  guint nb = b ? b->count : 0;
+
+  guint j = 0;
+  for (guint i = 0; i < a->count; i++)
+  {
+    const Container *ca = &a->containers[i];
+    while (j < nb && b->containers[j].key < ca->key)
+      j++;
+    if (j < nb && b->containers[j].key == ca->key)
+      difference_into(out, ca, &b->containers[j]);
+    else
+      copy_into(out, ca);
+  }
+  return out;
+}
+
+guint64 bitmap_and_cardinality(const Bitmap *a, const Bitmap *b)
+{
+  if (!a || !b)
+    return 0;
+
+  guint64 total = 0;
+  guint i = 0, j = 0;
+  while (i < a->count && j < b->count)
+  {
+    const Container *ca = &a->containers[i];
+    const Container *cb = &b->containers[j];
+    if (ca->key < cb->key)
+      i++;
+    else if (ca->key > cb->key)
+      j++;
+    else
+    {
+      total += intersect_count(ca, cb);
+      i++;
+      j++;
+    }
+  }
+  return total;
+}
+
+guint64 bitmap_andnot_cardinality(const Bitmap *a, const Bitmap *b)
+{
+  return bitmap_cardinality(a) - bitmap_and_cardinality(a, b);
+}
+
+// --- Traversal ---
+
+void bitmap_foreach(const Bitmap *bm, BitmapFunc func, gpointer user_data)
+{
+  if (!bm || !func)
+    return;
+
+  for (guint i = 0; i < bm->count; i++)
+  {
+    const Container *c = &bm->containers[i];
+    guint32 base = (guint32)c->key << 16;
+    if (c->words)
+    {
+      for (guint32 w = 0; w < BITSET_WORDS; w++)
+      {
+        guint64 bits = c->words[w];
+        while (bits)
+        {
+          func(base + w * 64 + (guint32)__builtin_ctzll(bits), user_data);
+          bits &= bits - 1;
+        }
+      }
+    }
+    else
+    {
+      for (guint32 k = 0; k < c->cardinality; k++)
+        func(base + c->array[k], user_data);
+    }
+  }
+}
+
+typedef struct
+{
+  guint32 *rows;
+  guint n;
+} RowCollector;
+
+static void collect_row(guint32 row, gpointer user_data)
+{
+  RowCollector *rc = user_data;
+  rc->rows[rc->n++] = row;
+}
+
+guint32 *bitmap_to_array(const Bitmap *bm, guint *count)
+{
+  guint64 n = bitmap_cardinality(bm);
+  if (count)
+    *count = (guint)n;
+  if (n == 0)
+    return NULL;
+
+  RowCollector rc = {g_new(guint32, n), 0};
+  bitmap_foreach(bm, collect_row, &rc);
+  return rc.rows;
+}
@@ -0,0 +1,118 @@
+#include "core/concurrent_map.h"
+#include "core/lookup_table_internal.h"
+#include <glib.h>
+
+struct concurrent_map
+{
+  LookupKeyType type;
+  LookupSlot *slots;
+  guint64 mask; // Capacity - 1 (capacity is a power of two)
+  guint maxEntries;
+  gint size;
+  GDestroyNotify keyDestroy;
+  GDestroyNotify valueDestroy;
+};
+
+// A slot's value doubles as its state: NULL (empty), CLAIMED (being written), or published
+static gchar claimedMarker;
+#define CLAIMED ((gpointer)&claimedMarker)
+
+// Waits for a claimed slot to be published (the writer only has two stores left to do)
+static gpointer published_value(LookupSlot *s)
+{
+  gpointer value;
+  while ((value = g_atomic_pointer_get(&s->value)) == CLAIMED)
+    g_thread_yield();
+  return value;
+}
+
+ConcurrentMap *concurrent_map_new(LookupKeyType type, guint max_entries,
+                                  GDestroyNotify key_destroy, GDestroyNotify value_destroy)
+{
+  ConcurrentMap *map = g_new0(ConcurrentMap, 1);
+  guint64 capacity = lookup_table_capacity_for(max_entries);
+  map->type = type;
+  map->slots = g_new0(LookupSlot, capacity);
+  map->mask = capacity - 1;
+  map->maxEntries = max_entries;
+  map->keyDestroy = key_destroy;
+  map->valueDestroy = value_destroy;
+  return map;
+}
+
+void concurrent_map_free(ConcurrentMap *map)
+{
+  if (!map)
+    return;
+  lookup_table_free(concurrent_map_seal(map));
+}
+
+gpointer concurrent_map_insert(ConcurrentMap *map, gpointer key, gpointer value)
+{
+  if (!map || !value || (map->type == LOOKUP_KEY_STRING && !key))
+    return NULL;
+
+  guint64 hash = lookup_table_hash(map->type, key);
+  guint64 i = hash & map->mask;
+  for (guint64 probes = 0; probes <= map->mask; probes++, i = (i + 1) & map->mask)
+  {
+    LookupSlot *s = &map->slots[i];
+    gpointer current = g_atomic_pointer_get(&s->value);
+
+    if (current == NULL && g_atomic_pointer_compare_and_exchange(&s->value, NULL, CLAIMED))
+    {
+      // The slot is ours: fill it, then publish the value (a full barrier)
+      s->hash = hash;
+      s->key = key;
+      g_atomic_pointer_set(&s->value, value);
+      g_atomic_int_inc(&map->size);
+      return value;
+    }
+
+    // Someone else owns the slot: compare keys once its entry is visible
+    current = published_value(s);
+    if (s->hash == hash && lookup_table_keys_equal(map->type, s->key, key))
+      return current;
+  }
+
+  // Callers size the map for every key they can insert: running out of slots is their bug
+  g_critical("%s: map sized for %u entries is full", G_STRFUNC, map->maxEntries);
+  return NULL;
+}
+
+gpointer concurrent_map_lookup(const ConcurrentMap *map, gconstpointer key)
+{
+  if (!map || (map->type == LOOKUP_KEY_STRING && !key))
+    return NULL;
+
+  guint64 hash = lookup_table_hash(map->type, key);
+  guint64 i = hash & map->mask;
+  for (guint64 probes = 0; probes <= map->mask; probes++, i = (i + 1) & map->mask)
+  {
+    LookupSlot *s = &map->slots[i];
+    gpointer current = published_value(s);
+    if (current == NULL)
+      return NULL;
+    if (s->hash == hash && lookup_table_keys_equal(map->type, s->key, key))
+      return current;
+  }
+  return NULL;
+}
+
+guint concurrent_map_size(const ConcurrentMap *map)
+{
+  return map ? (guint)g_atomic_int_get(&map->size) : 0;
+}
+
+LookupTable *concurrent_map_seal(ConcurrentMap *map)
+{
+  if (!map)
+    return NULL;
+
+  // Empty slots were never claimed, so their hash is still 0 as a LookupTable expects
+  LookupTable *table = lookup_table_adopt(map->type, map->slots, map->mask + 1,
+                                          (guint)g_atomic_int_get(&map->size),
+                                          map->keyDestroy, map->valueDestroy);
+  g_free(map);
+  return table;
+}
@@ -1,6 +1,12 @@
 #include "core/dataset.h"
 #include "core/dataset_loader.h"
 #include "core/statistics.h"
+#include "core/dataset_parallel.h"
+#include "core/radix_sort.h"
+#include "core/string_dict.h"
+#include "core/bitmap.h"
+#include "core/lookup_table.h"
+#include "core/concurrent_map.h"
 #include <glib.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +17,15 @@
 #include "entities/access/reservations_access.h"
 
 // --- Private Internal Structure ---
+
+// A permutation of the flights sorted by one timestamp column
+typedef struct
+{
+  const Flight **flights;
+  gint64 *times;
+  guint count;
+} FlightTimeOrder;
+
 struct dataset
 {
   GHashTable *flights;
@@ -19,20 +34,53 @@ struct dataset
   GHashTable *aircrafts;
   GHashTable *reservations;
   GHashTable *airportStats;
-  GPtrArray *airportCodes;
-  GPtrArray *aircraftManufacturers;
-  GPtrArray *nationalities;
+  StringDict *airportCodes;
+  StringDict *aircraftManufacturers;
+  StringDict *nationalities;
+
+  // Dense views over the lookup tables (iteration order), used by iterators and spans
+  GPtrArray *flightRows;
+  GPtrArray *passengerRows;
+  GPtrArray *aircraftRows;
+  GPtrArray *reservationRows;
+
+  // Flat copies of the primary-key tables, probed by the batch lookups
+  LookupTable *flightLookup;
+  LookupTable *passengerLookup;
+  LookupTable *reservationLookup;
+
+  // Flight groups: key value (borrowed from the Flight) -> Bitmap of flight rows
+  GHashTable *flightIndex[FLIGHT_KEY_COUNT];
+  GPtrArray *flightIndexKeys[FLIGHT_KEY_COUNT];
+  // Status string (as returned by getFlightStatus) -> Bitmap of flight rows
+  GHashTable *flightStatusIndex;
+
+  // Time-ordered flight permutations, with their sorted timestamp column. Built
+  // by the first range lookup (see time_order()), NULL until then
+  FlightTimeOrder *byDeparture;
+  FlightTimeOrder *byActualDeparture;
+
+  // Passenger -> reservations (CSR): the bookings of passenger row p are
+  // passengerReservations[passengerOffsets[p] .. passengerOffsets[p + 1])
+  GHashTable *passengerSlots;
+  guint *passengerOffsets;
+  const Reservation **passengerReservations;
+  // Memory the entities live in when the Dataset was frozen (see dataset_freeze())
+  gpointer backing;
+  GDestroyNotify backingFree;
 };
 
 // --- Iterator Structures ---
 struct dataset_iter
 {
-  GHashTableIter iter;
+  GPtrArray *rows;
+  guint index;
 };
 
 struct dataset_string_iter
 {
-  GPtrArray *array;
+  const char *const *items;
+  guint len;
   guint index;
 };
 
@@ -42,7 +90,17 @@ Dataset *initDataset()
   return ds;
 }
 
-void cleanupDataset(Dataset *ds)
+static void free_time_order(FlightTimeOrder **order)
+{
+  if (!*order)
+    return;
+  g_free((*order)->flights);
+  g_free((*order)->times);
+  g_free(*order);
+  *order = NULL;
+}
+
+void dataset_clear(Dataset *ds)
 {
   if (!ds)
     return;
@@ -60,27 +118,131 @@ void cleanupDataset(Dataset *ds)
   if (ds->airportStats)
     g_hash_table_destroy(ds->airportStats);
 
-  if (ds->airportCodes)
-    g_ptr_array_free(ds->airportCodes, TRUE);
-  if (ds->aircraftManufacturers)
-    g_ptr_array_free(ds->aircraftManufacturers, TRUE);
-  if (ds->nationalities)
-    g_ptr_array_free(ds->nationalities, TRUE);
+  string_dict_free(ds->airportCodes);
+  string_dict_free(ds->aircraftManufacturers);
+  string_dict_free(ds->nationalities);
+
+  if (ds->flightRows)
+    g_ptr_array_free(ds->flightRows, TRUE);
+  if (ds->passengerRows)
+    g_ptr_array_free(ds->passengerRows, TRUE);
+  if (ds->aircraftRows)
+    g_ptr_array_free(ds->aircraftRows, TRUE);
+  if (ds->reservationRows)
+    g_ptr_array_free(ds->reservationRows, TRUE);
 
+  lookup_table_free(ds->flightLookup);
+  lookup_table_free(ds->passengerLookup);
+  lookup_table_free(ds->reservationLookup);
+
+  for (int k = 0; k < FLIGHT_KEY_COUNT; k++)
+  {
+    if (ds->flightIndex[k])
+      g_hash_table_destroy(ds->flightIndex[k]);
+    if (ds->flightIndexKeys[k])
+      g_ptr_array_free(ds->flightIndexKeys[k], TRUE);
+  }
+  if (ds->flightStatusIndex)
+    g_hash_table_destroy(ds->flightStatusIndex);
+
+  free_time_order(&ds->byDeparture);
+  free_time_order(&ds->byActualDeparture);
+
+  if (ds->passengerSlots)
+    g_hash_table_destroy(ds->passengerSlots);
+  g_free(ds->passengerOffsets);
+  g_free(ds->passengerReservations);
+
+  // The tables above may point into the backing block: release it last
+  if (ds->backing && ds->backingFree)
+    ds->backingFree(ds->backing);
+
+  memset(ds, 0, sizeof(*ds));
+}
+
+void cleanupDataset(Dataset *ds)
+{
+  if (!ds)
+    return;
+  dataset_clear(ds);
   g_free(ds);
 }
 
 // --- Loader API Implementation ---
 
+// Snapshots the values of a table into a dense array, in the table's iteration order
+static GPtrArray *rows_from_table(GHashTable *table)
+{
+  if (!table)
+    return NULL;
+
+  GPtrArray *rows = g_ptr_array_sized_new(g_hash_table_size(table));
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init(&iter, table);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    g_ptr_array_add(rows, value);
+  return rows;
+}
+
+static void replace_rows(GPtrArray **slot, GHashTable *table)
+{
+  if (*slot)
+    g_ptr_array_free(*slot, TRUE);
+  *slot = rows_from_table(table);
+}
+
+// Primary key of a row, as stored in the lookup tables
+typedef gconstpointer (*RowKeyFunc)(const void *row);
+
+static gconstpointer flight_row_key(const void *row) { return getFlightId(row); }
+static gconstpointer passenger_row_key(const void *row) { return GINT_TO_POINTER(getPassengerDocumentNumber(row)); }
+static gconstpointer reservation_row_key(const void *row) { return getReservationId(row); }
+
+typedef struct
+{
+  ConcurrentMap *map;
+  RowKeyFunc key;
+} KeyInsertJob;
+
+static void insert_keys_body(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data)
+{
+  KeyInsertJob *job = user_data;
+  (void)start;
+  (void)local;
+  for (guint i = 0; i < count; i++)
+    concurrent_map_insert(job->map, (gpointer)job->key(rows[i]), (gpointer)rows[i]);
+}
+
+// Fills the lookup table of a collection from its rows, in parallel
+static void replace_lookup(LookupTable **slot, const GPtrArray *rows, LookupKeyType type, RowKeyFunc key)
+{
+  lookup_table_free(*slot);
+  *slot = NULL;
+  if (!rows)
+    return;
+
+  KeyInsertJob job = {concurrent_map_new(type, rows->len, NULL, NULL), key};
+  DatasetParallelOps ops = {.body = insert_keys_body};
+  dataset_parallel_foreach_rows((const void *const *)rows->pdata, rows->len, &ops, &job);
+  *slot = concurrent_map_seal(job.map);
+}
+
 void dataset_set_flights(Dataset *ds, GHashTable *flights)
 {
-  if (ds)
-    ds->flights = flights;
+  if (!ds)
+    return;
+  ds->flights = flights;
+  replace_rows(&ds->flightRows, flights);
+  replace_lookup(&ds->flightLookup, ds->flightRows, LOOKUP_KEY_STRING, flight_row_key);
 }
 void dataset_set_passengers(Dataset *ds, GHashTable *passengers)
 {
-  if (ds)
-    ds->passengers = passengers;
+  if (!ds)
+    return;
+  ds->passengers = passengers;
+  replace_rows(&ds->passengerRows, passengers);
+  replace_lookup(&ds->passengerLookup, ds->passengerRows, LOOKUP_KEY_INT, passenger_row_key);
 }
 void dataset_set_airports(Dataset *ds, GHashTable *airports)
 {
@@ -89,33 +251,87 @@ void dataset_set_airports(Dataset *ds, GHashTable *airports)
 }
 void dataset_set_aircrafts(Dataset *ds, GHashTable *aircrafts)
 {
-  if (ds)
-    ds->aircrafts = aircrafts;
+  if (!ds)
+    return;
+  ds->aircrafts = aircrafts;
+  replace_rows(&ds->aircraftRows, aircrafts);
 }
 void dataset_set_reservations(Dataset *ds, GHashTable *reservations)
 {
-  if (ds)
-    ds->reservations = reservations;
+  if (!ds)
+    return;
+  ds->reservations = reservations;
+  replace_rows(&ds->reservationRows, reservations);
+  replace_lookup(&ds->reservationLookup, ds->reservationRows, LOOKUP_KEY_STRING, reservation_row_key);
+}
+void dataset_set_flight_rows(Dataset *ds, GPtrArray *rows)
+{
+  if (!ds)
+    return;
+  if (ds->flightRows)
+    g_ptr_array_free(ds->flightRows, TRUE);
+  ds->flightRows = rows;
+}
+void dataset_set_passenger_rows(Dataset *ds, GPtrArray *rows)
+{
+  if (!ds)
+    return;
+  if (ds->passengerRows)
+    g_ptr_array_free(ds->passengerRows, TRUE);
+  ds->passengerRows = rows;
+}
+void dataset_set_aircraft_rows(Dataset *ds, GPtrArray *rows)
+{
+  if (!ds)
+    return;
+  if (ds->aircraftRows)
+    g_ptr_array_free(ds->aircraftRows, TRUE);
+  ds->aircraftRows = rows;
+}
+void dataset_set_reservation_rows(Dataset *ds, GPtrArray *rows)
+{
+  if (!ds)
+    return;
+  if (ds->reservationRows)
+    g_ptr_array_free(ds->reservationRows, TRUE);
+  ds->reservationRows = rows;
+}
+void dataset_set_backing(Dataset *ds, gpointer block, GDestroyNotify destroy)
+{
+  if (!ds)
+    return;
+  if (ds->backing && ds->backingFree)
+    ds->backingFree(ds->backing);
+  ds->backing = block;
+  ds->backingFree = destroy;
 }
 void dataset_set_airport_stats(Dataset *ds, GHashTable *stats)
 {
   if (ds)
     ds->airportStats = stats;
 }
+// The dictionaries copy the strings into their own pool; the source list is consumed
+static void set_dict(StringDict **slot, GPtrArray *strings)
+{
+  string_dict_free(*slot);
+  *slot = string_dict_new(strings);
+  if (strings)
+    g_ptr_array_free(strings, TRUE);
+}
 void dataset_set_airport_codes(Dataset *ds, GPtrArray *codes)
 {
   if (ds)
-    ds->airportCodes = codes;
+    set_dict(&ds->airportCodes, codes);
 }
 void dataset_set_aircraft_manufacturers(Dataset *ds, GPtrArray *manufacturers)
 {
   if (ds)
-    ds->aircraftManufacturers = manufacturers;
+    set_dict(&ds->aircraftManufacturers, manufacturers);
 }
 void dataset_set_nationalities(Dataset *ds, GPtrArray *nationalities)
 {
   if (ds)
-    ds->nationalities = nationalities;
+    set_dict(&ds->nationalities, nationalities);
 }
 
 // --- Counters ---
@@ -137,45 +353,73 @@ int dataset_get_reservation_count(const Dataset *ds)
 }
 
 // --- Entity Iterators ---
-static DatasetIterator *iterator_new_from_table(GHashTable *table)
+static DatasetIterator *iterator_new_from_rows(GPtrArray *rows)
 {
-  if (!table)
+  if (!rows)
     return NULL;
   DatasetIterator *it = g_new0(DatasetIterator, 1);
-  g_hash_table_iter_init(&it->iter, table);
+  it->rows = rows;
+  it->index = 0;
   return it;
 }
 
 DatasetIterator *dataset_flight_iterator_new(const Dataset *ds)
 {
-  return iterator_new_from_table(ds->flights);
+  return iterator_new_from_rows(ds->flightRows);
 }
 
 DatasetIterator *dataset_aircraft_iterator_new(const Dataset *ds)
 {
-  return iterator_new_from_table(ds->aircrafts);
+  return iterator_new_from_rows(ds->aircraftRows);
 }
 
 DatasetIterator *dataset_reservation_iterator_new(const Dataset *ds)
 {
-  return iterator_new_from_table(ds->reservations);
+  return iterator_new_from_rows(ds->reservationRows);
 }
 
 DatasetIterator *dataset_passenger_iterator_new(const Dataset *ds)
 {
-  return iterator_new_from_table(ds->passengers);
+  return iterator_new_from_rows(ds->passengerRows);
 }
 
 const void *dataset_iterator_next(DatasetIterator *it)
 {
-  if (!it)
+  if (!it || it->index >= it->rows->len)
     return NULL;
-  gpointer key, value;
-  if (g_hash_table_iter_next(&it->iter, &key, &value))
-  {
-    return (const void *)value;
-  }
-  return NULL;
+  return (const void *)g_ptr_array_index(it->rows, it->index++);
+}
+
+static guint iterator_next_batch(DatasetIterator *it, const void **out, guint max)
+{
+  if (!it || !out)
+    return 0;
+
+  guint remaining = it->rows->len - it->index;
+  guint n = remaining < max ? remaining : max;
+  memcpy(out, it->rows->pdata + it->index, n * sizeof(gpointer));
+  it->index += n;
+  return n;
+}
+
+guint dataset_flight_iterator_next_batch(DatasetIterator *it, const Flight **out, guint max)
+{
+  return iterator_next_batch(it, (const void **)out, max);
+}
+
+guint dataset_aircraft_iterator_next_batch(DatasetIterator *it, const Aircraft **out, guint max)
+{
+  return iterator_next_batch(it, (const void **)out, max);
+}
+
+guint dataset_reservation_iterator_next_batch(DatasetIterator *it, const Reservation **out, guint max)
+{
+  return iterator_next_batch(it, (const void **)out, max);
+}
+
+guint dataset_passenger_iterator_next_batch(DatasetIterator *it, const Passenger **out, guint max)
+{
+  return iterator_next_batch(it, (const void **)out, max);
 }
 
 void dataset_iterator_free(DatasetIterator *it)
@@ -184,27 +428,366 @@ void dataset_iterator_free(DatasetIterator *it)
     g_free(it);
 }
 
-// --- String Iterators ---
+// --- Row Spans ---
+static const void *const *rows_span(const GPtrArray *rows, guint *count)
+{
+  if (count)
+    *count = rows ? rows->len : 0;
+  return rows ? (const void *const *)rows->pdata : NULL;
+}
+
+const Flight *const *dataset_flight_rows(const Dataset *ds, guint *count)
+{
+  return (const Flight *const *)rows_span(ds ? ds->flightRows : NULL, count);
+}
 
-static DatasetStringIterator *string_iterator_new(GPtrArray *array)
+const Aircraft *const *dataset_aircraft_rows(const Dataset *ds, guint *count)
 {
-  if (!array)
+  return (const Aircraft *const *)rows_span(ds ? ds->aircraftRows : NULL, count);
+}
+
+const Reservation *const *dataset_reservation_rows(const Dataset *ds, guint *count)
+{
+  return (const Reservation *const *)rows_span(ds ? ds->reservationRows : NULL, count);
+}
+
+const Passenger *const *dataset_passenger_rows(const Dataset *ds, guint *count)
+{
+  return (const Passenger *const *)rows_span(ds ? ds->passengerRows : NULL, count);
+}
+
+// --- Flight Posting Lists ---
+
+static const gchar *flight_key_value(const Flight *f, DatasetFlightKey key)
+{
+  switch (key)
+  {
+  case FLIGHT_KEY_ORIGIN:
+    return getFlightOrigin(f);
+  case FLIGHT_KEY_DESTINATION:
+    return getFlightDestination(f);
+  case FLIGHT_KEY_AIRLINE:
+    return getFlightAirline(f);
+  case FLIGHT_KEY_AIRCRAFT:
+    return getFlightAircraft(f);
+  default:
     return NULL;
+  }
+}
+
+static gint compare_key_strings(gconstpointer a, gconstpointer b)
+{
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Sorts the flights that have a valid (non-negative) timestamp by that timestamp
+static FlightTimeOrder *build_time_order(const Flight *const *flights, guint n, time_t (*timeOf)(const Flight *))
+{
+  FlightTimeOrder *order = g_new0(FlightTimeOrder, 1);
+  order->flights = g_new(const Flight *, n > 0 ? n : 1);
+  order->times = g_new(gint64, n > 0 ? n : 1);
+
+  for (guint i = 0; i < n; i++)
+  {
+    time_t t = timeOf(flights[i]);
+    if (t < 0)
+      continue;
+    order->flights[order->count] = flights[i];
+    order->times[order->count] = (gint64)t;
+    order->count++;
+  }
+
+  radix_sort_by_key(order->times, (gconstpointer *)order->flights, order->count);
+  return order;
+}
+
+void dataset_build_flight_indexes(Dataset *ds)
+{
+  if (!ds)
+    return;
+
+  for (int k = 0; k < FLIGHT_KEY_COUNT; k++)
+  {
+    if (ds->flightIndex[k])
+      g_hash_table_destroy(ds->flightIndex[k]);
+    if (ds->flightIndexKeys[k])
+      g_ptr_array_free(ds->flightIndexKeys[k], TRUE);
+    ds->flightIndex[k] = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)bitmap_free);
+    ds->flightIndexKeys[k] = g_ptr_array_new();
+  }
+  if (ds->flightStatusIndex)
+    g_hash_table_destroy(ds->flightStatusIndex);
+  ds->flightStatusIndex = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)bitmap_free);
+  // The time orders refer to the previous rows: the next range lookup rebuilds them
+  free_time_order(&ds->byDeparture);
+  free_time_order(&ds->byActualDeparture);
+
+  // 1. Single pass: append every flight to its four bitmaps (rows are visited in
+  // increasing order, as bitmaps require)
+  guint nFlights = 0;
+  const Flight *const *flights = dataset_flight_rows(ds, &nFlights);
+  for (guint i = 0; i < nFlights; i++)
+  {
+    const Flight *f = flights[i];
+    for (int k = 0; k < FLIGHT_KEY_COUNT; k++)
+    {
+      const gchar *value = flight_key_value(f, (DatasetFlightKey)k);
+      if (!value)
+        continue;
+      Bitmap *rows = g_hash_table_lookup(ds->flightIndex[k], value);
+      if (!rows)
+      {
+        rows = bitmap_new();
+        g_hash_table_insert(ds->flightIndex[k], (gpointer)value, rows);
+        g_ptr_array_add(ds->flightIndexKeys[k], (gpointer)value);
+      }
+      bitmap_append(rows, i);
+    }
+
+    const gchar *status = getFlightStatus(f);
+    Bitmap *statusRows = g_hash_table_lookup(ds->flightStatusIndex, status);
+    if (!statusRows)
+    {
+      statusRows = bitmap_new();
+      g_hash_table_insert(ds->flightStatusIndex, (gpointer)status, statusRows);
+    }
+    bitmap_append(statusRows, i);
+  }
+
+  // 2. Key values in strcmp order, for the key iterators
+  for (int k = 0; k < FLIGHT_KEY_COUNT; k++)
+    g_ptr_array_sort(ds->flightIndexKeys[k], compare_key_strings);
+}
+
+// Returns the time order in *slot, sorting it on the first call. Concurrent
+// callers wait for that sort; the slot is the only state a range lookup writes
+static const FlightTimeOrder *time_order(const Dataset *ds, FlightTimeOrder **slot, time_t (*timeOf)(const Flight *))
+{
+  if (g_once_init_enter(slot))
+  {
+    guint n = 0;
+    const Flight *const *flights = dataset_flight_rows(ds, &n);
+    g_once_init_leave(slot, build_time_order(flights, n, timeOf));
+  }
+  return *slot;
+}
+
+// Index of the first element of the span whose time is >= t
+static guint lower_bound_time(const FlightTimeOrder *order, gint64 t)
+{
+  guint lo = 0, hi = order->count;
+  while (lo < hi)
+  {
+    guint mid = lo + (hi - lo) / 2;
+    if (order->times[mid] < t)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static const Flight *const *time_order_range(const FlightTimeOrder *order, time_t start, time_t end, guint *count)
+{
+  if (count)
+    *count = 0;
+  if (!order->flights || end <= start)
+    return NULL;
+
+  guint first = lower_bound_time(order, (gint64)start);
+  guint last = lower_bound_time(order, (gint64)end);
+  if (count)
+    *count = last - first;
+  return first < last ? order->flights + first : NULL;
+}
+
+const Flight *const *dataset_flights_in_range(const Dataset *ds, time_t start, time_t end, guint *count)
+{
+  if (!ds)
+  {
+    if (count)
+      *count = 0;
+    return NULL;
+  }
+  return time_order_range(time_order(ds, &((Dataset *)ds)->byDeparture, getFlightDeparture), start, end, count);
+}
+
+const Flight *const *dataset_flights_in_actual_range(const Dataset *ds, time_t start, time_t end, guint *count)
+{
+  if (!ds)
+  {
+    if (count)
+      *count = 0;
+    return NULL;
+  }
+  return time_order_range(time_order(ds, &((Dataset *)ds)->byActualDeparture, getFlightActualDeparture), start,
+                          end, count);
+}
+
+// --- Flight Bitmaps ---
+
+const Bitmap *dataset_flight_bitmap(const Dataset *ds, DatasetFlightKey key, const char *value)
+{
+  if (!ds || !value || key >= FLIGHT_KEY_COUNT || !ds->flightIndex[key])
+    return NULL;
+  return g_hash_table_lookup(ds->flightIndex[key], value);
+}
+
+const Bitmap *dataset_flight_status_bitmap(const Dataset *ds, const char *status)
+{
+  if (!ds || !status || !ds->flightStatusIndex)
+    return NULL;
+  return g_hash_table_lookup(ds->flightStatusIndex, status);
+}
+
+// --- Passenger Reservations ---
+
+typedef struct
+{
+  gint64 departure;
+  const Reservation *reservation;
+} BookingKey;
+
+static gint compare_booking_keys(gconstpointer a, gconstpointer b)
+{
+  const BookingKey *ka = a;
+  const BookingKey *kb = b;
+  if (ka->departure != kb->departure)
+    return ka->departure < kb->departure ? -1 : 1;
+  return strcmp(getReservationId(ka->reservation), getReservationId(kb->reservation));
+}
+
+// Scheduled departure of a reservation's first flight (G_MAXINT64 when unknown, so it sorts last)
+static gint64 booking_departure(const Dataset *ds, const Reservation *r)
+{
+  gchar **flightIds = getReservationFlightIds(r);
+  const Flight *f = (flightIds && flightIds[0]) ? dataset_get_flight(ds, flightIds[0]) : NULL;
+  return f ? (gint64)getFlightDeparture(f) : G_MAXINT64;
+}
+
+void dataset_build_passenger_index(Dataset *ds)
+{
+  if (!ds)
+    return;
+
+  if (ds->passengerSlots)
+    g_hash_table_destroy(ds->passengerSlots);
+  g_free(ds->passengerOffsets);
+  g_free(ds->passengerReservations);
+
+  guint nPassengers = 0, nReservations = 0;
+  const Passenger *const *passengers = dataset_passenger_rows(ds, &nPassengers);
+  const Reservation *const *reservations = dataset_reservation_rows(ds, &nReservations);
+
+  // 1. Document number -> passenger row (stored +1 so that 0 means "absent")
+  ds->passengerSlots = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for (guint p = 0; p < nPassengers; p++)
+    g_hash_table_insert(ds->passengerSlots, GINT_TO_POINTER(getPassengerDocumentNumber(passengers[p])),
+                        GUINT_TO_POINTER(p + 1));
+
+  // 2. Count bookings per passenger, then turn the counts into offsets
+  guint *rowOf = g_new(guint, nReservations > 0 ? nReservations : 1);
+  ds->passengerOffsets = g_new0(guint, nPassengers + 1);
+  for (guint r = 0; r < nReservations; r++)
+  {
+    guint slot = GPOINTER_TO_UINT(g_hash_table_lookup(ds->passengerSlots,
+                                                      GINT_TO_POINTER(getReservationDocumentNo(reservations[r]))));
+    rowOf[r] = slot;
+    if (slot)
+      ds->passengerOffsets[slot]++;
+  }
+  for (guint p = 0; p < nPassengers; p++)
+    ds->passengerOffsets[p + 1] += ds->passengerOffsets[p];
+
+  // 3. Scatter the references into their passenger's range
+  guint total = ds->passengerOffsets[nPassengers];
+  ds->passengerReservations = g_new(const Reservation *, total > 0 ? total : 1);
+  guint *cursor = g_memdup2(ds->passengerOffsets, (nPassengers + 1) * sizeof(guint));
+  for (guint r = 0; r < nReservations; r++)
+  {
+    if (rowOf[r])
+      ds->passengerReservations[cursor[rowOf[r] - 1]++] = reservations[r];
+  }
+  g_free(cursor);
+  g_free(rowOf);
+
+  // 4. Order each passenger's bookings chronologically (by first flight, then by ID)
+  GArray *keys = g_array_new(FALSE, FALSE, sizeof(BookingKey));
+  for (guint p = 0; p < nPassengers; p++)
+  {
+    guint first = ds->passengerOffsets[p];
+    guint last = ds->passengerOffsets[p + 1];
+    if (last - first < 2)
+      continue;
+
+    g_array_set_size(keys, 0);
+    for (guint i = first; i < last; i++)
+    {
+      BookingKey key = {booking_departure(ds, ds->passengerReservations[i]), ds->passengerReservations[i]};
+      g_array_append_val(keys, key);
+    }
+    g_array_sort(keys, compare_booking_keys);
+    for (guint i = first; i < last; i++)
+      ds->passengerReservations[i] = g_array_index(keys, BookingKey, i - first).reservation;
+  }
+  g_array_free(keys, TRUE);
+}
+
+const Reservation *const *dataset_passenger_reservations(const Dataset *ds, int documentNo, guint *count)
+{
+  if (count)
+    *count = 0;
+  if (!ds || !ds->passengerSlots)
+    return NULL;
+
+  guint slot = GPOINTER_TO_UINT(g_hash_table_lookup(ds->passengerSlots, GINT_TO_POINTER(documentNo)));
+  if (!slot)
+    return NULL;
+
+  guint first = ds->passengerOffsets[slot - 1];
+  guint last = ds->passengerOffsets[slot];
+  if (count)
+    *count = last - first;
+  return first < last ? ds->passengerReservations + first : NULL;
+}
+
+// --- String Iterators ---
+
+static DatasetStringIterator *string_iterator_new(const char *const *items, guint len)
+{
   DatasetStringIterator *it = g_new0(DatasetStringIterator, 1);
-  it->array = array;
+  it->items = items;
+  it->len = len;
   it->index = 0;
   return it;
 }
 
-DatasetStringIterator *dataset_airport_codes_iter_new(Dataset *ds) { return string_iterator_new(ds->airportCodes); }
-DatasetStringIterator *dataset_aircraft_manufacturers_iter_new(Dataset *ds) { return string_iterator_new(ds->aircraftManufacturers); }
-DatasetStringIterator *dataset_nationalities_iter_new(Dataset *ds) { return string_iterator_new(ds->nationalities); }
+static DatasetStringIterator *dict_iterator_new(const StringDict *dict)
+{
+  if (!dict)
+    return NULL;
+  guint len = 0;
+  const char *const *items = string_dict_entries(dict, &len);
+  return string_iterator_new(items, len);
+}
+
+DatasetStringIterator *dataset_airport_codes_iter_new(Dataset *ds) { return dict_iterator_new(ds->airportCodes); }
+DatasetStringIterator *dataset_aircraft_manufacturers_iter_new(Dataset *ds) { return dict_iterator_new(ds->aircraftManufacturers); }
+DatasetStringIterator *dataset_nationalities_iter_new(Dataset *ds) { return dict_iterator_new(ds->nationalities); }
+
+DatasetStringIterator *dataset_flight_keys_iter_new(const Dataset *ds, DatasetFlightKey key)
+{
+  if (!ds || key >= FLIGHT_KEY_COUNT || !ds->flightIndexKeys[key])
+    return NULL;
+  GPtrArray *keys = ds->flightIndexKeys[key];
+  return string_iterator_new((const char *const *)keys->pdata, keys->len);
+}
 
 const char *dataset_string_iter_next(DatasetStringIterator *it)
 {
-  if (it && it->array && it->index < it->array->len)
+  if (it && it->items && it->index < it->len)
   {
-    return (const char *)g_ptr_array_index(it->array, it->index++);
+    return it->items[it->index++];
   }
   return NULL;
 }
@@ -215,6 +798,12 @@ void dataset_string_iter_free(DatasetStringIterator *it)
     g_free(it);
 }
 
+// --- String Dictionaries ---
+
+const StringDict *dataset_airport_codes_dict(const Dataset *ds) { return ds ? ds->airportCodes : NULL; }
+const StringDict *dataset_aircraft_manufacturers_dict(const Dataset *ds) { return ds ? ds->aircraftManufacturers : NULL; }
+const StringDict *dataset_nationalities_dict(const Dataset *ds) { return ds ? ds->nationalities : NULL; }
+
 // --- Accessors ---
 
 const AirportPassengerStats *dataset_get_airport_stats(const Dataset *ds, const char *code)
@@ -257,4 +846,28 @@ const Reservation *dataset_get_reservation(const Dataset *ds, const char *id)
   if (!ds || !ds->reservations || !id)
     return NULL;
   return getReservation(id, ds->reservations);
-}
\ No newline at end of file
+}
+
+// --- Batch Accessors ---
+
+void dataset_get_flights_batch(const Dataset *ds, const char *const *ids, guint n, const Flight **out)
+{
+  lookup_table_get_batch(ds ? ds->flightLookup : NULL, (const gconstpointer *)ids, n, (gpointer *)out);
+}
+
+void dataset_get_passengers_batch(const Dataset *ds, const int *ids, guint n, const Passenger **out)
+{
+  gconstpointer keys[LOOKUP_BATCH_GROUP];
+  for (guint base = 0; base < n; base += LOOKUP_BATCH_GROUP)
+  {
+    guint m = MIN(LOOKUP_BATCH_GROUP, n - base);
+    for (guint i = 0; i < m; i++)
+      keys[i] = GINT_TO_POINTER(ids[base + i]);
+    lookup_table_get_batch(ds ? ds->passengerLookup : NULL, keys, m, (gpointer *)(out + base));
+  }
+}
+
+void dataset_get_reservations_batch(const Dataset *ds, const char *const *ids, guint n, const Reservation **out)
+{
+  lookup_table_get_batch(ds ? ds->reservationLookup : NULL, (const gconstpointer *)ids, n, (gpointer *)out);
+}
@@ -0,0 +1,220 @@
+#include "core/dataset_parallel.h"
+#include <glib.h>
+
+// 0 means "use the number of online processors"
+static gint configuredWorkers = 0;
+
+typedef struct
+{
+    const DatasetParallelOps *ops;
+    gpointer userData;
+    const void *const *rows;
+    guint start;
+    guint count;
+    gpointer local;
+} ParallelChunk;
+
+guint dataset_parallel_get_workers(void)
+{
+    gint workers = g_atomic_int_get(&configuredWorkers);
+    if (workers > 0)
+        return (guint)workers;
+    guint procs = g_get_num_processors();
+    return procs > 0 ? procs : 1;
+}
+
+void dataset_parallel_set_workers(guint workers)
+{
+    g_atomic_int_set(&configuredWorkers, (gint)workers);
+}
+
+static void run_chunk(ParallelChunk *chunk)
+{
+    chunk->local = chunk->ops->local_new ? chunk->ops->local_new(chunk->userData) : NULL;
+    chunk->ops->body(chunk->rows + chunk->start, chunk->start, chunk->count, chunk->local, chunk->userData);
+}
+
+static gpointer chunk_thread(gpointer data)
+{
+    run_chunk((ParallelChunk *)data);
+    return NULL;
+}
+
+void dataset_parallel_foreach_rows(const void *const *rows, guint count,
+                                   const DatasetParallelOps *ops, gpointer user_data)
+{
+    if (!ops || !ops->body || count == 0 || !rows)
+        return;
+
+    // Never hand a worker less than one grain of rows
+    guint grain = ops->grain > 0 ? ops->grain : DATASET_PARALLEL_MIN_CHUNK;
+    guint workers = dataset_parallel_get_workers();
+    guint maxUseful = count / grain;
+    if (workers > maxUseful)
+        workers = maxUseful;
+    if (workers < 1)
+        workers = 1;
+
+    ParallelChunk *chunks = g_new0(ParallelChunk, workers);
+    guint base = count / workers;
+    guint extra = count % workers;
+    guint offset = 0;
+    for (guint w = 0; w < workers; w++)
+    {
+        chunks[w].ops = ops;
+        chunks[w].userData = user_data;
+        chunks[w].rows = rows;
+        chunks[w].start = offset;
+        chunks[w].count = base + (w < extra ? 1 : 0);
+        offset += chunks[w].count;
+    }
+
+    // Chunk 0 runs on the calling thread, the rest on dedicated workers
+    GThread **threads = workers > 1 ? g_new0(GThread *, workers) : NULL;
+    for (guint w = 1; w < workers; w++)
+    {
+        threads[w] = g_thread_new("dataset-scan", chunk_thread, &chunks[w]);
+    }
+    run_chunk(&chunks[0]);
+    for (guint w = 1; w < workers; w++)
+    {
+        g_thread_join(threads[w]);
+    }
+
+    if (ops->combine)
+    {
+        for (guint w = 0; w < workers; w++)
+            ops->combine(chunks[w].local, user_data);
+    }
+
+    g_free(threads);
+    g_free(chunks);
+}
+
+// --- Work Stealing ---
+
+// Indexes [next, end) not yet taken from one worker
+typedef struct
+{
+    GMutex lock;
+    guint next;
+    guint end;
+} StealRange;
+
+typedef struct
+{
+    StealRange *ranges;
+    guint workers;
+    guint self;
+    DatasetIndexFunc task;
+    gpointer userData;
+} StealWorker;
+
+static gboolean take_index(StealRange *range, guint *index)
+{
+    g_mutex_lock(&range->lock);
+    gboolean found = range->next < range->end;
+    if (found)
+        *index = range->next++;
+    g_mutex_unlock(&range->lock);
+    return found;
+}
+
+// Moves the upper half of another worker's remaining indexes into our (empty) range
+static gboolean steal_indexes(StealWorker *w)
+{
+    for (guint offset = 1; offset < w->workers; offset++)
+    {
+        StealRange *victim = &w->ranges[(w->self + offset) % w->workers];
+        g_mutex_lock(&victim->lock);
+        guint remaining = victim->end - victim->next;
+        guint stolenEnd = victim->end;
+        victim->end -= (remaining + 1) / 2;
+        guint stolenStart = victim->end;
+        g_mutex_unlock(&victim->lock);
+
+        if (stolenStart < stolenEnd)
+        {
+            StealRange *own = &w->ranges[w->self];
+            g_mutex_lock(&own->lock);
+            own->next = stolenStart;
+            own->end = stolenEnd;
+            g_mutex_unlock(&own->lock);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static gpointer steal_thread(gpointer data)
+{
+    StealWorker *w = data;
+    guint index;
+    do
+    {
+        while (take_index(&w->ranges[w->self], &index))
+            w->task(index, w->userData);
+    } while (steal_indexes(w));
+    return NULL;
+}
+
+void dataset_parallel_foreach_index(guint count, DatasetIndexFunc task, gpointer user_data)
+{
+    if (!task || count == 0)
+        return;
+
+    guint workers = MIN(dataset_parallel_get_workers(), count);
+    StealRange *ranges = g_new0(StealRange, workers);
+    StealWorker *states = g_new0(StealWorker, workers);
+    for (guint w = 0; w < workers; w++)
+    {
+        g_mutex_init(&ranges[w].lock);
+        ranges[w].next = (guint)((guint64)count * w / workers);
+        ranges[w].end = (guint)((guint64)count * (w + 1) / workers);
+        states[w] = (StealWorker){.ranges = ranges, .workers = workers, .self = w, .task = task, .userData = user_data};
+    }
+
+    // Worker 0 runs on the calling thread, the rest on dedicated threads
+    GThread **threads = g_new0(GThread *, workers);
+    for (guint w = 1; w < workers; w++)
+        threads[w] = g_thread_new("dataset-tasks", steal_thread, &states[w]);
+    steal_thread(&states[0]);
+    for (guint w = 1; w < workers; w++)
+        g_thread_join(threads[w]);
+
+    for (guint w = 0; w < workers; w++)
+        g_mutex_clear(&ranges[w].lock);
+    g_free(threads);
+    g_free(states);
+    g_free(ranges);
+}
+
+// --- Typed Scans ---
+
+void dataset_parallel_foreach_flight(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data)
+{
+    guint count = 0;
+    const Flight *const *rows = dataset_flight_rows(ds, &count);
+    dataset_parallel_foreach_rows((const void *const *)rows, count, ops, user_data);
+}
+
+void dataset_parallel_foreach_aircraft(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data)
+{
+    guint count = 0;
+    const Aircraft *const *rows = dataset_aircraft_rows(ds, &count);
+    dataset_parallel_foreach_rows((const void *const *)rows, count, ops, user_data);
+}
+
+void dataset_parallel_foreach_reservation(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data)
+{
+    guint count = 0;
+    const Reservation *const *rows = dataset_reservation_rows(ds, &count);
+    dataset_parallel_foreach_rows((const void *const *)rows, count, ops, user_data);
+}
+
+void dataset_parallel_foreach_passenger(const Dataset *ds, const DatasetParallelOps *ops, gpointer user_data)
+{
+    guint count = 0;
+    const Passenger *const *rows = dataset_passenger_rows(ds, &count);
+    dataset_parallel_foreach_rows((const void *const *)rows, count, ops, user_data);
+}
@@ -26,6 +26,59 @@ void freeFTree(gpointer data)
   }
 }
 
+typedef struct
+{
+  const Flight *const *rows;
+  FTree *tree;
+} TreeFill;
+
+// Counts one departure (a flight row) in the tree, on the day it actually left
+static void add_departure(guint32 row, gpointer user_data)
+{
+  TreeFill *fill = user_data;
+  FTree *tree = fill->tree;
+
+  time_t date = getFlightActualDeparture(fill->rows[row]);
+  if (date < 0)
+  {
+    return;
+  }
+
+  time_t date_trunc = date - (date % 86400);
+
+  // Binary search
+  int lower = 0, upper = tree->n - 1, idx = -1;
+  while (lower <= upper)
+  {
+    int mid = (lower + upper) / 2;
+    time_t dt = tree->dates[mid];
+    if (dt == -1)
+    {
+      lower = mid + 1;
+      continue;
+    }
+    gint cmp = compare_time_t(dt, date_trunc);
+    if (cmp < 0)
+    {
+      lower = mid + 1;
+    }
+    else
+    {
+      idx = mid + 1;
+      upper = mid - 1;
+    }
+  }
+  if (idx > 0)
+  {
+    int pos = idx;
+    while (pos <= tree->n)
+    {
+      tree->bit[pos] += 1;
+      pos += (pos & -pos);
+    }
+  }
+}
+
 GHashTable *getFTrees(GHashTable *airportDepartures, const Dataset *ds)
 {
 
@@ -60,72 +113,23 @@ GHashTable *getFTrees(GHashTable *airportDepartures, const Dataset *ds)
     g_hash_table_insert(airportTrees, g_strdup(airportCode), tree);
   }
 
-  // 2. Iterate through Flights using dataset iterator
-  DatasetIterator *it = dataset_flight_iterator_new(ds);
-  const Flight *flight;
+  // 2. Fill each tree from its airport's operated departures (origin minus cancelled)
+  const Bitmap *cancelled = dataset_flight_status_bitmap(ds, "Cancelled");
+  guint nRows = 0;
+  TreeFill fill = {.rows = dataset_flight_rows(ds, &nRows)};
 
-  while ((flight = (const Flight *)dataset_iterator_next(it)) != NULL)
-  {
-
-    if (strcmp(getFlightStatus(flight), "Cancelled") == 0)
-    {
-      continue;
-    }
-    const gchar *airportCode = getFlightOrigin(flight);
-    if (!airportCode)
-    {
-      continue;
-    }
-
-    FTree *tree = g_hash_table_lookup(airportTrees, airportCode);
-    if (!tree)
-    {
-      continue;
-    }
+  GHashTableIter titer;
+  gpointer tkey, tval;
+  g_hash_table_iter_init(&titer, airportTrees);
 
-    time_t date = getFlightActualDeparture(flight);
-    if (date < 0)
-    {
-      continue;
-    }
-
-    time_t date_trunc = date - (date % 86400);
-
-    // Binary search
-    int lower = 0, upper = tree->n - 1, idx = -1;
-    while (lower <= upper)
-    {
-      int mid = (lower + upper) / 2;
-      time_t dt = tree->dates[mid];
-      if (dt == -1)
-      {
-        lower = mid + 1;
-        continue;
-      }
-      gint cmp = compare_time_t(dt, date_trunc);
-      if (cmp < 0)
-      {
-        lower = mid + 1;
-      }
-      else
-      {
-        idx = mid + 1;
-        upper = mid - 1;
-      }
-    }
-    if (idx > 0)
-    {
-      int pos = idx;
-      while (pos <= tree->n)
-      {
-        tree->bit[pos] += 1;
-        pos += (pos & -pos);
-      }
-    }
+  while (g_hash_table_iter_next(&titer, &tkey, &tval))
+  {
+    fill.tree = (FTree *)tval;
+    Bitmap *departures = bitmap_andnot(dataset_flight_bitmap(ds, FLIGHT_KEY_ORIGIN, (const char *)tkey), cancelled);
+    bitmap_foreach(departures, add_departure, &fill);
+    bitmap_free(departures);
   }
 
-  dataset_iterator_free(it);
-
   return airportTrees;
 }
 
@@ -1,5 +1,6 @@
 #include <core/indexer.h>
 #include <core/dataset.h>
+#include <core/dataset_parallel.h>
 #include <entities/access/flights_access.h>
 #include <core/time_utils.h>
 #include <glib.h>
@@ -24,50 +25,122 @@ static void freeDatesInfo(gpointer data)
     }
 }
 
-GHashTable *create_date_index(const Dataset *ds)
+static GHashTable *newDateIndexTable(void)
 {
-    GHashTable *airportsDepartures = g_hash_table_new_full(
-        g_str_hash, g_str_equal, g_free, (GDestroyNotify)freeDatesInfo);
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)freeDatesInfo);
+}
 
-    DatasetIterator *it = dataset_flight_iterator_new(ds);
-    const Flight *flight;
+static DatesInfo *getOrCreateDatesInfo(GHashTable *index, const gchar *airportCode)
+{
+    DatesInfo *di = g_hash_table_lookup(index, airportCode);
+    if (!di)
+    {
+        di = g_new0(DatesInfo, 1);
+        di->distinctDates = g_array_new(FALSE, FALSE, sizeof(time_t));
+        di->dateSet = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(index, g_strdup(airportCode), di);
+    }
+    return di;
+}
 
-    while ((flight = (const Flight *)dataset_iterator_next(it)) != NULL)
+static void addDistinctDate(DatesInfo *di, time_t dayDep)
+{
+    if (!g_hash_table_contains(di->dateSet, (gpointer)dayDep))
     {
+        g_hash_table_add(di->dateSet, (gpointer)dayDep);
+        g_array_append_val(di->distinctDates, dayDep);
+    }
+}
 
-        const char *status = getFlightStatus(flight);
-        if (status && strcmp(status, "Cancelled") == 0)
-        {
-            continue;
-        }
+typedef struct
+{
+    const Dataset *ds;
+    GHashTable *airportsDepartures;
+    const Bitmap *cancelled;
+    const Flight *const *rows;
+} DateIndexJob;
+
+typedef struct
+{
+    const Flight *const *rows;
+    DatesInfo *di;
+} DateCollector;
 
-        const gchar *airportCode = getFlightOrigin(flight);
-        if (!airportCode)
-            continue;
+static void collectDepartureDate(guint32 row, gpointer user_data)
+{
+    DateCollector *dc = user_data;
+    time_t actualDep = getFlightActualDeparture(dc->rows[row]);
+    if (actualDep < 0)
+        return;
 
-        DatesInfo *di = g_hash_table_lookup(airportsDepartures, airportCode);
-        if (!di)
-        {
-            di = g_new0(DatesInfo, 1);
-            di->distinctDates = g_array_new(FALSE, FALSE, sizeof(time_t));
-            di->dateSet = g_hash_table_new(g_direct_hash, g_direct_equal);
-            g_hash_table_insert(airportsDepartures, g_strdup(airportCode), di);
-        }
+    addDistinctDate(dc->di, actualDep - (actualDep % 86400));
+}
 
-        time_t actualDep = getFlightActualDeparture(flight);
-        if (actualDep < 0)
-            continue;
+static gpointer dateIndexLocalNew(gpointer user_data)
+{
+    (void)user_data;
+    return newDateIndexTable();
+}
 
-        time_t dayDep = actualDep - (actualDep % 86400);
+// Rows are origin airport codes: each one visits its operated departures, i.e.
+// its origin bitmap minus the cancelled flights
+static void dateIndexBody(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data)
+{
+    GHashTable *airportsDepartures = local;
+    const DateIndexJob *job = user_data;
+    (void)start;
 
-        if (!g_hash_table_contains(di->dateSet, (gpointer)dayDep))
+    for (guint a = 0; a < count; a++)
+    {
+        const gchar *airportCode = rows[a];
+        Bitmap *departures = bitmap_andnot(dataset_flight_bitmap(job->ds, FLIGHT_KEY_ORIGIN, airportCode),
+                                           job->cancelled);
+
+        if (bitmap_cardinality(departures) > 0)
         {
-            g_hash_table_add(di->dateSet, (gpointer)dayDep);
-            g_array_append_val(di->distinctDates, dayDep);
+            DateCollector dc = {.rows = job->rows, .di = getOrCreateDatesInfo(airportsDepartures, airportCode)};
+            bitmap_foreach(departures, collectDepartureDate, &dc);
         }
+        bitmap_free(departures);
     }
+}
+
+// Airports are disjoint across chunks, so entries are simply moved over
+static void dateIndexCombine(gpointer local, gpointer user_data)
+{
+    GHashTable *partial = local;
+    GHashTable *airportsDepartures = ((DateIndexJob *)user_data)->airportsDepartures;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, partial);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        g_hash_table_iter_steal(&iter);
+        g_hash_table_insert(airportsDepartures, key, value);
+    }
+    g_hash_table_destroy(partial);
+}
+
+GHashTable *create_date_index(const Dataset *ds)
+{
+    GHashTable *airportsDepartures = newDateIndexTable();
+
+    GPtrArray *origins = g_ptr_array_new();
+    DatasetStringIterator *keys = dataset_flight_keys_iter_new(ds, FLIGHT_KEY_ORIGIN);
+    const char *code;
+    while ((code = dataset_string_iter_next(keys)) != NULL)
+        g_ptr_array_add(origins, (gpointer)code);
+    dataset_string_iter_free(keys);
 
-    dataset_iterator_free(it);
+    guint nRows = 0;
+    DateIndexJob job = {.ds = ds,
+                        .airportsDepartures = airportsDepartures,
+                        .cancelled = dataset_flight_status_bitmap(ds, "Cancelled"),
+                        .rows = dataset_flight_rows(ds, &nRows)};
+    DatasetParallelOps ops = {.local_new = dateIndexLocalNew, .body = dateIndexBody, .combine = dateIndexCombine, .grain = 8};
+    dataset_parallel_foreach_rows((const void *const *)origins->pdata, origins->len, &ops, &job);
+    g_ptr_array_free(origins, TRUE);
 
     GHashTableIter datesIter;
     gpointer datesKey, datesVal;
@@ -0,0 +1,257 @@
+#include "core/lookup_table.h"
+#include "core/lookup_table_internal.h"
+#include <glib.h>
+#include <string.h>
+
+typedef LookupSlot Slot;
+
+struct lookup_table
+{
+  LookupKeyType type;
+  Slot *slots;
+  guint64 mask; // Capacity - 1 (capacity is a power of two)
+  guint size;
+  GDestroyNotify keyDestroy;
+  GDestroyNotify valueDestroy;
+};
+
+// --- Hashing ---
+
+static guint64 mix64(guint64 h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+guint64 lookup_table_hash(LookupKeyType type, gconstpointer key)
+{
+  guint64 h;
+  if (type == LOOKUP_KEY_INT)
+  {
+    h = mix64((guint64)(gint64)GPOINTER_TO_INT(key));
+  }
+  else
+  {
+    // FNV-1a, then a finalizer so that the low bits (the slot index) are well mixed
+    h = 0xcbf29ce484222325ULL;
+    for (const guchar *p = key; *p; p++)
+    {
+      h ^= *p;
+      h *= 0x100000001b3ULL;
+    }
+    h = mix64(h);
+  }
+  return h ? h : 1;
+}
+
+gboolean lookup_table_keys_equal(LookupKeyType type, gconstpointer a, gconstpointer b)
+{
+  if (type == LOOKUP_KEY_INT)
+    return a == b;
+  return strcmp(a, b) == 0;
+}
+
+// --- Building ---
+
+guint64 lookup_table_capacity_for(guint n)
+{
+  // Keep the load factor at or below 1/2
+  guint64 capacity = 16;
+  while (capacity < (guint64)n * 2)
+    capacity <<= 1;
+  return capacity;
+}
+
+static void place(Slot *slots, guint64 mask, guint64 hash, gconstpointer key, gpointer value)
+{
+  guint64 i = hash & mask;
+  while (slots[i].hash != 0)
+    i = (i + 1) & mask;
+  slots[i].hash = hash;
+  slots[i].key = key;
+  slots[i].value = value;
+}
+
+static void grow(LookupTable *table)
+{
+  guint64 capacity = (table->mask + 1) * 2;
+  Slot *slots = g_new0(Slot, capacity);
+  for (guint64 i = 0; i <= table->mask; i++)
+  {
+    const Slot *s = &table->slots[i];
+    if (s->hash != 0)
+      place(slots, capacity - 1, s->hash, s->key, s->value);
+  }
+  g_free(table->slots);
+  table->slots = slots;
+  table->mask = capacity - 1;
+}
+
+LookupTable *lookup_table_new(LookupKeyType type, guint expected)
+{
+  return lookup_table_new_full(type, expected, NULL, NULL);
+}
+
+LookupTable *lookup_table_new_full(LookupKeyType type, guint expected,
+                                   GDestroyNotify key_destroy, GDestroyNotify value_destroy)
+{
+  guint64 capacity = lookup_table_capacity_for(expected);
+  return lookup_table_adopt(type, g_new0(Slot, capacity), capacity, 0, key_destroy, value_destroy);
+}
+
+LookupTable *lookup_table_adopt(LookupKeyType type, LookupSlot *slots, guint64 capacity, guint size,
+                                GDestroyNotify key_destroy, GDestroyNotify value_destroy)
+{
+  LookupTable *table = g_new0(LookupTable, 1);
+  table->type = type;
+  table->slots = slots;
+  table->mask = capacity - 1;
+  table->size = size;
+  table->keyDestroy = key_destroy;
+  table->valueDestroy = value_destroy;
+  return table;
+}
+
+LookupTable *lookup_table_new_from_hash(GHashTable *source, LookupKeyType type)
+{
+  LookupTable *table = lookup_table_new(type, source ? g_hash_table_size(source) : 0);
+  if (!source)
+    return table;
+
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init(&iter, source);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    lookup_table_insert(table, key, value);
+  return table;
+}
+
+void lookup_table_free(LookupTable *table)
+{
+  if (!table)
+    return;
+  if (table->keyDestroy || table->valueDestroy)
+  {
+    for (guint64 i = 0; i <= table->mask; i++)
+    {
+      Slot *s = &table->slots[i];
+      if (s->hash == 0)
+        continue;
+      if (table->keyDestroy)
+        table->keyDestroy((gpointer)s->key);
+      if (table->valueDestroy)
+        table->valueDestroy(s->value);
+    }
+  }
+  g_free(table->slots);
+  g_free(table);
+}
+
+void lookup_table_insert(LookupTable *table, gconstpointer key, gpointer value)
+{
+  if (!table || (table->type == LOOKUP_KEY_STRING && !key))
+    return;
+
+  guint64 hash = lookup_table_hash(table->type, key);
+  for (guint64 i = hash & table->mask; table->slots[i].hash != 0; i = (i + 1) & table->mask)
+  {
+    Slot *s = &table->slots[i];
+    if (s->hash == hash && lookup_table_keys_equal(table->type, s->key, key))
+    {
+      // Like g_hash_table_insert(): keep the old key, drop the new one and the old value
+      if (table->keyDestroy)
+        table->keyDestroy((gpointer)key);
+      if (table->valueDestroy && s->value != value)
+        table->valueDestroy(s->value);
+      s->value = value;
+      return;
+    }
+  }
+
+  if ((guint64)(table->size + 1) * 2 > table->mask + 1)
+    grow(table);
+  place(table->slots, table->mask, hash, key, value);
+  table->size++;
+}
+
+// --- Lookups ---
+
+static gpointer probe(const LookupTable *table, guint64 hash, gconstpointer key)
+{
+  for (guint64 i = hash & table->mask; table->slots[i].hash != 0; i = (i + 1) & table->mask)
+  {
+    const Slot *s = &table->slots[i];
+    if (s->hash == hash && lookup_table_keys_equal(table->type, s->key, key))
+      return s->value;
+  }
+  return NULL;
+}
+
+gpointer lookup_table_get(const LookupTable *table, gconstpointer key)
+{
+  if (!table || (table->type == LOOKUP_KEY_STRING && !key))
+    return NULL;
+  return probe(table, lookup_table_hash(table->type, key), key);
+}
+
+void lookup_table_get_batch(const LookupTable *table, const gconstpointer *keys, guint n, gpointer *out)
+{
+  if (!table)
+  {
+    memset(out, 0, n * sizeof(gpointer));
+    return;
+  }
+
+  gboolean strings = table->type == LOOKUP_KEY_STRING;
+  guint64 hashes[LOOKUP_BATCH_GROUP];
+
+  for (guint base = 0; base < n; base += LOOKUP_BATCH_GROUP)
+  {
+    guint m = MIN(LOOKUP_BATCH_GROUP, n - base);
+
+    // 1. Hash the group and start loading every home slot
+    for (guint i = 0; i < m; i++)
+    {
+      gconstpointer key = keys[base + i];
+      hashes[i] = (strings && !key) ? 0 : lookup_table_hash(table->type, key);
+      if (hashes[i] != 0)
+        __builtin_prefetch(&table->slots[hashes[i] & table->mask]);
+    }
+
+    // 2. Start loading the stored keys that will have to be compared
+    if (strings)
+    {
+      for (guint i = 0; i < m; i++)
+      {
+        const Slot *s = &table->slots[hashes[i] & table->mask];
+        if (hashes[i] != 0 && s->hash == hashes[i])
+          __builtin_prefetch(s->key);
+      }
+    }
+
+    // 3. Resolve
+    for (guint i = 0; i < m; i++)
+      out[base + i] = hashes[i] != 0 ? probe(table, hashes[i], keys[base + i]) : NULL;
+  }
+}
+
+guint lookup_table_size(const LookupTable *table)
+{
+  return table ? table->size : 0;
+}
+
+void lookup_table_foreach(const LookupTable *table, GHFunc func, gpointer user_data)
+{
+  if (!table)
+    return;
+  for (guint64 i = 0; i <= table->mask; i++)
+  {
+    const Slot *s = &table->slots[i];
+    if (s->hash != 0)
+      func((gpointer)s->key, s->value, user_data);
+  }
+}
@@ -0,0 +1,147 @@
+#include "core/radix_sort.h"
+#include "core/dataset_parallel.h"
+#include <glib.h>
+#include <string.h>
+
+#define RADIX_BUCKETS 256
+#define RADIX_PASSES 8
+
+// Minimum number of elements handled by one chunk
+#define RADIX_GRAIN 16384
+
+// Flipping the sign bit makes unsigned byte order match signed order
+#define RADIX_SIGN_FLIP ((guint64)1 << 63)
+
+typedef struct
+{
+  guint start;
+  guint end;
+  guint hist[RADIX_BUCKETS];
+  guint offsets[RADIX_BUCKETS];
+} RadixChunk;
+
+typedef struct
+{
+  const guint64 *srcKeys;
+  const gconstpointer *srcItems;
+  guint64 *dstKeys;
+  gconstpointer *dstItems;
+  int shift;
+} RadixPass;
+
+// Rows of both phases are RadixChunk*, so every chunk keeps the same range in each pass
+static void histogram_body(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data)
+{
+  const RadixPass *pass = user_data;
+  (void)start;
+  (void)local;
+
+  for (guint r = 0; r < count; r++)
+  {
+    RadixChunk *chunk = (RadixChunk *)rows[r];
+    memset(chunk->hist, 0, sizeof(chunk->hist));
+    for (guint i = chunk->start; i < chunk->end; i++)
+      chunk->hist[(pass->srcKeys[i] >> pass->shift) & 0xFF]++;
+  }
+}
+
+static void scatter_body(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data)
+{
+  const RadixPass *pass = user_data;
+  (void)start;
+  (void)local;
+
+  for (guint r = 0; r < count; r++)
+  {
+    RadixChunk *chunk = (RadixChunk *)rows[r];
+    for (guint i = chunk->start; i < chunk->end; i++)
+    {
+      guint pos = chunk->offsets[(pass->srcKeys[i] >> pass->shift) & 0xFF]++;
+      pass->dstKeys[pos] = pass->srcKeys[i];
+      pass->dstItems[pos] = pass->srcItems[i];
+    }
+  }
+}
+
+void radix_sort_by_key(gint64 *keys, gconstpointer *items, guint n)
+{
+  if (!keys || !items || n < 2)
+    return;
+
+  // 1. Partition the input into one contiguous chunk per worker
+  guint nChunks = dataset_parallel_get_workers();
+  if (nChunks > n / RADIX_GRAIN)
+    nChunks = n / RADIX_GRAIN;
+  if (nChunks < 1)
+    nChunks = 1;
+
+  RadixChunk *chunks = g_new0(RadixChunk, nChunks);
+  gconstpointer *chunkRows = g_new(gconstpointer, nChunks);
+  for (guint c = 0; c < nChunks; c++)
+  {
+    chunks[c].start = (guint)(((guint64)n * c) / nChunks);
+    chunks[c].end = (guint)(((guint64)n * (c + 1)) / nChunks);
+    chunkRows[c] = &chunks[c];
+  }
+
+  // 2. Double buffers: keys as order-preserving unsigned values
+  guint64 *bufKeys[2] = {g_new(guint64, n), g_new(guint64, n)};
+  gconstpointer *bufItems[2] = {g_new(gconstpointer, n), g_new(gconstpointer, n)};
+  for (guint i = 0; i < n; i++)
+    bufKeys[0][i] = (guint64)keys[i] ^ RADIX_SIGN_FLIP;
+  memcpy(bufItems[0], items, n * sizeof(gconstpointer));
+
+  DatasetParallelOps histogramOps = {.body = histogram_body, .grain = 1};
+  DatasetParallelOps scatterOps = {.body = scatter_body, .grain = 1};
+  int cur = 0;
+
+  for (int p = 0; p < RADIX_PASSES; p++)
+  {
+    RadixPass pass = {
+        .srcKeys = bufKeys[cur],
+        .srcItems = bufItems[cur],
+        .dstKeys = bufKeys[1 - cur],
+        .dstItems = bufItems[1 - cur],
+        .shift = p * 8};
+
+    dataset_parallel_foreach_rows(chunkRows, nChunks, &histogramOps, &pass);
+
+    // 3. Skip the pass if every key has the same digit (it would be the identity)
+    gboolean uniform = FALSE;
+    for (int d = 0; d < RADIX_BUCKETS && !uniform; d++)
+    {
+      guint total = 0;
+      for (guint c = 0; c < nChunks; c++)
+        total += chunks[c].hist[d];
+      if (total == n)
+        uniform = TRUE;
+    }
+    if (uniform)
+      continue;
+
+    // 4. Exclusive prefix sums, digit-major then chunk order (keeps the sort stable)
+    guint running = 0;
+    for (int d = 0; d < RADIX_BUCKETS; d++)
+    {
+      for (guint c = 0; c < nChunks; c++)
+      {
+        chunks[c].offsets[d] = running;
+        running += chunks[c].hist[d];
+      }
+    }
+
+    dataset_parallel_foreach_rows(chunkRows, nChunks, &scatterOps, &pass);
+    cur = 1 - cur;
+  }
+
+  for (guint i = 0; i < n; i++)
+    keys[i] = (gint64)(bufKeys[cur][i] ^ RADIX_SIGN_FLIP);
+  memcpy(items, bufItems[cur], n * sizeof(gconstpointer));
+
+  g_free(bufKeys[0]);
+  g_free(bufKeys[1]);
+  g_free(bufItems[0]);
+  g_free(bufItems[1]);
+  g_free(chunkRows);
+  g_free(chunks);
+}
@@ -1,4 +1,5 @@
 #include "core/statistics.h"
+#include "core/dataset_parallel.h"
 #include "entities/access/reservations_access.h"
 #include "entities/access/flights_access.h"
 #include <string.h>
@@ -27,25 +28,73 @@ static AirportPassengerStats *getOrCreateStats(GHashTable *stats, const char *co
     return s;
 }
 
-GHashTable *calculate_airport_traffic(const GHashTable *reservations,
-                                      const GHashTable *flights)
+static GHashTable *newStatsTable(void)
 {
-    if (!reservations || !flights)
+    return g_hash_table_new_full(g_str_hash, g_str_equal,
+                                 g_free, freeAirportPassengerStats);
+}
+
+// Receives the flights of a batch of legs (NULL for the ones not found)
+typedef void (*LegsFunc)(gpointer local, const Flight *const *flights, guint n);
+
+// Read-only dataset for the workers, destination table for the combine step
+typedef struct
+{
+    const Dataset *ds;
+    GHashTable *totals;
+    LegsFunc countLegs;
+} TrafficJob;
+
+// Legs resolved per batch lookup
+#define TRAFFIC_BATCH 256
+
+static gpointer trafficLocalNew(gpointer user_data)
+{
+    (void)user_data;
+    return newStatsTable();
+}
+
+static void countLegs(gpointer local, const Flight *const *flights, guint n)
+{
+    GHashTable *stats = local;
+    for (guint i = 0; i < n; i++)
     {
-        return NULL;
-    }
+        const Flight *flight = flights[i];
+        if (!flight)
+            continue;
+
+        const char *status = getFlightStatus(flight);
+        if (status && strcmp(status, "Cancelled") == 0)
+        {
+            continue;
+        }
 
-    GHashTable *stats = g_hash_table_new_full(g_str_hash, g_str_equal,
-                                              g_free, freeAirportPassengerStats);
+        const char *orig = getFlightOrigin(flight);
+        const char *dest = getFlightDestination(flight);
 
-    GHashTableIter iter;
-    gpointer key, value;
+        if (orig)
+            getOrCreateStats(stats, orig)->departures++;
 
-    g_hash_table_iter_init(&iter, (GHashTable *)reservations);
+        if (dest)
+            getOrCreateStats(stats, dest)->arrivals++;
+    }
+}
 
-    while (g_hash_table_iter_next(&iter, &key, &value))
+static void trafficBody(const void *const *rows, guint start, guint count,
+                        gpointer local, gpointer user_data)
+{
+    const TrafficJob *job = user_data;
+    (void)start;
+
+    // Gather the legs of consecutive reservations and resolve them in batches,
+    // so the flight lookups overlap their cache misses
+    const char *ids[TRAFFIC_BATCH];
+    const Flight *flights[TRAFFIC_BATCH];
+    guint pending = 0;
+
+    for (guint r = 0; r < count; r++)
     {
-        const Reservation *res = value;
+        const Reservation *res = rows[r];
         if (!res)
             continue;
 
@@ -60,26 +109,53 @@ GHashTable *calculate_airport_traffic(const GHashTable *reservations,
                 continue;
             }
 
-            const Flight *flight = getFlight(flightIds[i], flights);
-            if (!flight)
-                continue;
-
-            const char *status = getFlightStatus(flight);
-            if (status && strcmp(status, "Cancelled") == 0)
+            ids[pending++] = flightIds[i];
+            if (pending == TRAFFIC_BATCH)
             {
-                continue;
+                dataset_get_flights_batch(job->ds, ids, pending, flights);
+                job->countLegs(local, flights, pending);
+                pending = 0;
             }
+        }
+    }
 
-            const char *orig = getFlightOrigin(flight);
-            const char *dest = getFlightDestination(flight);
+    dataset_get_flights_batch(job->ds, ids, pending, flights);
+    job->countLegs(local, flights, pending);
+}
 
-            if (orig)
-                getOrCreateStats(stats, orig)->departures++;
+static void trafficCombine(gpointer local, gpointer user_data)
+{
+    GHashTable *partial = local;
+    GHashTable *stats = ((TrafficJob *)user_data)->totals;
 
-            if (dest)
-                getOrCreateStats(stats, dest)->arrivals++;
-        }
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, partial);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        const AirportPassengerStats *part = value;
+        AirportPassengerStats *s = getOrCreateStats(stats, key);
+        s->arrivals += part->arrivals;
+        s->departures += part->departures;
     }
+    g_hash_table_destroy(partial);
+}
+
+GHashTable *calculate_airport_traffic(const Dataset *ds)
+{
+    if (!ds)
+    {
+        return NULL;
+    }
+
+    GHashTable *stats = newStatsTable();
+
+    guint count = 0;
+    const Reservation *const *rows = dataset_reservation_rows(ds, &count);
+
+    TrafficJob job = {.ds = ds, .totals = stats, .countLegs = countLegs};
+    DatasetParallelOps ops = {.local_new = trafficLocalNew, .body = trafficBody, .combine = trafficCombine};
+    dataset_parallel_foreach_rows((const void *const *)rows, count, &ops, &job);
 
     return stats;
 }
@@ -92,4 +168,201 @@ long getAirportArrivals(const AirportPassengerStats *s)
 long getAirportDepartures(const AirportPassengerStats *s)
 {
     return s ? s->departures : 0;
-}
\ No newline at end of file
+}
+// --- Daily Traffic ---
+
+#define SECONDS_PER_DAY 86400
+
+struct airport_daily_traffic
+{
+    guint n;          // Distinct days with traffic
+    time_t *days;     // Start of each day, ascending
+    long *arrivals;   // arrivals[i]: passengers arrived before days[i] (n + 1 entries)
+    long *departures; // Same, for departures
+};
+
+// One flight's passengers, on the day they left or arrived at an airport
+typedef struct
+{
+    const char *code;
+    time_t day;
+    long arrivals;
+    long departures;
+} DailyEvent;
+
+void freeAirportDailyTraffic(gpointer data)
+{
+    AirportDailyTraffic *t = data;
+    if (!t)
+        return;
+    g_free(t->days);
+    g_free(t->arrivals);
+    g_free(t->departures);
+    g_free(t);
+}
+
+static gpointer flightLegsLocalNew(gpointer user_data)
+{
+    (void)user_data;
+    return g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+// Counts the passengers of every operated flight: Flight* -> count
+static void countFlightLegs(gpointer local, const Flight *const *flights, guint n)
+{
+    GHashTable *counts = local;
+    for (guint i = 0; i < n; i++)
+    {
+        const Flight *flight = flights[i];
+        if (!flight)
+            continue;
+
+        const char *status = getFlightStatus(flight);
+        if (status && strcmp(status, "Cancelled") == 0)
+            continue;
+
+        gpointer key = (gpointer)flight;
+        guint count = GPOINTER_TO_UINT(g_hash_table_lookup(counts, key));
+        g_hash_table_insert(counts, key, GUINT_TO_POINTER(count + 1));
+    }
+}
+
+static void flightLegsCombine(gpointer local, gpointer user_data)
+{
+    GHashTable *partial = local;
+    GHashTable *counts = ((TrafficJob *)user_data)->totals;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, partial);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        guint count = GPOINTER_TO_UINT(g_hash_table_lookup(counts, key));
+        g_hash_table_insert(counts, key, GUINT_TO_POINTER(count + GPOINTER_TO_UINT(value)));
+    }
+    g_hash_table_destroy(partial);
+}
+
+static gint compareDailyEvents(gconstpointer a, gconstpointer b)
+{
+    const DailyEvent *ea = a;
+    const DailyEvent *eb = b;
+    int cmp = strcmp(ea->code, eb->code);
+    if (cmp != 0)
+        return cmp;
+    return (ea->day > eb->day) - (ea->day < eb->day);
+}
+
+// Builds the prefix sums of one airport from its events, sorted by day
+static AirportDailyTraffic *buildDailyTraffic(const DailyEvent *events, guint count)
+{
+    AirportDailyTraffic *t = g_new0(AirportDailyTraffic, 1);
+    t->days = g_new(time_t, count);
+    t->arrivals = g_new0(long, count + 1);
+    t->departures = g_new0(long, count + 1);
+
+    for (guint i = 0; i < count; i++)
+    {
+        if (t->n == 0 || t->days[t->n - 1] != events[i].day)
+        {
+            t->days[t->n] = events[i].day;
+            t->arrivals[t->n + 1] = t->arrivals[t->n];
+            t->departures[t->n + 1] = t->departures[t->n];
+            t->n++;
+        }
+        t->arrivals[t->n] += events[i].arrivals;
+        t->departures[t->n] += events[i].departures;
+    }
+    return t;
+}
+
+static void addDailyEvent(GArray *events, const char *code, time_t when, long arrivals, long departures)
+{
+    if (!code || when < 0)
+        return;
+    DailyEvent event = {.code = code,
+                        .day = when - (when % SECONDS_PER_DAY),
+                        .arrivals = arrivals,
+                        .departures = departures};
+    g_array_append_val(events, event);
+}
+
+GHashTable *calculate_airport_daily_traffic(const Dataset *ds)
+{
+    if (!ds)
+    {
+        return NULL;
+    }
+
+    // 1. Passengers per flight, from the legs of every reservation
+    GHashTable *flightCounts = g_hash_table_new(g_direct_hash, g_direct_equal);
+    guint count = 0;
+    const Reservation *const *rows = dataset_reservation_rows(ds, &count);
+
+    TrafficJob job = {.ds = ds, .totals = flightCounts, .countLegs = countFlightLegs};
+    DatasetParallelOps ops = {.local_new = flightLegsLocalNew, .body = trafficBody, .combine = flightLegsCombine};
+    dataset_parallel_foreach_rows((const void *const *)rows, count, &ops, &job);
+
+    // 2. Each flight moves its passengers out of the origin and into the destination
+    GArray *events = g_array_sized_new(FALSE, FALSE, sizeof(DailyEvent), 2 * g_hash_table_size(flightCounts));
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, flightCounts);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        const Flight *flight = key;
+        long passengers = (long)GPOINTER_TO_UINT(value);
+        addDailyEvent(events, getFlightOrigin(flight), getFlightActualDeparture(flight), 0, passengers);
+        addDailyEvent(events, getFlightDestination(flight), getFlightActualArrival(flight), passengers, 0);
+    }
+    g_hash_table_destroy(flightCounts);
+
+    // 3. Grouped by airport, in day order: one run of events per airport
+    g_array_sort(events, compareDailyEvents);
+    GHashTable *traffic = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeAirportDailyTraffic);
+    const DailyEvent *all = (const DailyEvent *)events->data;
+    guint start = 0;
+    while (start < events->len)
+    {
+        guint end = start + 1;
+        while (end < events->len && strcmp(all[end].code, all[start].code) == 0)
+            end++;
+        g_hash_table_insert(traffic, g_strdup(all[start].code), buildDailyTraffic(all + start, end - start));
+        start = end;
+    }
+    g_array_free(events, TRUE);
+
+    return traffic;
+}
+
+// Index of the first day not before @p when (n if there is none)
+static guint firstDayFrom(const AirportDailyTraffic *t, time_t when)
+{
+    guint lower = 0, upper = t->n;
+    while (lower < upper)
+    {
+        guint mid = lower + (upper - lower) / 2;
+        if (t->days[mid] < when)
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+    return lower;
+}
+
+void getAirportTrafficBetween(const AirportDailyTraffic *t, time_t from, time_t to, long *arrivals,
+                              long *departures)
+{
+    *arrivals = 0;
+    *departures = 0;
+    if (!t || to < from)
+        return;
+
+    // Days in [from, to]: the whole last day counts
+    guint lo = firstDayFrom(t, from - (from % SECONDS_PER_DAY));
+    guint hi = firstDayFrom(t, to - (to % SECONDS_PER_DAY) + SECONDS_PER_DAY);
+    if (hi <= lo)
+        return;
+    *arrivals = t->arrivals[hi] - t->arrivals[lo];
+    *departures = t->departures[hi] - t->departures[lo];
+}
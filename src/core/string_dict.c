@@ -0,0 +1,261 @@
+#include "core/string_dict.h"
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct string_dict
+{
+  gchar *pool;          // All entries, NUL-terminated, back to back
+  const char **exact;   // Entries in strcmp order
+  const char **folded;  // Same entries in case-insensitive order
+  guint size;
+  gsize maxLen;
+};
+
+// --- Construction ---
+
+static gint compare_exact(gconstpointer a, gconstpointer b)
+{
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+static gint compare_folded(gconstpointer a, gconstpointer b)
+{
+  const char *sa = *(const char *const *)a;
+  const char *sb = *(const char *const *)b;
+  gint cmp = g_ascii_strcasecmp(sa, sb);
+  return cmp != 0 ? cmp : strcmp(sa, sb);
+}
+
+StringDict *string_dict_new(const GPtrArray *strings)
+{
+  StringDict *dict = g_new0(StringDict, 1);
+  guint n = strings ? strings->len : 0;
+
+  // 1. Sort references to the source strings and drop duplicates
+  const char **sorted = g_new(const char *, n > 0 ? n : 1);
+  guint valid = 0;
+  for (guint i = 0; i < n; i++)
+  {
+    const char *s = g_ptr_array_index((GPtrArray *)strings, i);
+    if (s)
+      sorted[valid++] = s;
+  }
+  qsort(sorted, valid, sizeof(const char *), compare_exact);
+
+  guint unique = 0;
+  gsize poolSize = 0;
+  for (guint i = 0; i < valid; i++)
+  {
+    if (unique > 0 && strcmp(sorted[unique - 1], sorted[i]) == 0)
+      continue;
+    sorted[unique++] = sorted[i];
+    poolSize += strlen(sorted[i]) + 1;
+  }
+
+  // 2. Copy the survivors into one contiguous pool
+  dict->pool = g_malloc(poolSize > 0 ? poolSize : 1);
+  dict->exact = g_new(const char *, unique > 0 ? unique : 1);
+  dict->folded = g_new(const char *, unique > 0 ? unique : 1);
+  dict->size = unique;
+
+  gchar *cursor = dict->pool;
+  for (guint i = 0; i < unique; i++)
+  {
+    gsize len = strlen(sorted[i]);
+    memcpy(cursor, sorted[i], len + 1);
+    dict->exact[i] = cursor;
+    dict->folded[i] = cursor;
+    if (len > dict->maxLen)
+      dict->maxLen = len;
+    cursor += len + 1;
+  }
+  g_free(sorted);
+
+  // 3. Case-insensitive view
+  qsort(dict->folded, unique, sizeof(const char *), compare_folded);
+
+  return dict;
+}
+
+void string_dict_free(StringDict *dict)
+{
+  if (!dict)
+    return;
+  g_free(dict->pool);
+  g_free(dict->exact);
+  g_free(dict->folded);
+  g_free(dict);
+}
+
+// --- Lookups ---
+
+guint string_dict_size(const StringDict *dict)
+{
+  return dict ? dict->size : 0;
+}
+
+const char *const *string_dict_entries(const StringDict *dict, guint *count)
+{
+  if (count)
+    *count = dict ? dict->size : 0;
+  return (dict && dict->size > 0) ? dict->exact : NULL;
+}
+
+// First index in [0, n) for which cmp(entries[i], prefix, len) >= bound
+static guint search_prefix(const char *const *entries, guint n, const char *prefix, gsize len,
+                           int (*cmp)(const char *, const char *, gsize), int bound)
+{
+  guint lo = 0, hi = n;
+  while (lo < hi)
+  {
+    guint mid = lo + (hi - lo) / 2;
+    if (cmp(entries[mid], prefix, len) < bound)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static int ncmp_exact(const char *a, const char *b, gsize n)
+{
+  return strncmp(a, b, n);
+}
+
+static int ncmp_folded(const char *a, const char *b, gsize n)
+{
+  return g_ascii_strncasecmp(a, b, n);
+}
+
+static const char *const *prefix_span(const char *const *entries, guint n, const char *prefix,
+                                      int (*cmp)(const char *, const char *, gsize), guint *count)
+{
+  gsize len = strlen(prefix);
+  // Entries sharing the prefix compare equal on its length: [first, last) is that run
+  guint first = search_prefix(entries, n, prefix, len, cmp, 0);
+  guint last = search_prefix(entries, n, prefix, len, cmp, 1);
+  if (count)
+    *count = last - first;
+  return first < last ? entries + first : NULL;
+}
+
+gboolean string_dict_contains(const StringDict *dict, const char *str)
+{
+  if (!dict || !str)
+    return FALSE;
+  const char *key = str;
+  return bsearch(&key, dict->exact, dict->size, sizeof(const char *), compare_exact) != NULL;
+}
+
+const char *const *string_dict_prefix(const StringDict *dict, const char *prefix, guint *count)
+{
+  if (count)
+    *count = 0;
+  if (!dict || !prefix)
+    return NULL;
+  return prefix_span(dict->exact, dict->size, prefix, ncmp_exact, count);
+}
+
+const char *const *string_dict_prefix_ci(const StringDict *dict, const char *prefix, guint *count)
+{
+  if (count)
+    *count = 0;
+  if (!dict || !prefix)
+    return NULL;
+  return prefix_span(dict->folded, dict->size, prefix, ncmp_folded, count);
+}
+
+// --- Fuzzy Matching ---
+
+typedef struct
+{
+  const char *entry;
+  guint distance;
+} FuzzyMatch;
+
+static gint compare_fuzzy(gconstpointer a, gconstpointer b)
+{
+  const FuzzyMatch *ma = a;
+  const FuzzyMatch *mb = b;
+  if (ma->distance != mb->distance)
+    return ma->distance < mb->distance ? -1 : 1;
+  return strcmp(ma->entry, mb->entry);
+}
+
+/*
+ * Levenshtein distance between the query and the closest prefix of the entry.
+ * Rows run over the query, columns over the entry; the answer is the minimum of
+ * the last row. Stops as soon as a whole row exceeds the bound.
+ */
+static guint prefix_distance(const char *query, gsize qLen, const char *entry, guint *prev, guint *cur,
+                             guint bound)
+{
+  gsize eLen = strlen(entry);
+  for (gsize j = 0; j <= eLen; j++)
+    prev[j] = 0; // Any prefix of the entry may be chosen for free
+
+  for (gsize i = 1; i <= qLen; i++)
+  {
+    cur[0] = (guint)i;
+    guint rowMin = cur[0];
+    gchar qc = g_ascii_tolower(query[i - 1]);
+    for (gsize j = 1; j <= eLen; j++)
+    {
+      guint cost = (qc == g_ascii_tolower(entry[j - 1])) ? 0 : 1;
+      guint best = prev[j - 1] + cost;
+      if (prev[j] + 1 < best)
+        best = prev[j] + 1;
+      if (cur[j - 1] + 1 < best)
+        best = cur[j - 1] + 1;
+      cur[j] = best;
+      if (best < rowMin)
+        rowMin = best;
+    }
+    if (rowMin > bound)
+      return bound + 1;
+    guint *tmp = prev;
+    prev = cur;
+    cur = tmp;
+  }
+
+  // Here prev holds row qLen: prev[j] = distance(query, entry[0..j))
+  guint best = prev[0];
+  for (gsize j = 1; j <= eLen; j++)
+  {
+    if (prev[j] < best)
+      best = prev[j];
+  }
+  return best;
+}
+
+GPtrArray *string_dict_fuzzy(const StringDict *dict, const char *query, guint maxDistance)
+{
+  GPtrArray *result = g_ptr_array_new();
+  if (!dict || !query || dict->size == 0)
+    return result;
+
+  gsize qLen = strlen(query);
+  guint *prev = g_new(guint, dict->maxLen + 1);
+  guint *cur = g_new(guint, dict->maxLen + 1);
+
+  GArray *matches = g_array_new(FALSE, FALSE, sizeof(FuzzyMatch));
+  for (guint i = 0; i < dict->size; i++)
+  {
+    guint d = prefix_distance(query, qLen, dict->exact[i], prev, cur, maxDistance);
+    if (d <= maxDistance)
+    {
+      FuzzyMatch m = {dict->exact[i], d};
+      g_array_append_val(matches, m);
+    }
+  }
+  g_array_sort(matches, compare_fuzzy);
+
+  for (guint i = 0; i < matches->len; i++)
+    g_ptr_array_add(result, (gpointer)g_array_index(matches, FuzzyMatch, i).entry);
+
+  g_array_free(matches, TRUE);
+  g_free(prev);
+  g_free(cur);
+  return result;
+}
@@ -182,6 +182,23 @@ time_t parse_unix_date(const char *dt, int *cancelFlag) {
   return seconds;
 }
 
+gboolean parse_date_argument(const char *token, time_t *day) {
+  if (!token || strlen(token) != 10)
+    return FALSE;
+  for (int i = 0; i < 10; i++) {
+    if (i == 4 || i == 7 ? token[i] != '-' : (token[i] < '0' || token[i] > '9'))
+      return FALSE;
+  }
+
+  // Dates before 1970 are negative too; the error codes are the only results
+  // that are not whole days
+  time_t parsed = parse_unix_date(token, NULL);
+  if (parsed % 86400 != 0)
+    return FALSE;
+  *day = parsed;
+  return TRUE;
+}
+
 int compare_time_pointers(gconstpointer a, gconstpointer b) {
   time_t t1 = *(const time_t *)a;
   time_t t2 = *(const time_t *)b;
@@ -7,58 +7,68 @@
 #include "interactive/completion.h"
 #include "core/dataset.h"
 
-// Local cache for autocompletion strings
-// We own these arrays and the strings inside them (via g_strdup)
-static GPtrArray *active_airport_codes = NULL;
-static GPtrArray *active_aircraft_manufs = NULL;
-static GPtrArray *active_nationalities = NULL;
-
-// Helper to populate a local cache using the Dataset Iterator API
-static GPtrArray *populate_cache(Dataset *ds, DatasetStringIterator *(*iter_ctor)(Dataset *))
+// Dictionaries of the active dataset, borrowed (never copied): the shell keeps
+// the dataset alive for as long as it is the completion context
+static const StringDict *active_airport_codes = NULL;
+static const StringDict *active_aircraft_manufs = NULL;
+static const StringDict *active_nationalities = NULL;
+
+void update_completion_context(Dataset *ds)
 {
-    if (!ds)
-        return NULL;
+    active_airport_codes = dataset_airport_codes_dict(ds);
+    active_aircraft_manufs = dataset_aircraft_manufacturers_dict(ds);
+    active_nationalities = dataset_nationalities_dict(ds);
+}
 
-    GPtrArray *cache = g_ptr_array_new_with_free_func(g_free);
-    DatasetStringIterator *it = iter_ctor(ds);
-    const char *str;
+// Candidates for one completion request: a span into the dictionary, or the
+// fuzzy fallback list when nothing matches the typed prefix
+typedef struct
+{
+    const char *const *items;
+    guint len;
+    guint idx;
+    GPtrArray *fuzzy;
+} DictCursor;
 
-    while ((str = dataset_string_iter_next(it)) != NULL)
+static void dict_cursor_reset(DictCursor *cur, const StringDict *dict, const char *str)
+{
+    if (cur->fuzzy)
     {
-        // Duplicate string to ensure completion context owns its data
-        g_ptr_array_add(cache, g_strdup(str));
+        g_ptr_array_free(cur->fuzzy, TRUE);
+        cur->fuzzy = NULL;
     }
+    cur->idx = 0;
+    cur->items = string_dict_prefix(dict, str, &cur->len);
+    if (cur->len > 0)
+        return;
+
+    cur->items = string_dict_prefix_ci(dict, str, &cur->len);
+    if (cur->len > 0 || !*str)
+        return;
 
-    dataset_string_iter_free(it);
-    return cache;
+    // Allow one typo, two for longer words
+    guint maxDistance = strlen(str) > 4 ? 2 : 1;
+    cur->fuzzy = string_dict_fuzzy(dict, str, maxDistance);
+    cur->items = (const char *const *)cur->fuzzy->pdata;
+    cur->len = cur->fuzzy->len;
 }
 
-void update_completion_context(Dataset *ds)
+static char *dict_cursor_next(DictCursor *cur)
 {
-    // 1. Clean up existing cache
-    if (active_airport_codes)
-    {
-        g_ptr_array_unref(active_airport_codes);
-        active_airport_codes = NULL;
-    }
-    if (active_aircraft_manufs)
-    {
-        g_ptr_array_unref(active_aircraft_manufs);
-        active_aircraft_manufs = NULL;
-    }
-    if (active_nationalities)
-    {
-        g_ptr_array_unref(active_nationalities);
-        active_nationalities = NULL;
-    }
+    if (cur->idx < cur->len)
+        return strdup(cur->items[cur->idx++]);
+    return NULL;
+}
 
-    if (!ds)
-        return;
+static char *dict_gen(DictCursor *cur, const StringDict *dict, const char *str, int state)
+{
+    if (!dict)
+        return NULL;
 
-    // 2. Re-populate using the safe public API
-    active_airport_codes = populate_cache(ds, dataset_airport_codes_iter_new);
-    active_aircraft_manufs = populate_cache(ds, dataset_aircraft_manufacturers_iter_new);
-    active_nationalities = populate_cache(ds, dataset_nationalities_iter_new);
+    if (!state)
+        dict_cursor_reset(cur, dict, str);
+
+    return dict_cursor_next(cur);
 }
 
 // --- Generators  ---
@@ -88,7 +98,7 @@ char *main_command_gen(const char *str, int state)
 
 char *query_command_gen(const char *str, int state)
 {
-    static char *query_commands[] = {"1", "2", "3", "4", "5", "6", NULL};
+    static char *query_commands[] = {"1", "2", "3", "4", "5", "6", "7", NULL};
     static int idx, len;
     char *cmd;
 
@@ -128,77 +138,20 @@ char *view_command_gen(const char *str, int state)
 
 char *airport_code_gen(const char *str, int state)
 {
-    static guint idx;
-    static int len;
-
-    if (!active_airport_codes)
-        return NULL;
-
-    if (!state)
-    {
-        idx = 0;
-        len = strlen(str);
-    }
-
-    while (idx < active_airport_codes->len)
-    {
-        char *code = g_ptr_array_index(active_airport_codes, idx++);
-        if (strncmp(code, str, len) == 0)
-        {
-            return strdup(code);
-        }
-    }
-    return NULL;
+    static DictCursor cursor;
+    return dict_gen(&cursor, active_airport_codes, str, state);
 }
 
 char *aircraft_manufs_gen(const char *str, int state)
 {
-    static guint idx;
-    static int len;
-
-    if (!active_aircraft_manufs)
-        return NULL;
-
-    if (!state)
-    {
-        idx = 0;
-        len = strlen(str);
-    }
-
-    while (idx < active_aircraft_manufs->len)
-    {
-        char *manuf = g_ptr_array_index(active_aircraft_manufs, idx++);
-        if (strncmp(manuf, str, len) == 0)
-        {
-            return strdup(manuf);
-        }
-    }
-    return NULL;
+    static DictCursor cursor;
+    return dict_gen(&cursor, active_aircraft_manufs, str, state);
 }
 
 char *nationality_gen(const char *str, int state)
 {
-    static guint idx;
-    static int len;
-
-    if (!active_nationalities)
-        return NULL;
-
-    if (!state)
-    {
-        idx = 0;
-        len = strlen(str);
-    }
-
-    while (idx < active_nationalities->len)
-    {
-        char *nat = g_ptr_array_index(active_nationalities, idx++);
-        if (strncmp(nat, str, len) == 0)
-        {
-            return strdup(nat);
-        }
-    }
-    return NULL;
+    static DictCursor cursor;
+    return dict_gen(&cursor, active_nationalities, str, state);
 }
 
 char *shell_cmd_generator(const char *text, int state)
@@ -122,7 +122,7 @@ int query5wrapper(char *arg1, FILE *stream, GList *airlineDelays, int isSpecial)
     return 0;
 }
 
-int query6wrapper(char *arg1, FILE *stream, GHashTable *natTable, int isSpecial)
+int query6wrapper(char *arg1, FILE *stream, const LookupTable *natTable, int isSpecial)
 {
     if (!arg1 || strlen(arg1) == 0)
     {
@@ -16,14 +16,43 @@
 #include "core/utils.h"
 #include "core/time_utils.h"
 #include "io/validation/validation_utils.h"
-#include "io/manager.h"
 #include "queries/queries.h"
+#include "queries/generation.h"
 #define CLEAR clear_screen()
 
-extern QueryManager *query_manager_create(Dataset *ds);
-extern void query_manager_destroy(QueryManager *qm);
 extern int query_manager_execute(QueryManager *qm, int queryId, char *arg1, char *arg2,
-                                 int isSpecial, FILE *output, Dataset *ds);
+                                 int isSpecial, FILE *output, Dataset *ds, gboolean *cached);
+
+// Swaps in a finished background load, if there is one
+static void poll_pending_build(GenerationBuild **pending, GenerationSlot *slot, char **dataset_path_ptr)
+{
+    if (!*pending || !generation_build_is_done(*pending))
+        return;
+
+    char *path = strdup(generation_build_get_path(*pending));
+    gint errors = 0;
+    Generation *gen = generation_build_finish(*pending, &errors);
+    *pending = NULL;
+
+    if (!gen)
+    {
+        printf(ANSI_COLOR_RED "Failed to load the dataset. Keeping the current dataset.\n" ANSI_RESET);
+        free(path);
+        return;
+    }
+
+    update_completion_context(generation_get_dataset(gen));
+    generation_slot_publish(slot, gen);
+
+    if (errors != 0)
+        printf(ANSI_COLOR_RED "Dataset loaded with errors.\n" ANSI_RESET);
+    else
+        printf(ANSI_COLOR_GREEN "Dataset loaded successfully!\n" ANSI_RESET);
+    save_dataset_path(path);
+    if (*dataset_path_ptr)
+        free(*dataset_path_ptr);
+    *dataset_path_ptr = path;
+}
 
 int interactive_mode(Dataset **ds_ref, char **dataset_path_ptr)
 {
@@ -32,16 +61,18 @@ int interactive_mode(Dataset **ds_ref, char **dataset_path_ptr)
     update_completion_context(*ds_ref);
     read_history(".apphistory");
 
-    QueryManager *qm = NULL;
-    if (*ds_ref)
-    {
-        qm = query_manager_create(*ds_ref);
-    }
+    // The shell takes ownership of the initial dataset
+    GenerationSlot *slot = generation_slot_new(generation_new(*ds_ref));
+    *ds_ref = NULL;
+    GenerationBuild *pending = NULL;
 
     // ===== MAIN LOOP =====
     while (1)
     {
+        poll_pending_build(&pending, slot, dataset_path_ptr);
         print_options();
+        if (pending)
+            printf(ANSI_DIM "A new dataset is loading in the background...\n" ANSI_RESET);
         input = readline(ANSI_BOLD "> " ANSI_RESET);
 
         if (!input)
@@ -156,6 +187,15 @@ int interactive_mode(Dataset **ds_ref, char **dataset_path_ptr)
                         trim_whitespace(input);
                         arg1 = strdup(input);
                     }
+                    // QUERY 7
+                    else if (queryNum == 7)
+                    {
+                        free(input);
+                        rl_attempted_completion_function = NULL;
+                        input = readline("Document number: ");
+                        trim_whitespace(input);
+                        arg1 = strdup(input);
+                    }
                     else
                     {
                         valid = 0;
@@ -163,20 +203,24 @@ int interactive_mode(Dataset **ds_ref, char **dataset_path_ptr)
 
                     rl_attempted_completion_function = main_completion;
 
-                    if (valid && qm)
+                    // Pin the current generation for the duration of the query
+                    Generation *gen = generation_slot_acquire(slot);
+                    if (valid && gen)
                     {
                         CLEAR;
                         printf(ANSI_BOLD "Query %d Result:\n" ANSI_RESET, queryNum);
 
-                        query_manager_execute(qm, queryNum, arg1, arg2, special, stdout, *ds_ref);
+                        query_manager_execute(generation_get_manager(gen), queryNum, arg1, arg2, special,
+                                              stdout, generation_get_dataset(gen), NULL);
 
                         free(readline(ANSI_DIM "\nPress ENTER to return..." ANSI_RESET));
                     }
-                    else if (!qm)
+                    else if (!gen)
                     {
                         printf(ANSI_COLOR_RED "Dataset not loaded!\n" ANSI_RESET);
                         free(readline(ANSI_DIM "\nPress ENTER to return..." ANSI_RESET));
                     }
+                    generation_unref(gen);
 
                     if (arg1)
                         free(arg1);
@@ -213,33 +257,15 @@ int interactive_mode(Dataset **ds_ref, char **dataset_path_ptr)
                 if (input)
                 {
                     trim_whitespace(input);
-                    if (validate_dataset_files(input))
+                    if (pending)
                     {
-                        printf("Reloading dataset...\n");
-
-                        if (qm)
-                            query_manager_destroy(qm);
-                        qm = NULL;
-
-                        cleanupDataset(*ds_ref);
-
-                        *ds_ref = initDataset();
-                        gint errors = 0;
-                        loadAllDatasets(*ds_ref, &errors, input, FALSE);
-
-                        qm = query_manager_create(*ds_ref);
-
-                        if (errors != 0)
-                            printf(ANSI_COLOR_RED "Dataset loaded with errors.\n" ANSI_RESET);
-                        else
-                        {
-                            printf(ANSI_COLOR_GREEN "Dataset loaded successfully!\n" ANSI_RESET);
-                            save_dataset_path(input);
-                            if (*dataset_path_ptr)
-                                free(*dataset_path_ptr);
-                            *dataset_path_ptr = strdup(input);
-                            update_completion_context(*ds_ref);
-                        }
+                        printf(ANSI_COLOR_YELLOW "Another dataset is still loading, please wait.\n" ANSI_RESET);
+                    }
+                    else if (validate_dataset_files(input))
+                    {
+                        // Queries keep running on the current dataset until the new one is swapped in
+                        pending = generation_build_start(input);
+                        printf("Loading dataset in the background...\n");
                     }
                     free(readline("Press ENTER to continue..."));
                 }
@@ -255,8 +281,13 @@ int interactive_mode(Dataset **ds_ref, char **dataset_path_ptr)
 
     // Cleanup
     write_history(".apphistory");
-    if (qm)
-        query_manager_destroy(qm);
+    if (pending)
+    {
+        printf("Waiting for the background load to finish...\n");
+        generation_unref(generation_build_finish(pending, NULL));
+    }
+    update_completion_context(NULL);
+    generation_slot_free(slot);
 
     return 0;
 }
\ No newline at end of file
@@ -33,5 +33,7 @@ void print_queries(void) {
                      "\tLists airlines with top N average delays.\n");
     printf(ANSI_BOLD "[6]" ANSI_RESET " Passenger statistics by nationality\n"
                      "\tLists airport with most passengers for a nationality.\n");
+    printf(ANSI_BOLD "[7]" ANSI_RESET " Passenger itinerary\n"
+                     "\tLists every reservation and flight of a passenger, with times and spend.\n");
     printf("\n");
 }
\ No newline at end of file
@@ -0,0 +1,704 @@
+#include "io/dataset_image.h"
+#include "core/dataset_loader.h"
+#include "core/statistics.h"
+#include "entities/access/aircrafts_access.h"
+#include "entities/access/airports_access.h"
+#include "entities/access/flights_access.h"
+#include "entities/access/passengers_access.h"
+#include "entities/access/reservations_access.h"
+#include "entities/internal/aircrafts_internal.h"
+#include "entities/internal/airports_internal.h"
+#include "entities/internal/flights_internal.h"
+#include "entities/internal/passengers_internal.h"
+#include "entities/internal/reservations_internal.h"
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMAGE_MAGIC 0x31495344u // "DSI1"
+#define IMAGE_VERSION 1u
+#define IMAGE_ALIGN 8
+#define IMAGE_NULL_REF G_MAXUINT32
+
+// --- On-Disk Layout ---
+
+typedef enum
+{
+    SECTION_STRINGS, // bytes
+    SECTION_FLIGHTS,
+    SECTION_PASSENGERS,
+    SECTION_AIRPORTS,
+    SECTION_AIRCRAFTS,
+    SECTION_RESERVATIONS,
+    SECTION_LEGS, // StrRef (flight IDs of every reservation, back to back)
+    SECTION_AIRPORT_CODES,
+    SECTION_MANUFACTURERS,
+    SECTION_NATIONALITIES,
+    SECTION_COUNT
+} ImageSectionId;
+
+typedef struct
+{
+    guint64 offset; // From the start of the image
+    guint64 count;  // Number of elements
+} ImageSection;
+
+typedef struct
+{
+    guint32 magic;
+    guint32 version;
+    guint64 size;
+    ImageSection sections[SECTION_COUNT];
+} ImageHeader;
+
+// Offset of a string in the pool, or IMAGE_NULL_REF
+typedef guint32 StrRef;
+
+typedef struct
+{
+    gint64 departure;
+    gint64 actualDeparture;
+    gint64 arrival;
+    gint64 actualArrival;
+    StrRef id, origin, destination, aircraft, airline;
+    guint32 status;
+} ImageFlight;
+
+typedef struct
+{
+    gint64 dob;
+    gint32 documentNo;
+    StrRef firstName, lastName, nationality;
+    gint32 gender;
+    guint32 reserved;
+} ImagePassenger;
+
+typedef struct
+{
+    StrRef code, name, city, country, type;
+} ImageAirport;
+
+typedef struct
+{
+    StrRef id, manufacturer, model;
+} ImageAircraft;
+
+typedef struct
+{
+    gdouble price;
+    StrRef id;
+    gint32 documentNo;
+    guint32 firstLeg; // Index in SECTION_LEGS
+    guint32 legCount;
+} ImageReservation;
+
+static const gsize sectionStride[SECTION_COUNT] = {
+    [SECTION_STRINGS] = 1,
+    [SECTION_FLIGHTS] = sizeof(ImageFlight),
+    [SECTION_PASSENGERS] = sizeof(ImagePassenger),
+    [SECTION_AIRPORTS] = sizeof(ImageAirport),
+    [SECTION_AIRCRAFTS] = sizeof(ImageAircraft),
+    [SECTION_RESERVATIONS] = sizeof(ImageReservation),
+    [SECTION_LEGS] = sizeof(StrRef),
+    [SECTION_AIRPORT_CODES] = sizeof(StrRef),
+    [SECTION_MANUFACTURERS] = sizeof(StrRef),
+    [SECTION_NATIONALITIES] = sizeof(StrRef),
+};
+
+struct dataset_image
+{
+    const guint8 *base;
+    gsize size;
+    GDestroyNotify release;
+    gpointer owner;
+};
+
+static const ImageHeader *image_header(const DatasetImage *img)
+{
+    return (const ImageHeader *)img->base;
+}
+
+static gconstpointer image_section(const DatasetImage *img, ImageSectionId id, guint *count)
+{
+    const ImageSection *sec = &image_header(img)->sections[id];
+    if (count)
+        *count = (guint)sec->count;
+    return img->base + sec->offset;
+}
+
+// --- Building ---
+
+typedef struct
+{
+    GByteArray *bytes;
+    GHashTable *offsets; // Borrowed string -> offset
+    gboolean overflow;
+} StringPool;
+
+static StrRef pool_intern(StringPool *pool, const gchar *s)
+{
+    if (!s)
+        return IMAGE_NULL_REF;
+
+    gpointer found;
+    if (g_hash_table_lookup_extended(pool->offsets, s, NULL, &found))
+        return (StrRef)GPOINTER_TO_UINT(found);
+
+    gsize len = strlen(s) + 1;
+    gsize offset = pool->bytes->len;
+    if (offset + len >= IMAGE_NULL_REF)
+    {
+        pool->overflow = TRUE;
+        return IMAGE_NULL_REF;
+    }
+    g_byte_array_append(pool->bytes, (const guint8 *)s, (guint)len);
+    g_hash_table_insert(pool->offsets, (gpointer)s, GUINT_TO_POINTER(offset));
+    return (StrRef)offset;
+}
+
+static gint compare_flight_rows(const void *a, const void *b)
+{
+    const Flight *fa = *(const Flight *const *)a;
+    const Flight *fb = *(const Flight *const *)b;
+    if (fa->departure != fb->departure)
+        return fa->departure < fb->departure ? -1 : 1;
+    return strcmp(fa->id, fb->id);
+}
+
+static gint compare_passenger_rows(const void *a, const void *b)
+{
+    const Passenger *pa = *(const Passenger *const *)a;
+    const Passenger *pb = *(const Passenger *const *)b;
+    return (pa->document_number > pb->document_number) - (pa->document_number < pb->document_number);
+}
+
+static gint compare_aircraft_rows(const void *a, const void *b)
+{
+    const Aircraft *aa = *(const Aircraft *const *)a;
+    const Aircraft *ab = *(const Aircraft *const *)b;
+    return strcmp(aa->id, ab->id);
+}
+
+// Copies a row span, so it can be reordered without touching the Dataset
+static gpointer *sorted_rows(const void *const *rows, guint count, int (*compare)(const void *, const void *))
+{
+    gpointer *copy = g_new(gpointer, count > 0 ? count : 1);
+    if (count > 0)
+        memcpy(copy, rows, count * sizeof(gpointer));
+    if (compare)
+        qsort(copy, count, sizeof(gpointer), compare);
+    return copy;
+}
+
+static void append_dictionary(GArray *refs, StringPool *pool, const StringDict *dict)
+{
+    guint count = 0;
+    const char *const *entries = string_dict_entries(dict, &count);
+    for (guint i = 0; i < count; i++)
+    {
+        StrRef ref = pool_intern(pool, entries[i]);
+        g_array_append_val(refs, ref);
+    }
+}
+
+static gsize align_up(gsize n)
+{
+    return (n + IMAGE_ALIGN - 1) & ~(gsize)(IMAGE_ALIGN - 1);
+}
+
+DatasetImage *dataset_image_build(const Dataset *ds)
+{
+    return dataset_image_build_filtered(ds, NULL);
+}
+
+DatasetImage *dataset_image_build_filtered(const Dataset *ds, const DatasetImageFilter *filter)
+{
+    if (!ds)
+        return NULL;
+
+    StringPool pool = {g_byte_array_new(), g_hash_table_new(g_str_hash, g_str_equal), FALSE};
+    GArray *sections[SECTION_COUNT] = {NULL};
+    for (int s = SECTION_FLIGHTS; s < SECTION_COUNT; s++)
+        sections[s] = g_array_new(FALSE, FALSE, (guint)sectionStride[s]);
+
+    // 1. Flights, by scheduled departure
+    guint n = 0;
+    const Flight *const *flightRows = dataset_flight_rows(ds, &n);
+    gpointer *flights = sorted_rows((const void *const *)flightRows, n, compare_flight_rows);
+    for (guint i = 0; i < n; i++)
+    {
+        const Flight *f = flights[i];
+        if (filter && filter->keep_flight && !filter->keep_flight(f, filter->user_data))
+            continue;
+        ImageFlight rec = {
+            .departure = f->departure,
+            .actualDeparture = f->actual_departure,
+            .arrival = f->arrival,
+            .actualArrival = f->actual_arrival,
+            .id = pool_intern(&pool, f->id),
+            .origin = pool_intern(&pool, f->origin),
+            .destination = pool_intern(&pool, f->destination),
+            .aircraft = pool_intern(&pool, f->aircraft),
+            .airline = pool_intern(&pool, f->airline),
+            .status = (guint32)f->status};
+        g_array_append_val(sections[SECTION_FLIGHTS], rec);
+    }
+    g_free(flights);
+
+    // 2. Passengers, by document number
+    const Passenger *const *passengerRows = dataset_passenger_rows(ds, &n);
+    gpointer *passengers = sorted_rows((const void *const *)passengerRows, n, compare_passenger_rows);
+    for (guint i = 0; i < n; i++)
+    {
+        const Passenger *p = passengers[i];
+        ImagePassenger rec = {
+            .dob = p->dob,
+            .documentNo = p->document_number,
+            .firstName = pool_intern(&pool, p->first_name),
+            .lastName = pool_intern(&pool, p->last_name),
+            .nationality = pool_intern(&pool, p->nationality),
+            .gender = p->gender,
+            .reserved = 0};
+        g_array_append_val(sections[SECTION_PASSENGERS], rec);
+    }
+    g_free(passengers);
+
+    // 3. Airports, by code (the code dictionary is already sorted, and covers every airport)
+    guint codeCount = 0;
+    const char *const *codes = string_dict_entries(dataset_airport_codes_dict(ds), &codeCount);
+    for (guint i = 0; i < codeCount; i++)
+    {
+        const Airport *a = dataset_get_airport(ds, codes[i]);
+        if (!a)
+            continue;
+        ImageAirport rec = {
+            .code = pool_intern(&pool, a->code),
+            .name = pool_intern(&pool, a->name),
+            .city = pool_intern(&pool, a->city),
+            .country = pool_intern(&pool, a->country),
+            .type = pool_intern(&pool, a->type)};
+        g_array_append_val(sections[SECTION_AIRPORTS], rec);
+    }
+
+    // 4. Aircrafts, by ID
+    const Aircraft *const *aircraftRows = dataset_aircraft_rows(ds, &n);
+    gpointer *aircrafts = sorted_rows((const void *const *)aircraftRows, n, compare_aircraft_rows);
+    for (guint i = 0; i < n; i++)
+    {
+        const Aircraft *a = aircrafts[i];
+        ImageAircraft rec = {
+            .id = pool_intern(&pool, a->id),
+            .manufacturer = pool_intern(&pool, a->manufacturer),
+            .model = pool_intern(&pool, a->model)};
+        g_array_append_val(sections[SECTION_AIRCRAFTS], rec);
+    }
+    g_free(aircrafts);
+
+    // 5. Reservations, in row order, with their legs
+    const Reservation *const *reservationRows = dataset_reservation_rows(ds, &n);
+    for (guint i = 0; i < n; i++)
+    {
+        const Reservation *r = reservationRows[i];
+        if (filter && filter->keep_reservation && !filter->keep_reservation(r, filter->user_data))
+            continue;
+        ImageReservation rec = {
+            .price = r->price,
+            .id = pool_intern(&pool, r->reservation_id),
+            .documentNo = r->document_no,
+            .firstLeg = sections[SECTION_LEGS]->len,
+            .legCount = 0};
+        for (int l = 0; r->flight_ids && r->flight_ids[l]; l++)
+        {
+            StrRef leg = pool_intern(&pool, r->flight_ids[l]);
+            g_array_append_val(sections[SECTION_LEGS], leg);
+            rec.legCount++;
+        }
+        g_array_append_val(sections[SECTION_RESERVATIONS], rec);
+    }
+
+    // 6. Dictionaries
+    append_dictionary(sections[SECTION_AIRPORT_CODES], &pool, dataset_airport_codes_dict(ds));
+    append_dictionary(sections[SECTION_MANUFACTURERS], &pool, dataset_aircraft_manufacturers_dict(ds));
+    append_dictionary(sections[SECTION_NATIONALITIES], &pool, dataset_nationalities_dict(ds));
+
+    DatasetImage *img = NULL;
+    if (!pool.overflow)
+    {
+        // 7. Lay everything out in a single block
+        ImageHeader header = {.magic = IMAGE_MAGIC, .version = IMAGE_VERSION};
+        gsize offset = align_up(sizeof(ImageHeader));
+        header.sections[SECTION_STRINGS].offset = offset;
+        header.sections[SECTION_STRINGS].count = pool.bytes->len;
+        offset = align_up(offset + pool.bytes->len);
+        for (int s = SECTION_FLIGHTS; s < SECTION_COUNT; s++)
+        {
+            header.sections[s].offset = offset;
+            header.sections[s].count = sections[s]->len;
+            offset = align_up(offset + (gsize)sections[s]->len * sectionStride[s]);
+        }
+        header.size = offset;
+
+        guint8 *block = g_malloc0(offset);
+        memcpy(block, &header, sizeof(header));
+        memcpy(block + header.sections[SECTION_STRINGS].offset, pool.bytes->data, pool.bytes->len);
+        for (int s = SECTION_FLIGHTS; s < SECTION_COUNT; s++)
+            memcpy(block + header.sections[s].offset, sections[s]->data, (gsize)sections[s]->len * sectionStride[s]);
+
+        img = g_new0(DatasetImage, 1);
+        img->base = block;
+        img->size = offset;
+        img->release = g_free;
+        img->owner = block;
+    }
+
+    for (int s = SECTION_FLIGHTS; s < SECTION_COUNT; s++)
+        g_array_free(sections[s], TRUE);
+    g_hash_table_destroy(pool.offsets);
+    g_byte_array_free(pool.bytes, TRUE);
+    return img;
+}
+
+// --- Wrapping / IO ---
+
+static gboolean header_is_valid(const guint8 *data, gsize size)
+{
+    if (!data || size < sizeof(ImageHeader) || ((guintptr)data % IMAGE_ALIGN) != 0)
+        return FALSE;
+
+    const ImageHeader *header = (const ImageHeader *)data;
+    if (header->magic != IMAGE_MAGIC || header->version != IMAGE_VERSION || header->size > size)
+        return FALSE;
+
+    for (int s = 0; s < SECTION_COUNT; s++)
+    {
+        const ImageSection *sec = &header->sections[s];
+        if (sec->offset % IMAGE_ALIGN != 0 || sec->offset > header->size)
+            return FALSE;
+        if (sec->count > G_MAXUINT32 || sec->count > (header->size - sec->offset) / sectionStride[s])
+            return FALSE;
+    }
+
+    // The pool must end with a terminator, so no string runs past it
+    const ImageSection *strings = &header->sections[SECTION_STRINGS];
+    return strings->count == 0 || data[strings->offset + strings->count - 1] == '\0';
+}
+
+DatasetImage *dataset_image_wrap(gconstpointer data, gsize size, GDestroyNotify release, gpointer owner)
+{
+    if (!header_is_valid(data, size))
+        return NULL;
+
+    DatasetImage *img = g_new0(DatasetImage, 1);
+    img->base = data;
+    img->size = (gsize)((const ImageHeader *)data)->size;
+    img->release = release;
+    img->owner = owner;
+    return img;
+}
+
+static void release_mapping(gpointer data)
+{
+    g_mapped_file_unref((GMappedFile *)data);
+}
+
+DatasetImage *dataset_image_open(const char *path)
+{
+    GMappedFile *file = g_mapped_file_new(path, FALSE, NULL);
+    if (!file)
+        return NULL;
+
+    DatasetImage *img = dataset_image_wrap(g_mapped_file_get_contents(file), g_mapped_file_get_length(file),
+                                           release_mapping, file);
+    if (!img)
+        g_mapped_file_unref(file);
+    return img;
+}
+
+gboolean dataset_image_write(const DatasetImage *img, const char *path)
+{
+    if (!img || !path)
+        return FALSE;
+    return g_file_set_contents(path, (const gchar *)img->base, (gssize)img->size, NULL);
+}
+
+gconstpointer dataset_image_data(const DatasetImage *img, gsize *size)
+{
+    if (size)
+        *size = img ? img->size : 0;
+    return img ? img->base : NULL;
+}
+
+void dataset_image_free(DatasetImage *img)
+{
+    if (!img)
+        return;
+    if (img->release)
+        img->release(img->owner);
+    g_free(img);
+}
+
+// --- Attaching ---
+
+// Entity structs created over an image; strings point into the image's pool
+typedef struct
+{
+    DatasetImage *image;
+    Flight *flights;
+    Passenger *passengers;
+    Airport *airports;
+    Aircraft *aircrafts;
+    Reservation *reservations;
+    gchar **legs; // NULL-terminated flight ID lists of every reservation
+} FrozenStore;
+
+static void frozen_store_free(gpointer data)
+{
+    FrozenStore *store = data;
+    g_free(store->flights);
+    g_free(store->passengers);
+    g_free(store->airports);
+    g_free(store->aircrafts);
+    g_free(store->reservations);
+    g_free(store->legs);
+    dataset_image_free(store->image);
+    g_free(store);
+}
+
+static gboolean ref_is_valid(StrRef ref, guint poolSize)
+{
+    return ref == IMAGE_NULL_REF || ref < poolSize;
+}
+
+// Checks every string reference and leg range before any of them is followed
+static gboolean records_are_valid(const DatasetImage *img)
+{
+    guint poolSize, n;
+    image_section(img, SECTION_STRINGS, &poolSize);
+
+    const ImageFlight *flights = image_section(img, SECTION_FLIGHTS, &n);
+    for (guint i = 0; i < n; i++)
+    {
+        const ImageFlight *f = &flights[i];
+        if (!ref_is_valid(f->id, poolSize) || f->id == IMAGE_NULL_REF || !ref_is_valid(f->origin, poolSize) ||
+            !ref_is_valid(f->destination, poolSize) || !ref_is_valid(f->aircraft, poolSize) ||
+            !ref_is_valid(f->airline, poolSize))
+            return FALSE;
+    }
+
+    const ImagePassenger *passengers = image_section(img, SECTION_PASSENGERS, &n);
+    for (guint i = 0; i < n; i++)
+    {
+        const ImagePassenger *p = &passengers[i];
+        if (!ref_is_valid(p->firstName, poolSize) || !ref_is_valid(p->lastName, poolSize) ||
+            !ref_is_valid(p->nationality, poolSize))
+            return FALSE;
+    }
+
+    const ImageAirport *airports = image_section(img, SECTION_AIRPORTS, &n);
+    for (guint i = 0; i < n; i++)
+    {
+        const ImageAirport *a = &airports[i];
+        if (!ref_is_valid(a->code, poolSize) || a->code == IMAGE_NULL_REF || !ref_is_valid(a->name, poolSize) ||
+            !ref_is_valid(a->city, poolSize) || !ref_is_valid(a->country, poolSize) ||
+            !ref_is_valid(a->type, poolSize))
+            return FALSE;
+    }
+
+    const ImageAircraft *aircrafts = image_section(img, SECTION_AIRCRAFTS, &n);
+    for (guint i = 0; i < n; i++)
+    {
+        const ImageAircraft *a = &aircrafts[i];
+        if (!ref_is_valid(a->id, poolSize) || a->id == IMAGE_NULL_REF || !ref_is_valid(a->manufacturer, poolSize) ||
+            !ref_is_valid(a->model, poolSize))
+            return FALSE;
+    }
+
+    guint legCount;
+    const StrRef *legs = image_section(img, SECTION_LEGS, &legCount);
+    for (guint i = 0; i < legCount; i++)
+    {
+        if (!ref_is_valid(legs[i], poolSize))
+            return FALSE;
+    }
+
+    const ImageReservation *reservations = image_section(img, SECTION_RESERVATIONS, &n);
+    for (guint i = 0; i < n; i++)
+    {
+        const ImageReservation *r = &reservations[i];
+        if (!ref_is_valid(r->id, poolSize) || r->id == IMAGE_NULL_REF || r->firstLeg > legCount ||
+            r->legCount > legCount - r->firstLeg)
+            return FALSE;
+    }
+
+    for (int s = SECTION_AIRPORT_CODES; s <= SECTION_NATIONALITIES; s++)
+    {
+        const StrRef *refs = image_section(img, s, &n);
+        for (guint i = 0; i < n; i++)
+        {
+            if (refs[i] == IMAGE_NULL_REF || !ref_is_valid(refs[i], poolSize))
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gchar *image_string(const gchar *pool, StrRef ref)
+{
+    return ref == IMAGE_NULL_REF ? NULL : (gchar *)(pool + ref);
+}
+
+static GPtrArray *image_dictionary(const DatasetImage *img, ImageSectionId id, const gchar *pool)
+{
+    guint n;
+    const StrRef *refs = image_section(img, id, &n);
+    GPtrArray *strings = g_ptr_array_sized_new(n);
+    for (guint i = 0; i < n; i++)
+        g_ptr_array_add(strings, image_string(pool, refs[i]));
+    return strings;
+}
+
+gboolean dataset_image_attach(Dataset *ds, DatasetImage *img)
+{
+    if (!ds || !img || !records_are_valid(img))
+    {
+        dataset_image_free(img);
+        return FALSE;
+    }
+
+    const gchar *pool = image_section(img, SECTION_STRINGS, NULL);
+    FrozenStore *store = g_new0(FrozenStore, 1);
+    store->image = img;
+    guint n;
+
+    // Aircrafts
+    const ImageAircraft *aircraftRecs = image_section(img, SECTION_AIRCRAFTS, &n);
+    store->aircrafts = g_new0(Aircraft, n > 0 ? n : 1);
+    GHashTable *aircrafts = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *aircraftRows = g_ptr_array_sized_new(n);
+    for (guint i = 0; i < n; i++)
+    {
+        Aircraft *a = &store->aircrafts[i];
+        a->id = image_string(pool, aircraftRecs[i].id);
+        a->manufacturer = image_string(pool, aircraftRecs[i].manufacturer);
+        a->model = image_string(pool, aircraftRecs[i].model);
+        g_hash_table_insert(aircrafts, a->id, a);
+        g_ptr_array_add(aircraftRows, a);
+    }
+    dataset_set_aircrafts(ds, aircrafts);
+    dataset_set_aircraft_rows(ds, aircraftRows);
+
+    // Flights
+    const ImageFlight *flightRecs = image_section(img, SECTION_FLIGHTS, &n);
+    store->flights = g_new0(Flight, n > 0 ? n : 1);
+    GHashTable *flights = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *flightRows = g_ptr_array_sized_new(n);
+    for (guint i = 0; i < n; i++)
+    {
+        Flight *f = &store->flights[i];
+        f->id = image_string(pool, flightRecs[i].id);
+        f->departure = (time_t)flightRecs[i].departure;
+        f->actual_departure = (time_t)flightRecs[i].actualDeparture;
+        f->arrival = (time_t)flightRecs[i].arrival;
+        f->actual_arrival = (time_t)flightRecs[i].actualArrival;
+        f->status = flightRecs[i].status <= FLIGHT_UNKNOWN ? (FlightStatus)flightRecs[i].status : FLIGHT_UNKNOWN;
+        f->origin = image_string(pool, flightRecs[i].origin);
+        f->destination = image_string(pool, flightRecs[i].destination);
+        f->aircraft = image_string(pool, flightRecs[i].aircraft);
+        f->airline = image_string(pool, flightRecs[i].airline);
+        g_hash_table_insert(flights, f->id, f);
+        g_ptr_array_add(flightRows, f);
+    }
+    dataset_set_flights(ds, flights);
+    dataset_set_flight_rows(ds, flightRows);
+
+    // Passengers
+    const ImagePassenger *passengerRecs = image_section(img, SECTION_PASSENGERS, &n);
+    store->passengers = g_new0(Passenger, n > 0 ? n : 1);
+    GHashTable *passengers = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GPtrArray *passengerRows = g_ptr_array_sized_new(n);
+    for (guint i = 0; i < n; i++)
+    {
+        Passenger *p = &store->passengers[i];
+        p->document_number = passengerRecs[i].documentNo;
+        p->first_name = image_string(pool, passengerRecs[i].firstName);
+        p->last_name = image_string(pool, passengerRecs[i].lastName);
+        p->dob = (time_t)passengerRecs[i].dob;
+        p->nationality = image_string(pool, passengerRecs[i].nationality);
+        p->gender = (char)passengerRecs[i].gender;
+        g_hash_table_insert(passengers, GINT_TO_POINTER(p->document_number), p);
+        g_ptr_array_add(passengerRows, p);
+    }
+    dataset_set_passengers(ds, passengers);
+    dataset_set_passenger_rows(ds, passengerRows);
+
+    // Airports
+    const ImageAirport *airportRecs = image_section(img, SECTION_AIRPORTS, &n);
+    store->airports = g_new0(Airport, n > 0 ? n : 1);
+    GHashTable *airports = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < n; i++)
+    {
+        Airport *a = &store->airports[i];
+        a->code = image_string(pool, airportRecs[i].code);
+        a->name = image_string(pool, airportRecs[i].name);
+        a->city = image_string(pool, airportRecs[i].city);
+        a->country = image_string(pool, airportRecs[i].country);
+        a->type = image_string(pool, airportRecs[i].type);
+        g_hash_table_insert(airports, a->code, a);
+    }
+    dataset_set_airports(ds, airports);
+
+    // Reservations: each leg list gets its own NULL terminator
+    guint legCount;
+    const StrRef *legRecs = image_section(img, SECTION_LEGS, &legCount);
+    const ImageReservation *reservationRecs = image_section(img, SECTION_RESERVATIONS, &n);
+    store->reservations = g_new0(Reservation, n > 0 ? n : 1);
+    store->legs = g_new0(gchar *, legCount + n + 1);
+    GHashTable *reservations = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *reservationRows = g_ptr_array_sized_new(n);
+    gchar **leg = store->legs;
+    for (guint i = 0; i < n; i++)
+    {
+        const ImageReservation *rec = &reservationRecs[i];
+        Reservation *r = &store->reservations[i];
+        r->reservation_id = image_string(pool, rec->id);
+        r->document_no = rec->documentNo;
+        r->price = rec->price;
+        r->flight_ids = leg;
+        for (guint l = 0; l < rec->legCount; l++)
+            *leg++ = image_string(pool, legRecs[rec->firstLeg + l]);
+        *leg++ = NULL;
+        g_hash_table_insert(reservations, r->reservation_id, r);
+        g_ptr_array_add(reservationRows, r);
+    }
+    dataset_set_reservations(ds, reservations);
+    dataset_set_reservation_rows(ds, reservationRows);
+
+    // Dictionaries (the Dataset copies the strings into its own pools)
+    dataset_set_airport_codes(ds, image_dictionary(img, SECTION_AIRPORT_CODES, pool));
+    dataset_set_aircraft_manufacturers(ds, image_dictionary(img, SECTION_MANUFACTURERS, pool));
+    dataset_set_nationalities(ds, image_dictionary(img, SECTION_NATIONALITIES, pool));
+
+    // Derived data, as computed by the loader
+    dataset_set_airport_stats(ds, calculate_airport_traffic(ds));
+    dataset_build_flight_indexes(ds);
+    dataset_build_passenger_index(ds);
+
+    dataset_set_backing(ds, store, frozen_store_free);
+    return TRUE;
+}
+
+gboolean dataset_freeze(Dataset *ds)
+{
+    DatasetImage *img = dataset_image_build(ds);
+    if (!img)
+        return FALSE;
+
+    if (!records_are_valid(img))
+    {
+        dataset_image_free(img);
+        return FALSE;
+    }
+
+    dataset_clear(ds);
+    return dataset_image_attach(ds, img);
+}
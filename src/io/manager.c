@@ -5,13 +5,15 @@
 #include "core/utils.h"
 #include "core/statistics.h"
 #include "core/dataset_loader.h" // Uses the new Loader API
+#include "io/dataset_image.h"
+#include "io/shared_dataset.h"
 #include "entities/access/aircrafts_access.h"
 #include "entities/access/airports_access.h"
 #include "entities/access/flights_access.h"
 #include "entities/access/passengers_access.h"
 #include "entities/access/reservations_access.h"
 
-void loadAllDatasets(Dataset *ds, int *errorsFlag, const char *filePath, gboolean enable_timing)
+gboolean loadAllDatasets(Dataset *ds, int *errorsFlag, const char *filePath, gboolean enable_timing)
 {
     GTimer *timer = NULL;
     gdouble elapsed = 0;
@@ -133,20 +135,73 @@ void loadAllDatasets(Dataset *ds, int *errorsFlag, const char *filePath, gboolea
             printf("Failed to load reservations.csv (%.3f seconds)\n", elapsed);
     }
 
+    // A reader returns NULL only when its file could not be read at all
+    gboolean loaded = aircrafts && flights && passengers && airports && reservations;
+
+    if (enable_timing)
+        timer = g_timer_new();
+
+    // Compact the parsed entities into one contiguous image. Attaching it also
+    // computes the airport stats and builds the flight and passenger indexes.
+    gboolean frozen = dataset_freeze(ds);
+
+    if (enable_timing)
+    {
+        elapsed = g_timer_elapsed(timer, NULL);
+        g_timer_destroy(timer);
+        if (frozen)
+            printf("Dataset frozen (%.3f seconds)\n", elapsed);
+        else
+            printf("Failed to freeze the dataset (%.3f seconds)\n", elapsed);
+    }
+
+    if (frozen)
+        return loaded;
+
     // Calculate stats using local variables before setting
-    GHashTable *airportStats = calculate_airport_traffic(reservations, flights);
+    GHashTable *airportStats = calculate_airport_traffic(ds);
     if (!airportStats)
     {
         airportStats = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeAirportPassengerStats);
     }
     dataset_set_airport_stats(ds, airportStats);
 
-    if (airportCodes)
+    // Group flights by origin, destination, airline and aircraft
+    dataset_build_flight_indexes(ds);
+    dataset_build_passenger_index(ds);
+    return loaded;
+}
+
+void loadSharedDataset(Dataset *ds, int *errorsFlag, const char *filePath, const char *sharedName,
+                       gboolean enable_timing)
+{
+    if (!sharedName)
     {
-        g_ptr_array_sort(airportCodes, (GCompareFunc)strcmp);
+        loadAllDatasets(ds, errorsFlag, filePath, enable_timing);
+        return;
     }
-    if (nationalities)
+
+    // Read before parsing, so that a file changed meanwhile is never published as current
+    DatasetSource source;
+    dataset_source_read(&source, filePath);
+
+    GTimer *timer = enable_timing ? g_timer_new() : NULL;
+    gboolean attached = dataset_shared_attach(ds, sharedName, &source, errorsFlag);
+
+    if (enable_timing)
     {
-        g_ptr_array_sort(nationalities, (GCompareFunc)strcmp);
+        if (attached)
+            printf("Attached shared dataset %s (%.3f seconds)\n", sharedName, g_timer_elapsed(timer, NULL));
+        g_timer_destroy(timer);
     }
-}
\ No newline at end of file
+    if (attached)
+        return;
+
+    loadAllDatasets(ds, errorsFlag, filePath, enable_timing);
+
+    // Another process may have published meanwhile, or the name holds other files:
+    // the segment is then left as is
+    gboolean published = dataset_shared_publish(ds, sharedName, &source, *errorsFlag);
+    if (enable_timing && published)
+        printf("Published shared dataset %s\n", sharedName);
+}
@@ -0,0 +1,141 @@
+#include "io/output_builder.h"
+#include <glib.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Values whose scaled form reaches this size are left to snprintf()
+#define FIXED_FAST_LIMIT 4503599627370496.0 // 2^52
+
+static const guint64 powersOfTen[] = {1ull,         10ull,         100ull,         1000ull,         10000ull,
+                                      100000ull,    1000000ull,    10000000ull,    100000000ull,    1000000000ull};
+
+void output_builder_init(OutputBuilder *b, char *buffer, gsize capacity, int isSpecial, FILE *sink)
+{
+    b->data = buffer;
+    b->capacity = capacity;
+    b->length = 0;
+    b->separator = isSpecial ? '=' : ';';
+    b->sink = sink;
+}
+
+void output_builder_flush(OutputBuilder *b)
+{
+    if (b->length > 0 && b->sink)
+        fwrite(b->data, 1, b->length, b->sink);
+    b->length = 0;
+}
+
+// Makes room for @p len bytes, flushing first if needed; returns FALSE if they can never fit
+static gboolean reserve(OutputBuilder *b, gsize len)
+{
+    if (b->length + len <= b->capacity)
+        return TRUE;
+    output_builder_flush(b);
+    return len <= b->capacity;
+}
+
+void output_builder_bytes(OutputBuilder *b, const char *data, gsize len)
+{
+    if (!reserve(b, len))
+    {
+        // Longer than the whole buffer: straight to the stream
+        if (b->sink)
+            fwrite(data, 1, len, b->sink);
+        return;
+    }
+    memcpy(b->data + b->length, data, len);
+    b->length += len;
+}
+
+void output_builder_string(OutputBuilder *b, const char *str)
+{
+    if (str)
+        output_builder_bytes(b, str, strlen(str));
+}
+
+void output_builder_char(OutputBuilder *b, char c)
+{
+    reserve(b, 1);
+    b->data[b->length++] = c;
+}
+
+void output_builder_separator(OutputBuilder *b)
+{
+    output_builder_char(b, b->separator);
+}
+
+// --- Numbers ---
+
+// Writes the digits of @p value, at least @p width of them, right-aligned at the end of @p end
+static char *format_digits(char *end, guint64 value, guint width)
+{
+    char *p = end;
+    do
+    {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while ((guint)(end - p) < width)
+        *--p = '0';
+    return p;
+}
+
+static void append_integer(OutputBuilder *b, gint64 value, guint width)
+{
+    char digits[48];
+    char *end = digits + sizeof(digits);
+    // Negation in unsigned arithmetic also covers G_MININT64
+    guint64 magnitude = value < 0 ? 0 - (guint64)value : (guint64)value;
+    // As with printf, the sign counts towards the width
+    guint digitWidth = value < 0 && width > 0 ? width - 1 : width;
+    char *start = format_digits(end, magnitude, digitWidth > 40 ? 40 : digitWidth);
+    if (value < 0)
+        *--start = '-';
+    output_builder_bytes(b, start, (gsize)(end - start));
+}
+
+void output_builder_int(OutputBuilder *b, gint64 value)
+{
+    append_integer(b, value, 0);
+}
+
+void output_builder_int_padded(OutputBuilder *b, gint64 value, guint width)
+{
+    append_integer(b, value, width);
+}
+
+void output_builder_fixed(OutputBuilder *b, gdouble value, guint decimals)
+{
+    if (decimals > 9)
+        decimals = 9;
+
+    gdouble scaled = fabs(value) * (gdouble)powersOfTen[decimals];
+    gdouble fraction = scaled - floor(scaled);
+    // printf rounds the exact binary value: near a tie, the error of the product
+    // above could flip the result, so those (rare) values take the slow path
+    gdouble margin = scaled * 1e-15 + 1e-12;
+    if (!isfinite(value) || scaled >= FIXED_FAST_LIMIT || fabs(fraction - 0.5) <= margin)
+    {
+        char text[400];
+        int len = snprintf(text, sizeof(text), "%.*f", (int)decimals, value);
+        if (len > 0)
+            output_builder_bytes(b, text, (gsize)len < sizeof(text) ? (gsize)len : sizeof(text) - 1);
+        return;
+    }
+
+    guint64 rounded = (guint64)floor(scaled + 0.5);
+    char digits[48];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+    if (decimals > 0)
+    {
+        start = format_digits(end, rounded % powersOfTen[decimals], decimals);
+        *--start = '.';
+    }
+    start = format_digits(start, rounded / powersOfTen[decimals], 1);
+    // Like printf, negative values keep their sign even when they round to zero
+    if (signbit(value))
+        *--start = '-';
+    output_builder_bytes(b, start, (gsize)(end - start));
+}
@@ -0,0 +1,270 @@
+#include "io/output_writer.h"
+#include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Buffers in the pool: how many results can be waiting for the writer at once
+#define OUTPUT_POOL_SIZE 256
+// Buffers written per wake-up of the writer thread
+#define OUTPUT_BATCH_SIZE 64
+// A buffer that grew past this size is shrunk back once written
+#define OUTPUT_BUFFER_KEEP (1 << 20)
+
+#define PACKED_DATA_NAME "commands_output.txt"
+#define PACKED_INDEX_NAME "commands_output.idx"
+
+struct output_buffer
+{
+    GString *data;
+    FILE *stream; // Appends to data
+    int command;
+};
+
+struct output_writer
+{
+    OutputMode mode;
+    int dirFd;
+    int packedFd;          // OUTPUT_PACKED only
+    guint64 packedOffset;  // Writer thread only
+    GArray *packedIndex;   // OutputIndexEntry, writer thread only
+    OutputBuffer *buffers; // The pool
+    GAsyncQueue *free;     // Buffers ready to be acquired
+    GAsyncQueue *pending;  // Submitted buffers, for the writer thread
+    GThread *thread;
+    GMutex lock; // Guards the counters below
+    GCond written;
+    guint64 submittedCount;
+    guint64 writtenCount;
+};
+
+// Pushed to the pending queue to stop the writer thread
+static gchar stopMarker;
+
+// --- Buffers ---
+
+static ssize_t buffer_write(void *cookie, const char *data, size_t size)
+{
+    OutputBuffer *buffer = cookie;
+    g_string_append_len(buffer->data, data, (gssize)size);
+    return (ssize_t)size;
+}
+
+static void buffer_init(OutputBuffer *buffer)
+{
+    cookie_io_functions_t io = {.write = buffer_write};
+    buffer->data = g_string_sized_new(256);
+    buffer->stream = fopencookie(buffer, "w", io);
+}
+
+static void buffer_clear(OutputBuffer *buffer)
+{
+    if (buffer->stream)
+        fclose(buffer->stream);
+    g_string_free(buffer->data, TRUE);
+}
+
+// --- Writer Thread ---
+
+static gboolean write_all(int fd, const gchar *data, gsize len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        data += n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+static void write_buffer(OutputWriter *writer, const OutputBuffer *buffer)
+{
+    if (writer->mode == OUTPUT_PACKED)
+    {
+        OutputIndexEntry entry = {.command = (guint32)buffer->command,
+                                  .length = (guint32)buffer->data->len,
+                                  .offset = writer->packedOffset};
+        if (write_all(writer->packedFd, buffer->data->str, buffer->data->len))
+        {
+            writer->packedOffset += buffer->data->len;
+            g_array_append_val(writer->packedIndex, entry);
+        }
+        return;
+    }
+
+    // One open, one write, one close: no stdio on the way
+    char name[64];
+    snprintf(name, sizeof(name), "command%d_output.txt", buffer->command);
+    int fd = openat(writer->dirFd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return;
+    write_all(fd, buffer->data->str, buffer->data->len);
+    close(fd);
+}
+
+static void recycle_buffer(OutputWriter *writer, OutputBuffer *buffer)
+{
+    if (buffer->data->allocated_len > OUTPUT_BUFFER_KEEP)
+    {
+        buffer_clear(buffer);
+        buffer_init(buffer);
+    }
+    else
+    {
+        g_string_truncate(buffer->data, 0);
+    }
+    g_async_queue_push(writer->free, buffer);
+}
+
+static gpointer writer_thread(gpointer data)
+{
+    OutputWriter *writer = data;
+    gpointer batch[OUTPUT_BATCH_SIZE];
+    gboolean stopping = FALSE;
+
+    while (!stopping)
+    {
+        // Wait for one buffer, then take whatever else is already queued
+        guint n = 0;
+        batch[n++] = g_async_queue_pop(writer->pending);
+        while (n < OUTPUT_BATCH_SIZE && (batch[n] = g_async_queue_try_pop(writer->pending)) != NULL)
+            n++;
+
+        guint done = 0;
+        for (guint i = 0; i < n; i++)
+        {
+            if (batch[i] == &stopMarker)
+            {
+                stopping = TRUE;
+                continue;
+            }
+            write_buffer(writer, batch[i]);
+            recycle_buffer(writer, batch[i]);
+            done++;
+        }
+
+        g_mutex_lock(&writer->lock);
+        writer->writtenCount += done;
+        g_cond_broadcast(&writer->written);
+        g_mutex_unlock(&writer->lock);
+    }
+    return NULL;
+}
+
+// --- Public API ---
+
+OutputWriter *output_writer_new(const char *directory, OutputMode mode)
+{
+    int dirFd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (dirFd < 0)
+        return NULL;
+
+    int packedFd = -1;
+    if (mode == OUTPUT_PACKED)
+    {
+        packedFd = openat(dirFd, PACKED_DATA_NAME, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (packedFd < 0)
+        {
+            close(dirFd);
+            return NULL;
+        }
+    }
+
+    OutputWriter *writer = g_new0(OutputWriter, 1);
+    writer->mode = mode;
+    writer->dirFd = dirFd;
+    writer->packedFd = packedFd;
+    writer->packedIndex = g_array_new(FALSE, FALSE, sizeof(OutputIndexEntry));
+    writer->free = g_async_queue_new();
+    writer->pending = g_async_queue_new();
+    g_mutex_init(&writer->lock);
+    g_cond_init(&writer->written);
+
+    writer->buffers = g_new0(OutputBuffer, OUTPUT_POOL_SIZE);
+    for (int i = 0; i < OUTPUT_POOL_SIZE; i++)
+    {
+        buffer_init(&writer->buffers[i]);
+        g_async_queue_push(writer->free, &writer->buffers[i]);
+    }
+
+    writer->thread = g_thread_new("output-writer", writer_thread, writer);
+    return writer;
+}
+
+OutputBuffer *output_writer_acquire(OutputWriter *writer, int command)
+{
+    OutputBuffer *buffer = g_async_queue_pop(writer->free);
+    buffer->command = command;
+    return buffer;
+}
+
+FILE *output_buffer_stream(OutputBuffer *buffer)
+{
+    return buffer->stream;
+}
+
+void output_writer_submit(OutputWriter *writer, OutputBuffer *buffer)
+{
+    if (buffer->stream)
+        fflush(buffer->stream);
+
+    g_mutex_lock(&writer->lock);
+    writer->submittedCount++;
+    g_mutex_unlock(&writer->lock);
+    g_async_queue_push(writer->pending, buffer);
+}
+
+void output_writer_flush(OutputWriter *writer)
+{
+    g_mutex_lock(&writer->lock);
+    while (writer->writtenCount < writer->submittedCount)
+        g_cond_wait(&writer->written, &writer->lock);
+    g_mutex_unlock(&writer->lock);
+}
+
+static gint compare_index_entries(gconstpointer a, gconstpointer b)
+{
+    const OutputIndexEntry *ea = a;
+    const OutputIndexEntry *eb = b;
+    return (ea->command > eb->command) - (ea->command < eb->command);
+}
+
+void output_writer_free(OutputWriter *writer)
+{
+    if (!writer)
+        return;
+
+    // The marker comes after every submitted buffer, so they are all written first
+    g_async_queue_push(writer->pending, &stopMarker);
+    g_thread_join(writer->thread);
+
+    if (writer->mode == OUTPUT_PACKED)
+    {
+        g_array_sort(writer->packedIndex, compare_index_entries);
+        int fd = openat(writer->dirFd, PACKED_INDEX_NAME, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+            write_all(fd, writer->packedIndex->data, (gsize)writer->packedIndex->len * sizeof(OutputIndexEntry));
+            close(fd);
+        }
+        close(writer->packedFd);
+    }
+    close(writer->dirFd);
+
+    for (int i = 0; i < OUTPUT_POOL_SIZE; i++)
+        buffer_clear(&writer->buffers[i]);
+    g_free(writer->buffers);
+    g_array_free(writer->packedIndex, TRUE);
+    g_async_queue_unref(writer->free);
+    g_async_queue_unref(writer->pending);
+    g_mutex_clear(&writer->lock);
+    g_cond_clear(&writer->written);
+    g_free(writer);
+}
@@ -7,11 +7,158 @@
 #include "entities/access/reservations_access.h"
 #include "entities/internal/reservations_internal.h"
 #include "entities/access/flights_access.h"
+#include "core/lookup_table.h"
 #include "io/parsing/parser_utils.h"
 #include "io/validation/validation_utils.h"
 #include "io/validation/reservations_validator.h"
 #include "io/validation/passengers_validator.h"
 
+// Lines validated per batch: their foreign keys are resolved with batched lookups
+#define RESERVATION_BATCH 256
+
+// A parsed line waiting for its foreign-key checks
+typedef struct
+{
+    ParsedReservationF *pr;
+    const gchar *fields[8];
+    gboolean invalid;
+    int docNo;
+    gchar **flights;
+    int legCount;
+    gconstpointer passenger;
+    gconstpointer legs[2];
+} PendingReservation;
+
+// Checks that don't need the other tables: ID, document number and flight list syntax
+static void checkReservationFields(PendingReservation *p)
+{
+    const gchar **fields = p->fields;
+
+    if (!checkReservationId(fields[0]))
+        p->invalid = TRUE;
+
+    if (!p->invalid && !checkDocumentNo(fields[2]))
+        p->invalid = TRUE;
+    else
+    {
+        p->docNo = atoi(fields[2]);
+    }
+
+    if (!p->invalid)
+    {
+        const char *s = fields[1];
+        size_t l = strlen(s);
+        if (l < 2 || s[0] != '[' || s[l - 1] != ']')
+        {
+            p->invalid = TRUE;
+        }
+    }
+
+    if (!p->invalid)
+    {
+        p->flights = parseFlightIds(fields[1]);
+        if (!p->flights || !p->flights[0])
+        {
+            p->invalid = TRUE;
+        }
+        else
+        {
+            while (p->flights[p->legCount])
+                p->legCount++;
+
+            if (p->legCount > 2)
+                p->invalid = TRUE;
+        }
+    }
+}
+
+// Checks that the passenger and the flights exist, and that two legs connect
+static void checkReservationKeys(PendingReservation *p)
+{
+    if (p->invalid)
+        return;
+
+    if (!p->passenger)
+        p->invalid = TRUE;
+    else if (p->legCount == 1)
+    {
+        if (!p->legs[0])
+            p->invalid = TRUE;
+    }
+    else
+    {
+        const Flight *f1 = p->legs[0];
+        const Flight *f2 = p->legs[1];
+
+        if (!f1 || !f2 ||
+            g_strcmp0(getFlightDestination(f1),
+                      getFlightOrigin(f2)) != 0)
+            p->invalid = TRUE;
+    }
+}
+
+// Resolves the foreign keys of a batch, then logs or inserts every line in file order
+static void flushReservations(PendingReservation *batch, guint n,
+                              const LookupTable *passengers,
+                              const LookupTable *flights,
+                              GHashTable *table,
+                              const char *headerLine,
+                              int *errorsFlag)
+{
+    gconstpointer docKeys[RESERVATION_BATCH] = {0};
+    gconstpointer legKeys[RESERVATION_BATCH * 2];
+    gpointer found[RESERVATION_BATCH * 2];
+    guint nLegs = 0;
+
+    if (n == 0)
+        return;
+
+    for (guint i = 0; i < n; i++)
+        docKeys[i] = batch[i].invalid ? NULL : GINT_TO_POINTER(batch[i].docNo);
+    lookup_table_get_batch(passengers, docKeys, n, found);
+    for (guint i = 0; i < n; i++)
+        batch[i].passenger = batch[i].invalid ? NULL : found[i];
+
+    for (guint i = 0; i < n; i++)
+    {
+        for (int l = 0; !batch[i].invalid && l < batch[i].legCount; l++)
+            legKeys[nLegs++] = batch[i].flights[l];
+    }
+    lookup_table_get_batch(flights, legKeys, nLegs, found);
+    nLegs = 0;
+    for (guint i = 0; i < n; i++)
+    {
+        for (int l = 0; !batch[i].invalid && l < batch[i].legCount; l++)
+            batch[i].legs[l] = found[nLegs++];
+    }
+
+    for (guint i = 0; i < n; i++)
+    {
+        PendingReservation *p = &batch[i];
+        checkReservationKeys(p);
+
+        if (p->invalid)
+        {
+            g_strfreev(p->flights);
+            logInvalidLine("resultados/reservations_errors.csv",
+                           headerLine,
+                           parsed_reservation_line(p->pr));
+            *errorsFlag = 1;
+            parsed_reservation_free(p->pr);
+            continue;
+        }
+
+        Reservation *data = g_new0(Reservation, 1);
+        data->reservation_id = g_strdup(p->fields[0]);
+        data->flight_ids = p->flights;
+        data->document_no = p->docNo;
+        data->price = atof(p->fields[4]);
+
+        g_hash_table_insert(table, g_strdup(p->fields[0]), data);
+        parsed_reservation_free(p->pr);
+    }
+}
+
 GHashTable *readReservations(const char *filename,
                              GHashTable *passengersTable,
                              GHashTable *flightsTable,
@@ -37,10 +184,18 @@ GHashTable *readReservations(const char *filename,
     GHashTable *table =
         g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeReservations);
 
+    // Flat views of the referenced tables, so a batch's probes overlap their misses
+    LookupTable *passengers = lookup_table_new_from_hash(passengersTable, LOOKUP_KEY_INT);
+    LookupTable *flights = lookup_table_new_from_hash(flightsTable, LOOKUP_KEY_STRING);
+
+    PendingReservation *batch = g_new(PendingReservation, RESERVATION_BATCH);
+    guint pending = 0;
+
     while ((read = getline(&line, &len, f)) != -1)
     {
         g_strchomp(line);
 
+        // The parsed record keeps its own copy of the line
         ParsedReservationF *pr = parseReservationLineRaw(line);
         if (!parsed_reservation_ok(pr))
         {
@@ -48,102 +203,26 @@ GHashTable *readReservations(const char *filename,
             continue;
         }
 
-        const gchar *fields[8];
+        PendingReservation *p = &batch[pending++];
+        memset(p, 0, sizeof(*p));
+        p->pr = pr;
         for (int i = 0; i < 8; i++)
-            fields[i] = parsed_reservation_get(pr, i);
+            p->fields[i] = parsed_reservation_get(pr, i);
+        checkReservationFields(p);
 
-        gboolean invalid = FALSE;
-
-        if (!checkReservationId(fields[0]))
-            invalid = TRUE;
-
-        int docNo = 0;
-        if (!invalid && !checkDocumentNo(fields[2]))
-            invalid = TRUE;
-        else
+        if (pending == RESERVATION_BATCH)
         {
-            docNo = atoi(fields[2]);
+            flushReservations(batch, pending, passengers, flights, table, headerLine, errorsFlag);
+            pending = 0;
         }
-
-        if (!invalid &&
-            !g_hash_table_contains(passengersTable, GINT_TO_POINTER(docNo)))
-            invalid = TRUE;
-
-        gchar **flights = NULL;
-
-        if (!invalid)
-        {
-            const char *s = fields[1];
-            size_t l = strlen(s);
-            if (l < 2 || s[0] != '[' || s[l - 1] != ']')
-            {
-                invalid = TRUE;
-            }
-        }
-
-        if (!invalid)
-        {
-            flights = parseFlightIds(fields[1]);
-            if (!flights || !flights[0])
-            {
-                invalid = TRUE;
-            }
-            else
-            {
-                int count = 0;
-                while (flights[count])
-                    count++;
-
-                if (count == 0 || count > 2)
-                {
-                    invalid = TRUE;
-                }
-                else if (count == 1)
-                {
-                    if (!g_hash_table_contains(flightsTable, flights[0]))
-                        invalid = TRUE;
-                }
-                else
-                {
-                    const Flight *f1 = getFlight(flights[0], flightsTable);
-                    const Flight *f2 = getFlight(flights[1], flightsTable);
-
-                    if (!f1 || !f2 ||
-                        g_strcmp0(getFlightDestination(f1),
-                                  getFlightOrigin(f2)) != 0)
-                        invalid = TRUE;
-                }
-
-                if (invalid)
-                {
-                    g_strfreev(flights);
-                    flights = NULL;
-                }
-            }
-        }
-
-        if (invalid)
-        {
-            logInvalidLine("resultados/reservations_errors.csv",
-                           headerLine,
-                           parsed_reservation_line(pr));
-            *errorsFlag = 1;
-            parsed_reservation_free(pr);
-            continue;
-        }
-
-        Reservation *data = g_new0(Reservation, 1);
-        data->reservation_id = g_strdup(fields[0]);
-        data->flight_ids = flights;
-        data->document_no = docNo;
-        data->price = atof(fields[4]);
-
-        g_hash_table_insert(table, g_strdup(fields[0]), data);
-        parsed_reservation_free(pr);
     }
+    flushReservations(batch, pending, passengers, flights, table, headerLine, errorsFlag);
 
+    g_free(batch);
+    lookup_table_free(passengers);
+    lookup_table_free(flights);
     g_free(headerLine);
     free(line);
     fclose(f);
     return table;
-}
\ No newline at end of file
+}
@@ -0,0 +1,171 @@
+#include "io/shared_dataset.h"
+#include "io/dataset_image.h"
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHARED_MAGIC 0x32484453u // "SDH2"
+
+// Same order as loadAllDatasets() reads them
+static const char *const sourceFiles[SHARED_SOURCE_FILES] = {"aircrafts.csv", "flights.csv", "passengers.csv",
+                                                              "airports.csv", "reservations.csv"};
+
+// --- Segment Layout ---
+
+typedef struct
+{
+    guint32 magic; // Written last: 0 while the segment is being filled
+    gint32 errors;
+    guint64 imageOffset;
+    guint64 imageSize;
+    DatasetSource source;
+} SharedHeader;
+
+// Keeps the image 64-byte aligned within the page-aligned mapping
+#define SHARED_IMAGE_OFFSET ((sizeof(SharedHeader) + 63) & ~(gsize)63)
+
+typedef struct
+{
+    gpointer addr;
+    gsize length;
+} SharedMapping;
+
+static void release_shared_mapping(gpointer data)
+{
+    SharedMapping *mapping = data;
+    munmap(mapping->addr, mapping->length);
+    g_free(mapping);
+}
+
+// --- Public API ---
+
+void dataset_source_read(DatasetSource *source, const char *datasetPath)
+{
+    memset(source, 0, sizeof(*source));
+
+    // A directory that cannot be resolved is recorded as given
+    char *canonical = realpath(datasetPath, NULL);
+    g_strlcpy(source->path, canonical ? canonical : datasetPath, sizeof(source->path));
+    free(canonical);
+
+    for (int i = 0; i < SHARED_SOURCE_FILES; i++)
+    {
+        char *filePath = g_build_filename(source->path, sourceFiles[i], NULL);
+        struct stat st;
+        if (stat(filePath, &st) == 0)
+        {
+            source->sizes[i] = (guint64)st.st_size;
+            source->mtimes[i] = (gint64)st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_mtim.tv_nsec;
+        }
+        else
+        {
+            source->mtimes[i] = -1;
+        }
+        g_free(filePath);
+    }
+}
+
+gboolean dataset_shared_publish(const Dataset *ds, const char *name, const DatasetSource *source, int errors)
+{
+    if (!ds || !name || !source)
+        return FALSE;
+
+    DatasetImage *img = dataset_image_build(ds);
+    if (!img)
+        return FALSE;
+
+    gsize imageSize = 0;
+    gconstpointer image = dataset_image_data(img, &imageSize);
+    gsize length = SHARED_IMAGE_OFFSET + imageSize;
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        dataset_image_free(img);
+        return FALSE;
+    }
+
+    gpointer addr = MAP_FAILED;
+    if (ftruncate(fd, (off_t)length) == 0)
+        addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        shm_unlink(name);
+        dataset_image_free(img);
+        return FALSE;
+    }
+
+    SharedHeader *header = addr;
+    header->errors = errors;
+    header->imageOffset = SHARED_IMAGE_OFFSET;
+    header->imageSize = imageSize;
+    header->source = *source;
+    memcpy((guint8 *)addr + SHARED_IMAGE_OFFSET, image, imageSize);
+    // Full barrier: attaching processes see a complete segment once the magic is set
+    g_atomic_int_set((gint *)&header->magic, (gint)SHARED_MAGIC);
+
+    munmap(addr, length);
+    dataset_image_free(img);
+    return TRUE;
+}
+
+gboolean dataset_shared_attach(Dataset *ds, const char *name, const DatasetSource *source, int *errors)
+{
+    if (!ds || !name || !source)
+        return FALSE;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return FALSE;
+
+    struct stat st;
+    gpointer addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (gsize)st.st_size >= SHARED_IMAGE_OFFSET)
+        addr = mmap(NULL, (gsize)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+        return FALSE;
+
+    SharedMapping *mapping = g_new(SharedMapping, 1);
+    mapping->addr = addr;
+    mapping->length = (gsize)st.st_size;
+
+    const SharedHeader *header = addr;
+    if ((guint32)g_atomic_int_get((const gint *)&header->magic) != SHARED_MAGIC ||
+        header->imageOffset != SHARED_IMAGE_OFFSET ||
+        header->imageSize > mapping->length - SHARED_IMAGE_OFFSET ||
+        memcmp(&header->source, source, sizeof(*source)) != 0)
+    {
+        release_shared_mapping(mapping);
+        return FALSE;
+    }
+
+    // The image validates itself; on success it owns the mapping
+    DatasetImage *img = dataset_image_wrap((const guint8 *)addr + header->imageOffset, header->imageSize,
+                                           release_shared_mapping, mapping);
+    if (!img)
+    {
+        release_shared_mapping(mapping);
+        return FALSE;
+    }
+
+    int publishedErrors = header->errors;
+    if (!dataset_image_attach(ds, img))
+        return FALSE;
+
+    if (errors && publishedErrors)
+        *errors = 1;
+    return TRUE;
+}
+
+gboolean dataset_shared_unlink(const char *name)
+{
+    return name && shm_unlink(name) == 0;
+}
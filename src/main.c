@@ -2,33 +2,143 @@
 #include <core/dataset.h>
 #include <core/report.h>
 #include <queries/queries.h>
+#include <queries/sharding.h>
+#include <queries/server.h>
 #include <io/manager.h>
+#include <io/output_writer.h>
+#include <io/shared_dataset.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define SHARDS_OPTION "--shards="
+#define PACKED_OPTION "--packed"
+#define SERVE_OPTION "--serve="
+#define CONNECT_OPTION "--connect="
+#define UNLINK_SHARED_OPTION "--unlink-shared="
+
+static void print_usage(void)
+{
+  printf("Needs dataset and input file paths (and optionally a shared-memory name, --shards=N and --packed)\n");
+  printf("Server: <dataset> --serve=<socket> [shared-memory name]\n");
+  printf("Client: --connect=<socket> <input file> [--packed]\n");
+  printf("Remove a shared dataset: --unlink-shared=<shared-memory name>\n");
+}
 
 int main(int argc, char *argv[])
 {
-  if (argc != 3)
+  // Arguments other than options, in order: dataset (not for a client), input file (not for a server), shared name
+  const char *positional[3] = {NULL};
+  int positionalCount = 0;
+  // With --shards=N, the dataset is partitioned by airport across N worker processes
+  int shards = 0;
+  // With --packed, all results go to a single file plus an index (see output_writer.h)
+  OutputMode outputMode = OUTPUT_FILES;
+  // With --serve=PATH, the dataset is loaded once and commands are served on a socket (see server.h)
+  const char *serveSocket = NULL;
+  // With --connect=PATH, the commands are sent to a running server instead
+  const char *connectSocket = NULL;
+  // With --unlink-shared=NAME, a published dataset is removed (e.g., once its CSV files changed)
+  const char *unlinkShared = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], SHARDS_OPTION, strlen(SHARDS_OPTION)) == 0)
+      shards = atoi(argv[i] + strlen(SHARDS_OPTION));
+    else if (strcmp(argv[i], PACKED_OPTION) == 0)
+      outputMode = OUTPUT_PACKED;
+    else if (strncmp(argv[i], SERVE_OPTION, strlen(SERVE_OPTION)) == 0)
+      serveSocket = argv[i] + strlen(SERVE_OPTION);
+    else if (strncmp(argv[i], CONNECT_OPTION, strlen(CONNECT_OPTION)) == 0)
+      connectSocket = argv[i] + strlen(CONNECT_OPTION);
+    else if (strncmp(argv[i], UNLINK_SHARED_OPTION, strlen(UNLINK_SHARED_OPTION)) == 0)
+      unlinkShared = argv[i] + strlen(UNLINK_SHARED_OPTION);
+    else if (positionalCount < 3)
+      positional[positionalCount++] = argv[i];
+    else
+      positionalCount++;
+  }
+
+  if (unlinkShared)
   {
-    printf("Needs dataset and input file paths\n");
+    if (positionalCount != 0)
+    {
+      print_usage();
+      return EXIT_FAILURE;
+    }
+    gboolean removed = dataset_shared_unlink(unlinkShared);
+    if (!removed)
+      printf("No shared dataset named %s\n", unlinkShared);
+    return removed ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (connectSocket)
+  {
+    if (positionalCount != 1)
+    {
+      print_usage();
+      return EXIT_FAILURE;
+    }
+    OutputWriter *writer = output_writer_new("resultados", outputMode);
+    gboolean answered = query_client_run(connectSocket, positional[0], writer, NULL, NULL);
+    output_writer_free(writer);
+    if (!answered)
+      printf("Could not get every result from the server at %s\n", connectSocket);
+    return answered ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (serveSocket ? positionalCount < 1 || positionalCount > 2 : positionalCount < 2 || positionalCount > 3)
+  {
+    print_usage();
     return EXIT_FAILURE;
   }
 
-  const char *datasetPath = argv[1];
-  const char *inputFilePath = argv[2];
+  const char *datasetPath = positional[0];
+  const char *inputFilePath = serveSocket ? NULL : positional[1];
+  // With a name (e.g., "/flights-dataset"), jobs share one loaded copy of the dataset
+  const char *sharedName = positional[serveSocket ? 1 : 2];
+
+  // Workers are forked first, while the process is still small and single-threaded
+  ShardPool *pool = shards > 0 && !serveSocket ? shard_pool_spawn((guint)shards) : NULL;
 
   Dataset *ds = initDataset();
   gint errors = 0;
 
   initReport();
 
-  loadAllDatasets(ds, &errors, datasetPath, FALSE);
+  loadSharedDataset(ds, &errors, datasetPath, sharedName, FALSE);
   // if (!validateDataset(ds)) errors = 1;
 
-  runAllQueries(ds, inputFilePath, NULL, NULL);
-  cleanupDataset(ds);
+  if (serveSocket)
+  {
+    reportErrors(errors);
+    gboolean served = query_server_run(ds, serveSocket);
+    if (!served)
+      printf("Could not listen on %s\n", serveSocket);
+    cleanupDataset(ds);
+    reportDone();
+    return served ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  // Started after the fork: the workers must not inherit its thread
+  OutputWriter *writer = output_writer_new("resultados", outputMode);
+
+  gboolean answered = TRUE;
+  if (pool && shard_pool_distribute(pool, ds))
+  {
+    cleanupDataset(ds);
+    answered = runShardedQueries(pool, inputFilePath, writer, NULL, NULL);
+    if (!answered)
+      printf("A shard worker stopped answering: the results are incomplete\n");
+  }
+  else
+  {
+    runAllQueriesWith(ds, inputFilePath, writer, NULL, NULL);
+    cleanupDataset(ds);
+  }
+  output_writer_free(writer);
+  shard_pool_free(pool);
   reportErrors(errors);
   reportDone();
 
-  return EXIT_SUCCESS;
-}
\ No newline at end of file
+  return answered ? EXIT_SUCCESS : EXIT_FAILURE;
+}
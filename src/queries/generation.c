@@ -0,0 +1,170 @@
+#include "queries/generation.h"
+#include "io/manager.h"
+#include <glib.h>
+
+extern QueryManager *query_manager_create(Dataset *ds);
+extern void query_manager_destroy(QueryManager *qm);
+
+struct generation
+{
+  gint refCount;
+  guint id;
+  Dataset *ds;
+  QueryManager *qm;
+};
+
+struct generation_slot
+{
+  GMutex lock;
+  Generation *current;
+};
+
+struct generation_build
+{
+  GThread *thread;
+  gchar *path;
+  gint done;
+  gint errors;
+  Generation *result;
+};
+
+static gint lastGenerationId = 0;
+
+// --- Generations ---
+
+Generation *generation_new(Dataset *ds)
+{
+  if (!ds)
+    return NULL;
+  Generation *gen = g_new0(Generation, 1);
+  gen->refCount = 1;
+  gen->id = (guint)g_atomic_int_add(&lastGenerationId, 1) + 1;
+  gen->ds = ds;
+  gen->qm = query_manager_create(ds);
+  return gen;
+}
+
+Generation *generation_ref(Generation *gen)
+{
+  if (gen)
+    g_atomic_int_inc(&gen->refCount);
+  return gen;
+}
+
+void generation_unref(Generation *gen)
+{
+  if (!gen || !g_atomic_int_dec_and_test(&gen->refCount))
+    return;
+  // Query contexts may point into the dataset, so they go first
+  query_manager_destroy(gen->qm);
+  cleanupDataset(gen->ds);
+  g_free(gen);
+}
+
+Dataset *generation_get_dataset(const Generation *gen) { return gen ? gen->ds : NULL; }
+QueryManager *generation_get_manager(const Generation *gen) { return gen ? gen->qm : NULL; }
+guint generation_get_id(const Generation *gen) { return gen ? gen->id : 0; }
+
+// --- Slot ---
+
+GenerationSlot *generation_slot_new(Generation *initial)
+{
+  GenerationSlot *slot = g_new0(GenerationSlot, 1);
+  g_mutex_init(&slot->lock);
+  slot->current = initial;
+  return slot;
+}
+
+Generation *generation_slot_acquire(GenerationSlot *slot)
+{
+  if (!slot)
+    return NULL;
+  g_mutex_lock(&slot->lock);
+  Generation *gen = generation_ref(slot->current);
+  g_mutex_unlock(&slot->lock);
+  return gen;
+}
+
+void generation_slot_publish(GenerationSlot *slot, Generation *gen)
+{
+  if (!slot)
+    return;
+  g_mutex_lock(&slot->lock);
+  Generation *old = slot->current;
+  slot->current = gen;
+  g_mutex_unlock(&slot->lock);
+
+  // Outside the lock: this may tear down a whole dataset
+  generation_unref(old);
+}
+
+void generation_slot_free(GenerationSlot *slot)
+{
+  if (!slot)
+    return;
+  generation_unref(slot->current);
+  g_mutex_clear(&slot->lock);
+  g_free(slot);
+}
+
+// --- Background Builds ---
+
+static gpointer build_thread(gpointer data)
+{
+  GenerationBuild *build = data;
+
+  Dataset *ds = initDataset();
+  gint errors = 0;
+  // Invalid lines are only skipped; a file that could not be read at all fails the build
+  gboolean loaded = loadAllDatasets(ds, &errors, build->path, FALSE);
+
+  build->errors = errors;
+  if (loaded)
+  {
+    build->result = generation_new(ds);
+    // Every context is built here, so the first queries after the swap do not pay for it
+    int queryIds[QUERY_MODULE_COUNT];
+    for (int i = 0; i < QUERY_MODULE_COUNT; i++)
+      queryIds[i] = i + 1;
+    query_manager_prepare(build->result->qm, queryIds, QUERY_MODULE_COUNT);
+  }
+  else
+    cleanupDataset(ds);
+  g_atomic_int_set(&build->done, 1);
+  return NULL;
+}
+
+GenerationBuild *generation_build_start(const char *dataset_path)
+{
+  if (!dataset_path)
+    return NULL;
+  GenerationBuild *build = g_new0(GenerationBuild, 1);
+  build->path = g_strdup(dataset_path);
+  build->thread = g_thread_new("dataset-load", build_thread, build);
+  return build;
+}
+
+gboolean generation_build_is_done(GenerationBuild *build)
+{
+  return build ? g_atomic_int_get(&build->done) != 0 : FALSE;
+}
+
+Generation *generation_build_finish(GenerationBuild *build, gint *errors)
+{
+  if (!build)
+    return NULL;
+  g_thread_join(build->thread);
+
+  Generation *gen = build->result;
+  if (errors)
+    *errors = build->errors;
+
+  g_free(build->path);
+  g_free(build);
+  return gen;
+}
+
+const char *generation_build_get_path(const GenerationBuild *build)
+{
+  return build ? build->path : NULL;
+}
@@ -5,6 +5,7 @@
 #include <ctype.h>
 #include "queries/queries.h"
 #include "queries/query_module.h"
+#include "core/dataset_parallel.h"
 
 extern QueryModule get_query1_module(void);
 extern QueryModule get_query2_module(void);
@@ -12,161 +13,465 @@ extern QueryModule get_query3_module(void);
 extern QueryModule get_query4_module(void);
 extern QueryModule get_query5_module(void);
 extern QueryModule get_query6_module(void);
+extern QueryModule get_query7_module(void);
+
+// Bounds of the result cache: past either one, the least recently used results go first
+#define RESULT_CACHE_MAX_ENTRIES 4096
+#define RESULT_CACHE_MAX_BYTES (64u << 20)
+// Larger results are not kept: they would push out many cheap ones
+#define RESULT_CACHE_MAX_RESULT (1u << 20)
+
+// One rendered result, keyed by query, variant and arguments
+typedef struct
+{
+  gchar *key;
+  GBytes *output;
+  GList *link; // Position in the recency list
+} CachedResult;
+
+// A module and its context, which is built on first use
+typedef struct
+{
+  QueryModule module;
+  gsize ready; // Once-guard of the context
+  void *context;
+} ModuleSlot;
 
 struct QueryManager
 {
-  GHashTable *modules;
-  GHashTable *contexts;
+  Dataset *ds;          // The dataset the contexts are built on
+  GHashTable *modules;  // id -> ModuleSlot
+  GMutex cacheLock; // Guards everything below
+  GHashTable *cache; // key -> CachedResult
+  GQueue recency;    // CachedResult, most recently used first
+  gsize cacheBytes;
+  const Dataset *cachedDataset; // The dataset the cached results were computed on
+  guint64 cacheHits;
+  guint64 cacheMisses;
 };
 
+// --- Result Cache ---
+
+static void free_cached_result(gpointer data)
+{
+  CachedResult *entry = data;
+  g_bytes_unref(entry->output);
+  g_free(entry->key);
+  g_free(entry);
+}
+
+// Caller holds cacheLock
+static void cache_remove(QueryManager *qm, CachedResult *entry)
+{
+  qm->cacheBytes -= g_bytes_get_size(entry->output);
+  g_queue_delete_link(&qm->recency, entry->link);
+  g_hash_table_remove(qm->cache, entry->key);
+}
+
+// Caller holds cacheLock
+static void cache_reset(QueryManager *qm, const Dataset *ds)
+{
+  g_hash_table_remove_all(qm->cache);
+  g_queue_clear(&qm->recency);
+  qm->cacheBytes = 0;
+  qm->cachedDataset = ds;
+}
+
+// The arguments are taken as `query_command_parse()` left them: NULL and "" differ
+static gchar *cache_key(int queryId, const char *arg1, const char *arg2, int isSpecial)
+{
+  return g_strdup_printf("%d%c\n%c%s\n%c%s", queryId, isSpecial ? 'S' : ' ', arg1 ? '+' : '-', arg1 ? arg1 : "",
+                         arg2 ? '+' : '-', arg2 ? arg2 : "");
+}
+
+// Returns a reference to the cached result, or NULL
+static GBytes *cache_lookup(QueryManager *qm, const char *key, const Dataset *ds)
+{
+  GBytes *output = NULL;
+  g_mutex_lock(&qm->cacheLock);
+  if (qm->cachedDataset != ds)
+    cache_reset(qm, ds);
+
+  CachedResult *entry = g_hash_table_lookup(qm->cache, key);
+  if (entry)
+  {
+    g_queue_unlink(&qm->recency, entry->link);
+    g_queue_push_head_link(&qm->recency, entry->link);
+    output = g_bytes_ref(entry->output);
+    qm->cacheHits++;
+  }
+  else
+  {
+    qm->cacheMisses++;
+  }
+  g_mutex_unlock(&qm->cacheLock);
+  return output;
+}
+
+// Takes ownership of key and output
+static void cache_store(QueryManager *qm, gchar *key, GBytes *output, const Dataset *ds)
+{
+  g_mutex_lock(&qm->cacheLock);
+  // Another thread may have computed the same result, or the dataset changed meanwhile
+  if (qm->cachedDataset != ds || g_hash_table_contains(qm->cache, key))
+  {
+    g_mutex_unlock(&qm->cacheLock);
+    g_bytes_unref(output);
+    g_free(key);
+    return;
+  }
+
+  CachedResult *entry = g_new(CachedResult, 1);
+  entry->key = key;
+  entry->output = output;
+  g_queue_push_head(&qm->recency, entry);
+  entry->link = qm->recency.head;
+  g_hash_table_insert(qm->cache, key, entry);
+  qm->cacheBytes += g_bytes_get_size(output);
+
+  while (qm->recency.length > RESULT_CACHE_MAX_ENTRIES || qm->cacheBytes > RESULT_CACHE_MAX_BYTES)
+    cache_remove(qm, g_queue_peek_tail(&qm->recency));
+  g_mutex_unlock(&qm->cacheLock);
+}
+
+void query_manager_cache_clear(QueryManager *qm)
+{
+  if (!qm)
+    return;
+  g_mutex_lock(&qm->cacheLock);
+  cache_reset(qm, NULL);
+  g_mutex_unlock(&qm->cacheLock);
+}
+
+void query_manager_cache_stats(QueryManager *qm, guint64 *hits, guint64 *misses)
+{
+  if (!qm)
+    return;
+  g_mutex_lock(&qm->cacheLock);
+  if (hits)
+    *hits = qm->cacheHits;
+  if (misses)
+    *misses = qm->cacheMisses;
+  g_mutex_unlock(&qm->cacheLock);
+}
+
+// --- Manager ---
+
+// Builds the module's context the first time it is needed; safe from any thread
+static void *module_context(QueryManager *qm, ModuleSlot *slot)
+{
+  if (g_once_init_enter(&slot->ready))
+  {
+    slot->context = slot->module.init ? slot->module.init(qm->ds) : NULL;
+    g_once_init_leave(&slot->ready, 1);
+  }
+  return slot->context;
+}
+
 QueryManager *query_manager_create(Dataset *ds)
 {
   QueryManager *qm = g_new0(QueryManager, 1);
+  qm->ds = ds;
   qm->modules = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
-  qm->contexts = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_mutex_init(&qm->cacheLock);
+  qm->cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_cached_result);
+  g_queue_init(&qm->recency);
+  qm->cachedDataset = ds;
 
-  QueryModule mods[6];
-  mods[0] = get_query1_module();
-  mods[1] = get_query2_module();
-  mods[2] = get_query3_module();
-  mods[3] = get_query4_module();
-  mods[4] = get_query5_module();
-  mods[5] = get_query6_module();
+  QueryModule mods[QUERY_MODULE_COUNT];
+  query_modules_collect(mods);
 
-  for (int i = 0; i < 6; i++)
+  // Contexts are left for query_manager_prepare() or the first command of each query
+  for (int i = 0; i < QUERY_MODULE_COUNT; i++)
   {
-    QueryModule *m = g_new(QueryModule, 1);
-    *m = mods[i];
-    g_hash_table_insert(qm->modules, GINT_TO_POINTER(m->id), m);
-    if (m->init)
-    {
-      void *ctx = m->init(ds);
-      g_hash_table_insert(qm->contexts, GINT_TO_POINTER(m->id), ctx);
-    }
+    ModuleSlot *slot = g_new0(ModuleSlot, 1);
+    slot->module = mods[i];
+    g_hash_table_insert(qm->modules, GINT_TO_POINTER(mods[i].id), slot);
   }
   return qm;
 }
 
+typedef struct
+{
+  QueryManager *qm;
+  ModuleSlot **slots;
+} PrepareJob;
+
+static void prepare_module(guint index, gpointer user_data)
+{
+  PrepareJob *job = user_data;
+  module_context(job->qm, job->slots[index]);
+}
+
+void query_manager_prepare(QueryManager *qm, const int *queryIds, guint count)
+{
+  if (!qm || !queryIds)
+    return;
+
+  // Each module once, and only those with a context still to build
+  ModuleSlot *slots[QUERY_MODULE_COUNT];
+  guint pending = 0;
+  for (guint i = 0; i < count; i++)
+  {
+    ModuleSlot *slot = g_hash_table_lookup(qm->modules, GINT_TO_POINTER(queryIds[i]));
+    if (!slot || !slot->module.init || g_atomic_pointer_get(&slot->ready))
+      continue;
+    gboolean seen = FALSE;
+    for (guint j = 0; j < pending && !seen; j++)
+      seen = slots[j] == slot;
+    if (!seen)
+      slots[pending++] = slot;
+  }
+
+  // The inits only read the dataset, so they run side by side
+  PrepareJob job = {.qm = qm, .slots = slots};
+  dataset_parallel_foreach_index(pending, prepare_module, &job);
+}
+
 void query_manager_destroy(QueryManager *qm)
 {
   if (!qm)
     return;
   GHashTableIter iter;
-  gpointer key, value;
+  gpointer value;
   g_hash_table_iter_init(&iter, qm->modules);
-  while (g_hash_table_iter_next(&iter, &key, &value))
+  while (g_hash_table_iter_next(&iter, NULL, &value))
   {
-    QueryModule *mod = (QueryModule *)value;
-    void *ctx = g_hash_table_lookup(qm->contexts, key);
-    if (mod->destroy && ctx)
-      mod->destroy(ctx);
+    ModuleSlot *slot = value;
+    if (slot->module.destroy && slot->context)
+      slot->module.destroy(slot->context);
   }
-  g_hash_table_destroy(qm->contexts);
   g_hash_table_destroy(qm->modules);
+  g_queue_clear(&qm->recency);
+  g_hash_table_destroy(qm->cache);
+  g_mutex_clear(&qm->cacheLock);
   g_free(qm);
 }
 
+// *cached (optional) tells whether the result came from the cache
 int query_manager_execute(QueryManager *qm, int queryId, char *arg1, char *arg2,
-                          int isSpecial, FILE *output, Dataset *ds)
+                          int isSpecial, FILE *output, Dataset *ds, gboolean *cached)
 {
+  if (cached)
+    *cached = FALSE;
   if (!qm)
     return -1;
-  QueryModule *mod = g_hash_table_lookup(qm->modules, GINT_TO_POINTER(queryId));
-  void *qCtx = g_hash_table_lookup(qm->contexts, GINT_TO_POINTER(queryId));
-  if (mod && mod->run)
+  ModuleSlot *slot = g_hash_table_lookup(qm->modules, GINT_TO_POINTER(queryId));
+  if (!slot || !slot->module.run)
+    return -1;
+  const QueryModule *mod = &slot->module;
+
+  // A repeated command is answered with the bytes rendered the first time
+  gchar *key = cache_key(queryId, arg1, arg2, isSpecial);
+  GBytes *hit = cache_lookup(qm, key, ds);
+  if (hit)
   {
+    gsize size = 0;
+    gconstpointer data = g_bytes_get_data(hit, &size);
+    fwrite(data, 1, size, output);
+    g_bytes_unref(hit);
+    g_free(key);
+    if (cached)
+      *cached = TRUE;
+    return 0;
+  }
+
+  void *qCtx = module_context(qm, slot);
+  char *rendered = NULL;
+  size_t renderedSize = 0;
+  FILE *buffer = open_memstream(&rendered, &renderedSize);
+  if (!buffer)
+  {
+    g_free(key);
     mod->run(qCtx, ds, arg1, arg2, isSpecial, output);
     return 0;
   }
-  return -1;
+  mod->run(qCtx, ds, arg1, arg2, isSpecial, buffer);
+  fclose(buffer);
+  fwrite(rendered, 1, renderedSize, output);
+
+  if (renderedSize <= RESULT_CACHE_MAX_RESULT)
+    cache_store(qm, key, g_bytes_new_take(rendered, renderedSize), ds);
+  else
+  {
+    free(rendered);
+    g_free(key);
+  }
+  return 0;
 }
 
-void runAllQueries(Dataset *ds, const char *filePath, QueryStatsCallback callback, void *ctx)
+void query_modules_collect(QueryModule mods[QUERY_MODULE_COUNT])
 {
-  QueryManager *qm = query_manager_create(ds);
-  if (!qm)
-    return;
+  mods[0] = get_query1_module();
+  mods[1] = get_query2_module();
+  mods[2] = get_query3_module();
+  mods[3] = get_query4_module();
+  mods[4] = get_query5_module();
+  mods[5] = get_query6_module();
+  mods[6] = get_query7_module();
+}
 
-  FILE *inputFile = fopen(filePath, "r");
-  if (!inputFile)
+int query_command_parse(char *line, QueryCommand *cmd)
+{
+  line[strcspn(line, "\r\n")] = '\0';
+  if (strlen(line) == 0)
+    return -1;
+
+  char queryIdStr[16];
+  int bytesRead = 0;
+  if (sscanf(line, "%15s%n", queryIdStr, &bytesRead) < 1)
+    return 0;
+
+  cmd->isSpecial = 0;
+  size_t idLen = strlen(queryIdStr);
+  if (idLen > 0 && isalpha(queryIdStr[idLen - 1]))
   {
-    query_manager_destroy(qm);
-    return;
+    cmd->isSpecial = 1;
+    queryIdStr[idLen - 1] = '\0';
   }
+  cmd->queryNumber = atoi(queryIdStr);
 
-  char line[1024];
-  int lineNumber = 1;
+  char *argsArea = line + bytesRead;
+  while (isspace(*argsArea))
+    argsArea++;
 
-  while (fgets(line, sizeof(line), inputFile))
-  {
-    line[strcspn(line, "\r\n")] = '\0';
-    if (strlen(line) == 0)
-      continue;
+  cmd->arg1 = NULL;
+  cmd->arg2 = NULL;
 
-    char queryIdStr[16];
-    int bytesRead = 0;
-    if (sscanf(line, "%15s%n", queryIdStr, &bytesRead) < 1)
+  if (*argsArea != '\0')
+  {
+    if (cmd->queryNumber == 2 || cmd->queryNumber == 3 || cmd->queryNumber == 4)
     {
-      lineNumber++;
-      continue;
+      cmd->arg1 = argsArea;
+      char *space = strchr(argsArea, ' ');
+      if (space)
+      {
+        *space = '\0';
+        cmd->arg2 = space + 1;
+        while (isspace(*cmd->arg2))
+          cmd->arg2++;
+      }
     }
-
-    int isSpecial = 0;
-    size_t idLen = strlen(queryIdStr);
-    if (idLen > 0 && isalpha(queryIdStr[idLen - 1]))
+    else
     {
-      isSpecial = 1;
-      queryIdStr[idLen - 1] = '\0';
+      cmd->arg1 = argsArea;
     }
-    int queryNumber = atoi(queryIdStr);
+  }
+  return 1;
+}
 
-    char *argsArea = line + bytesRead;
-    while (isspace(*argsArea))
-      argsArea++;
+// One command of the commands file, parsed before anything runs
+typedef struct
+{
+  QueryCommand cmd;
+  int lineNumber;
+  gchar *line; // Owns the strings the arguments point into
+  gdouble elapsed;
+  gboolean cached;
+  gboolean written;
+} BatchCommand;
 
-    char *arg1 = NULL;
-    char *arg2 = NULL;
+typedef struct
+{
+  QueryManager *qm;
+  Dataset *ds;
+  OutputWriter *writer;
+  BatchCommand *commands;
+} BatchJob;
+
+// Reads and parses every command, numbering them as the output files expect
+static GArray *read_commands(FILE *inputFile)
+{
+  GArray *commands = g_array_new(FALSE, FALSE, sizeof(BatchCommand));
+  char line[1024];
+  int lineNumber = 1;
 
-    if (*argsArea != '\0')
+  while (fgets(line, sizeof(line), inputFile))
+  {
+    BatchCommand c = {.line = g_strdup(line)};
+    int parsed = query_command_parse(c.line, &c.cmd);
+    if (parsed <= 0)
     {
-      if (queryNumber == 2 || queryNumber == 3 || queryNumber == 4)
-      {
-        arg1 = argsArea;
-        char *space = strchr(argsArea, ' ');
-        if (space)
-        {
-          *space = '\0';
-          arg2 = space + 1;
-          while (isspace(*arg2))
-            arg2++;
-        }
-      }
-      else
-      {
-        arg1 = argsArea;
-      }
+      g_free(c.line);
+      if (parsed == 0)
+        lineNumber++;
+      continue;
     }
+    c.lineNumber = lineNumber++;
+    g_array_append_val(commands, c);
+  }
+  return commands;
+}
+
+// Runs on a worker thread: the modules' contexts and the dataset are only read
+static void run_batch_command(guint index, gpointer user_data)
+{
+  BatchJob *job = user_data;
+  BatchCommand *c = &job->commands[index];
 
-    char outputFileName[64];
-    snprintf(outputFileName, sizeof(outputFileName), "resultados/command%d_output.txt", lineNumber);
-    FILE *output = fopen(outputFileName, "w");
+  if (!job->writer)
+    return;
+  OutputBuffer *buffer = output_writer_acquire(job->writer, c->lineNumber);
+  FILE *output = output_buffer_stream(buffer);
 
-    if (output)
-    {
-      GTimer *timer = g_timer_new();
-      if (query_manager_execute(qm, queryNumber, arg1, arg2, isSpecial, output, ds) != 0)
-      {
-        fprintf(output, "\n");
-      }
-      gdouble elapsed = g_timer_elapsed(timer, NULL);
-      g_timer_destroy(timer);
-      fclose(output);
-      if (callback)
-        callback(queryNumber, lineNumber, elapsed, ctx);
-    }
-    lineNumber++;
+  GTimer *timer = g_timer_new();
+  if (query_manager_execute(job->qm, c->cmd.queryNumber, c->cmd.arg1, c->cmd.arg2, c->cmd.isSpecial, output,
+                            job->ds, &c->cached) != 0)
+  {
+    fprintf(output, "\n");
   }
+  c->elapsed = g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+  output_writer_submit(job->writer, buffer);
+  c->written = TRUE;
+}
 
+void runAllQueries(Dataset *ds, const char *filePath, QueryStatsCallback callback, void *ctx)
+{
+  OutputWriter *writer = output_writer_new("resultados", OUTPUT_FILES);
+  runAllQueriesWith(ds, filePath, writer, callback, ctx);
+  output_writer_free(writer);
+}
+
+void runAllQueriesWith(Dataset *ds, const char *filePath, OutputWriter *writer, QueryStatsCallback callback,
+                       void *ctx)
+{
+  FILE *inputFile = fopen(filePath, "r");
+  if (!inputFile)
+    return;
+  GArray *commands = read_commands(inputFile);
   fclose(inputFile);
+
+  QueryManager *qm = query_manager_create(ds);
+  if (!qm)
+  {
+    g_array_free(commands, TRUE);
+    return;
+  }
+
+  // Only the queries the file asks for get a context, built before the first command runs
+  int *queryIds = g_new(int, commands->len + 1);
+  for (guint i = 0; i < commands->len; i++)
+    queryIds[i] = g_array_index(commands, BatchCommand, i).cmd.queryNumber;
+  query_manager_prepare(qm, queryIds, commands->len);
+  g_free(queryIds);
+
+  // Commands are independent: they run on the worker threads, whose idle
+  // members steal from the busy ones (a wide Q4 range costs far more than a Q1)
+  BatchJob job = {.qm = qm, .ds = ds, .writer = writer, .commands = (BatchCommand *)(void *)commands->data};
+  dataset_parallel_foreach_index(commands->len, run_batch_command, &job);
+
+  // Callbacks fire on the calling thread, in command order, once the results are on disk
+  if (writer)
+    output_writer_flush(writer);
+  for (guint i = 0; i < commands->len; i++)
+  {
+    BatchCommand *c = &job.commands[i];
+    if (callback && c->written)
+      callback(c->cmd.queryNumber, c->lineNumber, c->elapsed, c->cached, ctx);
+    g_free(c->line);
+  }
+
+  g_array_free(commands, TRUE);
   query_manager_destroy(qm);
-}
\ No newline at end of file
+}
@@ -2,9 +2,12 @@
 #include <queries/query_module.h> // Include the interface
 #include <core/dataset.h>
 #include <core/statistics.h>
+#include <core/time_utils.h>
+#include <io/output_builder.h>
 #include "entities/access/airports_access.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 // --- Core Logic (Unchanged) ---
 
@@ -35,41 +38,350 @@ gchar *query1(const gchar *code, const Dataset *ds)
 
   return result;
 }
+// --- Pre-rendered Answers ---
+
+// Airport codes are three uppercase letters (see checkAirportCode()): each one has a slot in a dense table
+#define Q1_CODE_SLOTS (26 * 26 * 26)
+
+typedef struct
+{
+  gchar *text;                   // Every answer, its ';' line immediately followed by its '=' line
+  guint32 offset[Q1_CODE_SLOTS]; // Start of the ';' line of each code
+  guint32 length[Q1_CODE_SLOTS]; // Length of one line (terminator included), 0 for unknown codes
+  GHashTable *daily;             // Code -> AirportDailyTraffic, for date windows
+} Q1Answers;
+
+// Returns the slot of a code of @p len characters, or -1 if it cannot be an airport code
+static int q1_code_slot(const char *code, size_t len)
+{
+  if (!code || len != 3)
+    return -1;
+  int slot = 0;
+  for (size_t i = 0; i < 3; i++)
+  {
+    if (code[i] < 'A' || code[i] > 'Z')
+      return -1;
+    slot = slot * 26 + (code[i] - 'A');
+  }
+  return slot;
+}
+
+// Writes the result line straight from the airport and its counters
+static void q1_write(OutputBuilder *b, const char *code, const Airport *airport, long arrivals, long departures)
+{
+  output_builder_string(b, code);
+  output_builder_separator(b);
+  output_builder_string(b, getAirportName(airport));
+  output_builder_separator(b);
+  output_builder_string(b, getAirportCity(airport));
+  output_builder_separator(b);
+  output_builder_string(b, getAirportCountry(airport));
+  output_builder_separator(b);
+  output_builder_string(b, getAirportType(airport));
+  output_builder_separator(b);
+  output_builder_int(b, arrivals);
+  output_builder_separator(b);
+  output_builder_int(b, departures);
+  output_builder_char(b, '\n');
+}
+
+// The answers only depend on the airport and its statistics, which are fixed once loaded
+static void *q1_init_wrapper(Dataset *ds)
+{
+  if (!ds)
+    return NULL;
+
+  Q1Answers *answers = g_new0(Q1Answers, 1);
+  size_t textSize = 0;
+  FILE *text = open_memstream(&answers->text, &textSize);
+  if (!text)
+  {
+    g_free(answers);
+    return NULL;
+  }
+
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  DatasetStringIterator *codes = dataset_airport_codes_iter_new(ds);
+  const char *code;
+  while ((code = dataset_string_iter_next(codes)) != NULL)
+  {
+    int slot = q1_code_slot(code, strlen(code));
+    const Airport *airport = dataset_get_airport(ds, code);
+    if (slot < 0 || !airport || answers->length[slot] > 0)
+      continue;
+
+    const AirportPassengerStats *stats = dataset_get_airport_stats(ds, code);
+    long start = ftell(text);
+    for (int isSpecial = 0; isSpecial <= 1; isSpecial++)
+    {
+      output_builder_init(&b, buffer, sizeof(buffer), isSpecial, text);
+      q1_write(&b, code, airport, getAirportArrivals(stats), getAirportDepartures(stats));
+      output_builder_flush(&b);
+    }
+    answers->offset[slot] = (guint32)start;
+    answers->length[slot] = (guint32)((ftell(text) - start) / 2);
+  }
+  dataset_string_iter_free(codes);
+  fclose(text);
+
+  answers->daily = calculate_airport_daily_traffic(ds);
+  return answers;
+}
+
+static void q1_destroy_wrapper(void *ctx)
+{
+  Q1Answers *answers = ctx;
+  if (!answers)
+    return;
+  free(answers->text);
+  if (answers->daily)
+    g_hash_table_destroy(answers->daily);
+  g_free(answers);
+}
+
+// Writes the answer of one code, or an empty line
+static void q1_answer(const Q1Answers *answers, const char *code, size_t len, int isSpecial, FILE *output)
+{
+  int slot = q1_code_slot(code, len);
+  guint32 length = slot >= 0 ? answers->length[slot] : 0;
+  if (length == 0)
+  {
+    fputc('\n', output);
+    return;
+  }
+  fwrite(answers->text + answers->offset[slot] + (isSpecial ? length : 0), 1, length, output);
+}
+
+// TRUE if @p arg lists several whitespace-separated codes
+static gboolean q1_is_bulk(const char *arg)
+{
+  const char *p = arg;
+  while (*p && !g_ascii_isspace(*p))
+    p++;
+  while (g_ascii_isspace(*p))
+    p++;
+  return *p != '\0';
+}
+
+// The codes of a command, and the date window that may follow them
+typedef struct
+{
+  gchar **codes; // NULL-terminated
+  gboolean windowed;
+  time_t from;
+  time_t to;
+} Q1Request;
+
+// Splits the arguments into codes; two dates after at least one code ("1 LIS 2023-01-01 2023-03-31") set a window
+static void q1_request_parse(const char *arg, Q1Request *req)
+{
+  req->codes = g_strsplit_set(arg, " \t\v\f", -1);
+  guint n = 0;
+  for (guint i = 0; req->codes[i]; i++)
+  {
+    if (*req->codes[i])
+      req->codes[n++] = req->codes[i];
+    else
+      g_free(req->codes[i]);
+  }
+  req->codes[n] = NULL;
+
+  req->windowed = n >= 3 && parse_date_argument(req->codes[n - 2], &req->from) &&
+                  parse_date_argument(req->codes[n - 1], &req->to);
+  if (req->windowed)
+  {
+    g_free(req->codes[n - 2]);
+    g_free(req->codes[n - 1]);
+    req->codes[n - 2] = NULL;
+  }
+}
+
+// Writes the answer of one code with the traffic of the window only, or an empty line
+static void q1_answer_window(const Q1Answers *answers, const Dataset *ds, const Q1Request *req, const char *code,
+                             int isSpecial, FILE *output)
+{
+  int slot = q1_code_slot(code, strlen(code));
+  const Airport *airport = slot >= 0 && answers->length[slot] > 0 ? dataset_get_airport(ds, code) : NULL;
+  if (!airport)
+  {
+    fputc('\n', output);
+    return;
+  }
+
+  long arrivals, departures;
+  getAirportTrafficBetween(answers->daily ? g_hash_table_lookup(answers->daily, code) : NULL, req->from, req->to,
+                           &arrivals, &departures);
+
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+  q1_write(&b, code, airport, arrivals, departures);
+  output_builder_flush(&b);
+}
+
+// Bulk mode ("1 LIS OPO FAO") answers every code, one line each, in order
 static void q1_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
 {
+  (void)arg2;
+  const Q1Answers *answers = ctx;
 
-  (void)ctx;
+  if (!answers || !arg1)
+  {
+    fputc('\n', output);
+    return;
+  }
+  if (!q1_is_bulk(arg1))
+  {
+    q1_answer(answers, arg1, strlen(arg1), isSpecial, output);
+    return;
+  }
+
+  Q1Request req;
+  q1_request_parse(arg1, &req);
+  for (int i = 0; req.codes[i]; i++)
+  {
+    if (req.windowed)
+      q1_answer_window(answers, ds, &req, req.codes[i], isSpecial, output);
+    else
+      q1_answer(answers, req.codes[i], strlen(req.codes[i]), isSpecial, output);
+  }
+  g_strfreev(req.codes);
+}
+
+// --- Sharded Execution ---
+
+// A shard only counts the legs of its own flights: it sends one line per code (empty if unknown),
+// and the coordinator sums the counters line by line
+static void q1_partial_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
   (void)arg2;
+  (void)isSpecial;
+  const Q1Answers *answers = ctx;
+
+  if (!arg1)
+    return;
 
-  gchar *res = query1(arg1, ds);
+  if (!q1_is_bulk(arg1))
+  {
+    gchar *res = query1(arg1, ds);
+    fprintf(output, "%s\n", res ? res : "");
+    g_free(res);
+    return;
+  }
 
-  if (res)
+  Q1Request req;
+  q1_request_parse(arg1, &req);
+  for (int i = 0; req.codes[i]; i++)
   {
-    if (isSpecial)
+    if (req.windowed && answers)
     {
-      for (char *p = res; *p; p++)
-      {
-        if (*p == ';')
-          *p = '=';
-      }
+      q1_answer_window(answers, ds, &req, req.codes[i], 0, output);
+      continue;
     }
-    fprintf(output, "%s\n", res);
+    gchar *res = req.windowed ? NULL : query1(req.codes[i], ds);
+    fprintf(output, "%s\n", res ? res : "");
     g_free(res);
   }
-  else
+  g_strfreev(req.codes);
+}
+
+// Writes one merged answer: the line with the counters of every shard summed up
+static void q1_merge_line(char **lines, int count, OutputBuilder *b)
+{
+  gchar *airport = NULL;
+  long arrivals = 0, departures = 0;
+  for (int s = 0; s < count; s++)
   {
-    fprintf(output, "\n");
+    char *line = lines[s];
+    if (!line)
+      continue;
+
+    // The counters are the last two fields
+    char *depSep = strrchr(line, ';');
+    if (!depSep)
+      continue;
+    *depSep = '\0';
+    char *arrSep = strrchr(line, ';');
+    if (!arrSep)
+      continue;
+    *arrSep = '\0';
+
+    arrivals += atol(arrSep + 1);
+    departures += atol(depSep + 1);
+    if (!airport)
+      airport = line;
   }
+
+  if (airport)
+  {
+    // The line up to the counters, with the separators of the variant
+    for (const char *p = airport; *p; p++)
+    {
+      if (*p == ';')
+        output_builder_separator(b);
+      else
+        output_builder_char(b, *p);
+    }
+    output_builder_separator(b);
+    output_builder_int(b, arrivals);
+    output_builder_separator(b);
+    output_builder_int(b, departures);
+  }
+  output_builder_char(b, '\n');
 }
 
+static void q1_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+  (void)arg1;
+  (void)arg2;
+
+  // Every shard sent the same number of lines, one per code
+  gchar ***lines = g_new0(gchar **, count);
+  guint *lineCounts = g_new0(guint, count);
+  guint answers = 0;
+  for (int s = 0; s < count; s++)
+  {
+    lines[s] = g_strsplit(partials[s], "\n", -1);
+    guint n = g_strv_length(lines[s]);
+    // The last line ends with a terminator: its empty remainder is not an answer
+    if (n > 0 && *lines[s][n - 1] == '\0')
+      n--;
+    lineCounts[s] = n;
+    answers = MAX(answers, n);
+  }
+  // No code at all still gets its empty line
+  if (answers == 0)
+    answers = 1;
+
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+  char **column = g_new0(char *, count);
+  for (guint i = 0; i < answers; i++)
+  {
+    for (int s = 0; s < count; s++)
+      column[s] = i < lineCounts[s] ? lines[s][i] : NULL;
+    q1_merge_line(column, count, &b);
+  }
+  output_builder_flush(&b);
+
+  g_free(column);
+  g_free(lineCounts);
+  for (int s = 0; s < count; s++)
+    g_strfreev(lines[s]);
+  g_free(lines);
+}
 
 QueryModule get_query1_module(void)
 {
   QueryModule mod = {
       .id = 1,
-      .init = NULL,
+      .init = q1_init_wrapper,
       .run = q1_run_wrapper,
-      .destroy = NULL
-  };
+      .destroy = q1_destroy_wrapper,
+      .partial = q1_partial_wrapper,
+      .merge = q1_merge_wrapper};
   return mod;
 }
\ No newline at end of file
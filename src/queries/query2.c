@@ -1,8 +1,10 @@
 #include <queries/query2.h>
 #include <queries/query_module.h>
 #include <core/dataset.h>
+#include <core/time_utils.h>
 #include <entities/access/aircrafts_access.h>
 #include <entities/access/flights_access.h>
+#include <io/output_builder.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -26,11 +28,24 @@ typedef struct
   int count;
 } AircraftCount;
 
+// A run of the per-manufacturer ranking
+typedef struct
+{
+  guint start;
+  guint length;
+} Q2Slice;
+
 // The Context object for the Module
 typedef struct
 {
   GPtrArray *aircrafts;
   int *flightCounts;
+  guint rankedCount;              // Aircraft with at least one flight
+  guint32 *ranking;               // Their indices in aircrafts, highest count first, then alphabetical ID
+  guint32 *rankingByManufacturer; // The same, grouped by manufacturer (ranking order within each group)
+  GHashTable *manufacturers;      // Manufacturer -> Q2Slice of rankingByManufacturer
+  time_t *departures;             // Actual departures of the counted flights, grouped by aircraft, ascending
+  guint *departuresStart;         // Aircraft i owns departures[departuresStart[i] .. departuresStart[i + 1])
 } Q2Context;
 
 // --- Heap Logic (Optimized for Top N) ---
@@ -205,50 +220,323 @@ void free_aircraftstats_array(AircraftStats **array, int size)
   g_free(array);
 }
 
+// --- Rankings ---
+
+typedef struct
+{
+  guint32 index;
+  guint32 rank;
+  int count;
+  const char *id;
+  const char *manufacturer;
+} Q2Candidate;
+
+// Highest count first, then alphabetical ID (the order of query2())
+static int compare_candidates(const void *a, const void *b)
+{
+  const Q2Candidate *ca = a;
+  const Q2Candidate *cb = b;
+  if (ca->count != cb->count)
+    return ca->count > cb->count ? -1 : 1;
+  return strcmp(ca->id, cb->id);
+}
+
+// Groups by manufacturer, keeping the ranking order within each group
+static int compare_candidates_by_manufacturer(const void *a, const void *b)
+{
+  const Q2Candidate *ca = a;
+  const Q2Candidate *cb = b;
+  int cmp = strcmp(ca->manufacturer, cb->manufacturer);
+  if (cmp != 0)
+    return cmp;
+  return (ca->rank > cb->rank) - (ca->rank < cb->rank);
+}
+
+// Sorts the aircraft with flights once, globally and per manufacturer, so every command is a prefix of a list
+static void q2_build_rankings(Q2Context *ctx)
+{
+  guint numAircrafts = ctx->aircrafts->len;
+  Q2Candidate *candidates = g_new(Q2Candidate, numAircrafts);
+  guint n = 0;
+  for (guint i = 0; i < numAircrafts; i++)
+  {
+    if (ctx->flightCounts[i] == 0)
+      continue;
+    const Aircraft *ac = g_ptr_array_index(ctx->aircrafts, i);
+    const char *manuf = getAircraftManufacturer(ac);
+    candidates[n++] = (Q2Candidate){.index = i,
+                                    .count = ctx->flightCounts[i],
+                                    .id = getAircraftId(ac),
+                                    .manufacturer = manuf ? manuf : ""};
+  }
+
+  qsort(candidates, n, sizeof(Q2Candidate), compare_candidates);
+  ctx->rankedCount = n;
+  ctx->ranking = g_new(guint32, n);
+  for (guint i = 0; i < n; i++)
+  {
+    candidates[i].rank = i;
+    ctx->ranking[i] = candidates[i].index;
+  }
+
+  qsort(candidates, n, sizeof(Q2Candidate), compare_candidates_by_manufacturer);
+  ctx->rankingByManufacturer = g_new(guint32, n);
+  ctx->manufacturers = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+  Q2Slice *slice = NULL;
+  for (guint i = 0; i < n; i++)
+  {
+    ctx->rankingByManufacturer[i] = candidates[i].index;
+    if (!slice || strcmp(candidates[i].manufacturer, candidates[i - 1].manufacturer) != 0)
+    {
+      slice = g_new(Q2Slice, 1);
+      slice->start = i;
+      slice->length = 0;
+      // The key lives in the aircraft, which outlives the context
+      g_hash_table_insert(ctx->manufacturers, (gpointer)candidates[i].manufacturer, slice);
+    }
+    slice->length++;
+  }
+  g_free(candidates);
+}
+
+// The ranking of the aircraft of one manufacturer (all of them when @p filter is NULL)
+static const guint32 *q2_ranking(const Q2Context *ctx, const char *filter, guint *length)
+{
+  if (!filter)
+  {
+    *length = ctx->rankedCount;
+    return ctx->ranking;
+  }
+  const Q2Slice *slice = g_hash_table_lookup(ctx->manufacturers, filter);
+  *length = slice ? slice->length : 0;
+  return slice ? ctx->rankingByManufacturer + slice->start : NULL;
+}
+
+// --- Date Windows ---
+
+typedef struct
+{
+  const Flight *const *rows;
+  time_t *out;
+  guint length;
+} DepartureFill;
+
+static void collect_departure(guint32 row, gpointer user_data)
+{
+  DepartureFill *fill = user_data;
+  time_t departure = getFlightActualDeparture(fill->rows[row]);
+  if (departure >= 0)
+    fill->out[fill->length++] = departure;
+}
+
+// Keeps the departure times of every aircraft's counted flights, sorted, so a window is two binary searches
+static void q2_build_departures(Q2Context *ctx, const Dataset *ds, const Bitmap *cancelled)
+{
+  guint numAircrafts = ctx->aircrafts->len;
+  gsize total = 0;
+  for (guint i = 0; i < numAircrafts; i++)
+    total += (gsize)ctx->flightCounts[i];
+
+  guint nRows = 0;
+  DepartureFill fill = {.rows = dataset_flight_rows(ds, &nRows), .out = g_new(time_t, MAX(total, 1))};
+  ctx->departures = fill.out;
+  ctx->departuresStart = g_new(guint, numAircrafts + 1);
+  for (guint i = 0; i < numAircrafts; i++)
+  {
+    guint start = fill.length;
+    ctx->departuresStart[i] = start;
+    if (ctx->flightCounts[i] == 0)
+      continue;
+
+    const Aircraft *a = g_ptr_array_index(ctx->aircrafts, i);
+    Bitmap *flights = bitmap_andnot(dataset_flight_bitmap(ds, FLIGHT_KEY_AIRCRAFT, getAircraftId(a)), cancelled);
+    bitmap_foreach(flights, collect_departure, &fill);
+    bitmap_free(flights);
+    qsort(ctx->departures + start, fill.length - start, sizeof(time_t), compare_time_pointers);
+  }
+  ctx->departuresStart[numAircrafts] = fill.length;
+}
+
+// Index of the first of @p n sorted times not before @p when
+static guint first_departure_from(const time_t *times, guint n, time_t when)
+{
+  guint lower = 0, upper = n;
+  while (lower < upper)
+  {
+    guint mid = lower + (upper - lower) / 2;
+    if (times[mid] < when)
+      lower = mid + 1;
+    else
+      upper = mid;
+  }
+  return lower;
+}
+
+// Flights of an aircraft that left between the days @p from and @p to, both included
+static int q2_count_between(const Q2Context *ctx, guint32 aircraft, time_t from, time_t to)
+{
+  const time_t *times = ctx->departures + ctx->departuresStart[aircraft];
+  guint n = ctx->departuresStart[aircraft + 1] - ctx->departuresStart[aircraft];
+  guint lo = first_departure_from(times, n, from);
+  guint hi = first_departure_from(times, n, to + 86400);
+  return hi > lo ? (int)(hi - lo) : 0;
+}
+
+// The second argument: an optional manufacturer, then optionally two dates ("2 10 Airbus 2023-01-01 2023-06-30")
+typedef struct
+{
+  const char *filter; // NULL for every manufacturer
+  gchar *ownedFilter; // Set when the filter had to be cut off the dates
+  gboolean windowed;
+  time_t from;
+  time_t to;
+} Q2Args;
+
+static void q2_parse_args(const char *arg2, Q2Args *args)
+{
+  args->filter = (arg2 && *arg2) ? arg2 : NULL;
+  args->ownedFilter = NULL;
+  args->windowed = FALSE;
+  if (!args->filter)
+    return;
+
+  // The last two tokens must be dates; whatever comes before them is the manufacturer
+  char dates[2][11];
+  const char *p = arg2 + strlen(arg2);
+  for (int k = 1; k >= 0; k--)
+  {
+    while (p > arg2 && g_ascii_isspace(p[-1]))
+      p--;
+    const char *tokenEnd = p;
+    while (p > arg2 && !g_ascii_isspace(p[-1]))
+      p--;
+    if (tokenEnd - p != 10)
+      return;
+    memcpy(dates[k], p, 10);
+    dates[k][10] = '\0';
+  }
+  if (!parse_date_argument(dates[0], &args->from) || !parse_date_argument(dates[1], &args->to))
+    return;
+
+  while (p > arg2 && g_ascii_isspace(p[-1]))
+    p--;
+  args->windowed = TRUE;
+  args->ownedFilter = p > arg2 ? g_strndup(arg2, (gsize)(p - arg2)) : NULL;
+  args->filter = args->ownedFilter;
+}
 
 static void *q2_init_wrapper(Dataset *ds)
 {
   if (!ds)
     return NULL;
   Q2Context *ctx = g_new0(Q2Context, 1);
-  ctx->aircrafts = g_ptr_array_new();
+  ctx->aircrafts = g_ptr_array_sized_new(dataset_get_aircraft_count(ds));
 
   DatasetIterator *it = dataset_aircraft_iterator_new(ds);
-  const Aircraft *ac;
-  while ((ac = dataset_iterator_next(it)) != NULL)
+  const Aircraft *acBatch[DATASET_BATCH_SIZE];
+  guint n;
+  while ((n = dataset_aircraft_iterator_next_batch(it, acBatch, DATASET_BATCH_SIZE)) > 0)
   {
-    g_ptr_array_add(ctx->aircrafts, (gpointer)ac);
+    for (guint b = 0; b < n; b++)
+      g_ptr_array_add(ctx->aircrafts, (gpointer)acBatch[b]);
   }
   dataset_iterator_free(it);
 
   int numAircrafts = ctx->aircrafts->len;
   ctx->flightCounts = calloc(numAircrafts, sizeof(int));
-  GHashTable *idToIndex = g_hash_table_new(g_str_hash, g_str_equal);
 
+  // Flights of the aircraft minus cancelled flights, counted on the bitmaps alone
+  const Bitmap *cancelled = dataset_flight_status_bitmap(ds, "Cancelled");
   for (int i = 0; i < numAircrafts; i++)
   {
     const Aircraft *a = g_ptr_array_index(ctx->aircrafts, i);
-    g_hash_table_insert(idToIndex, (gpointer)getAircraftId(a), GINT_TO_POINTER(i + 1));
+    const Bitmap *flights = dataset_flight_bitmap(ds, FLIGHT_KEY_AIRCRAFT, getAircraftId(a));
+    ctx->flightCounts[i] = (int)bitmap_andnot_cardinality(flights, cancelled);
+  }
+
+  q2_build_rankings(ctx);
+  q2_build_departures(ctx, ds, cancelled);
+  return ctx;
+}
+
+static void q2_write(OutputBuilder *b, const char *id, const char *manufacturer, const char *model, int count)
+{
+  output_builder_string(b, id);
+  output_builder_separator(b);
+  output_builder_string(b, manufacturer);
+  output_builder_separator(b);
+  output_builder_string(b, model);
+  output_builder_separator(b);
+  output_builder_int(b, count);
+  output_builder_char(b, '\n');
+}
+
+// Writes the ranking (or an empty line when there is none)
+static void q2_print(AircraftStats **top, int size, int isSpecial, FILE *output)
+{
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+
+  if (top && size > 0)
+  {
+    for (int i = 0; i < size; i++)
+      q2_write(&b, get_aircraftstats_id(top[i]), get_aircraftstats_manufacturer(top[i]),
+               get_aircraftstats_model(top[i]), get_aircraftstats_count(top[i]));
   }
+  else
+  {
+    output_builder_char(&b, '\n');
+  }
+  output_builder_flush(&b);
+}
 
-  it = dataset_flight_iterator_new(ds);
-  const Flight *f;
-  while ((f = dataset_iterator_next(it)) != NULL)
+// Top N by flights within the window, walking the all-time ranking: an aircraft's window count is at most
+// its all-time one, so once that drops below the last kept entry nothing further down can enter the list
+static void q2_run_window(const Q2Context *ctx, int N, const Q2Args *args, int isSpecial, FILE *output)
+{
+  guint length = 0;
+  const guint32 *ranked = q2_ranking(ctx, args->filter, &length);
+  guint capacity = N > 0 ? MIN((guint)N, length) : 0;
+  Q2Candidate *top = g_new(Q2Candidate, MAX(capacity, 1));
+  guint size = 0;
+
+  for (guint i = 0; i < length && capacity > 0; i++)
   {
-    if (strcmp(getFlightStatus(f), "Cancelled") == 0)
+    guint32 index = ranked[i];
+    if (size == capacity && ctx->flightCounts[index] < top[size - 1].count)
+      break;
+
+    int count = q2_count_between(ctx, index, args->from, args->to);
+    if (count == 0)
       continue;
-    const char *acId = getFlightAircraft(f);
-    if (!acId)
+
+    const Aircraft *ac = g_ptr_array_index(ctx->aircrafts, index);
+    Q2Candidate entry = {.index = index, .count = count, .id = getAircraftId(ac)};
+    if (size == capacity && compare_candidates(&entry, &top[size - 1]) >= 0)
       continue;
-    gpointer idxPtr = g_hash_table_lookup(idToIndex, acId);
-    if (idxPtr)
+
+    guint pos = size < capacity ? size++ : size - 1;
+    while (pos > 0 && compare_candidates(&entry, &top[pos - 1]) < 0)
     {
-      ctx->flightCounts[GPOINTER_TO_INT(idxPtr) - 1]++;
+      top[pos] = top[pos - 1];
+      pos--;
     }
+    top[pos] = entry;
   }
-  dataset_iterator_free(it);
-  g_hash_table_destroy(idToIndex);
-  return ctx;
+
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+  for (guint i = 0; i < size; i++)
+  {
+    const Aircraft *ac = g_ptr_array_index(ctx->aircrafts, top[i].index);
+    q2_write(&b, top[i].id, getAircraftManufacturer(ac), getAircraftModel(ac), top[i].count);
+  }
+  if (size == 0)
+    output_builder_char(&b, '\n');
+  output_builder_flush(&b);
+  g_free(top);
 }
 
 static void q2_run_wrapper(void *ctx_void, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
@@ -259,28 +547,112 @@ static void q2_run_wrapper(void *ctx_void, Dataset *ds, char *arg1, char *arg2,
   (void)ds;
 
   int N = atoi(arg1);
-  const char *filter = (arg2 && *arg2) ? arg2 : NULL;
-  int size = 0;
+  Q2Args args;
+  q2_parse_args(arg2, &args);
+  if (args.windowed)
+  {
+    q2_run_window(ctx, N, &args, isSpecial, output);
+    g_free(args.ownedFilter);
+    return;
+  }
 
-  AircraftStats **top = query2(N, ctx->aircrafts, filter, &size, ctx->flightCounts);
+  guint length = 0;
+  const guint32 *ranked = q2_ranking(ctx, args.filter, &length);
+  guint size = N > 0 ? MIN((guint)N, length) : 0;
 
-  if (top && size > 0)
+  // The answer is the first entries of the list: no candidates to filter, no allocations
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+  for (guint i = 0; i < size; i++)
   {
-    char sep = isSpecial ? '=' : ';';
-    for (int i = 0; i < size; i++)
-    {
-      fprintf(output, "%s%c%s%c%s%c%d\n",
-              get_aircraftstats_id(top[i]), sep,
-              get_aircraftstats_manufacturer(top[i]), sep,
-              get_aircraftstats_model(top[i]), sep,
-              get_aircraftstats_count(top[i]));
-    }
-    free_aircraftstats_array(top, size);
+    const Aircraft *ac = g_ptr_array_index(ctx->aircrafts, ranked[i]);
+    q2_write(&b, getAircraftId(ac), getAircraftManufacturer(ac), getAircraftModel(ac),
+             ctx->flightCounts[ranked[i]]);
   }
-  else
+  if (size == 0)
+    output_builder_char(&b, '\n');
+  output_builder_flush(&b);
+}
+
+// --- Sharded Execution ---
+
+// A shard sends the count of its own flights for every matching aircraft; the ranking is done on the sums
+static void q2_partial_wrapper(void *ctx_void, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+  Q2Context *ctx = (Q2Context *)ctx_void;
+  if (!ctx || !arg1 || atoi(arg1) <= 0)
+    return;
+  (void)ds;
+  (void)isSpecial;
+
+  Q2Args args;
+  q2_parse_args(arg2, &args);
+  guint length = 0;
+  const guint32 *ranked = q2_ranking(ctx, args.filter, &length);
+  for (guint i = 0; i < length; i++)
   {
-    fprintf(output, "\n");
+    int count = args.windowed ? q2_count_between(ctx, ranked[i], args.from, args.to) : ctx->flightCounts[ranked[i]];
+    if (count == 0)
+      continue;
+    const Aircraft *ac = g_ptr_array_index(ctx->aircrafts, ranked[i]);
+    fprintf(output, "%s\t%s\t%s\t%d\n", getAircraftId(ac), getAircraftManufacturer(ac), getAircraftModel(ac), count);
+  }
+  g_free(args.ownedFilter);
+}
+
+// Highest count first, then alphabetical ID (the order of query2())
+static gint compare_merged_stats(gconstpointer a, gconstpointer b)
+{
+  const AircraftStats *sa = *(AircraftStats *const *)a;
+  const AircraftStats *sb = *(AircraftStats *const *)b;
+  if (sa->count != sb->count)
+    return sa->count > sb->count ? -1 : 1;
+  return strcmp(sa->id, sb->id);
+}
+
+static void q2_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+  (void)arg2;
+  if (!arg1)
+    return;
+
+  int N = atoi(arg1);
+  GHashTable *byId = g_hash_table_new(g_str_hash, g_str_equal);
+  GPtrArray *merged = g_ptr_array_new();
+  for (int s = 0; s < count && N > 0; s++)
+  {
+    gchar **lines = g_strsplit(partials[s], "\n", -1);
+    for (int l = 0; lines[l]; l++)
+    {
+      gchar **fields = g_strsplit(lines[l], "\t", 4);
+      if (g_strv_length(fields) == 4)
+      {
+        AircraftStats *as = g_hash_table_lookup(byId, fields[0]);
+        if (!as)
+        {
+          as = g_new(AircraftStats, 1);
+          as->id = strdup(fields[0]);
+          as->manufacturer = strdup(fields[1]);
+          as->model = strdup(fields[2]);
+          as->count = 0;
+          g_hash_table_insert(byId, as->id, as);
+          g_ptr_array_add(merged, as);
+        }
+        as->count += atoi(fields[3]);
+      }
+      g_strfreev(fields);
+    }
+    g_strfreev(lines);
   }
+  g_hash_table_destroy(byId);
+
+  g_ptr_array_sort(merged, compare_merged_stats);
+  int size = (int)merged->len;
+  AircraftStats **all = (AircraftStats **)g_ptr_array_free(merged, FALSE);
+  q2_print(all, MIN(size, N), isSpecial, output);
+  free_aircraftstats_array(all, size);
 }
 
 static void q2_destroy_wrapper(void *ctx_void)
@@ -292,6 +664,12 @@ static void q2_destroy_wrapper(void *ctx_void)
       g_ptr_array_free(ctx->aircrafts, TRUE);
     if (ctx->flightCounts)
       free(ctx->flightCounts);
+    g_free(ctx->ranking);
+    g_free(ctx->rankingByManufacturer);
+    g_free(ctx->departures);
+    g_free(ctx->departuresStart);
+    if (ctx->manufacturers)
+      g_hash_table_destroy(ctx->manufacturers);
     g_free(ctx);
   }
 }
@@ -302,6 +680,8 @@ QueryModule get_query2_module(void)
       .id = 2,
       .init = q2_init_wrapper,
       .run = q2_run_wrapper,
-      .destroy = q2_destroy_wrapper};
+      .destroy = q2_destroy_wrapper,
+      .partial = q2_partial_wrapper,
+      .merge = q2_merge_wrapper};
   return mod;
 }
\ No newline at end of file
@@ -5,8 +5,10 @@
 #include <core/indexer.h>
 #include <core/time_utils.h>
 #include <entities/access/airports_access.h>
+#include <io/output_builder.h>
 #include <glib.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -30,8 +32,50 @@ static gchar *query3Aux(const gchar *code, const Dataset *ds)
   return g_strconcat(code, ";", name, ";", city, ";", country, NULL);
 }
 
-gchar *query3(GHashTable *airportFtrees, const Dataset *ds,
-              const char *startStr, const char *endStr)
+// Departures of one airport between two days, both included
+static int q3_count_in(FTree *tree, time_t start_date, time_t end_date)
+{
+  int n = getFtreeN(tree);
+  time_t *dates = getFtreeDates(tree);
+
+  int lower = 0, upper = n - 1, start = n + 1;
+  while (lower <= upper)
+  {
+    int mid = (lower + upper) / 2;
+    if (compare_time_t(dates[mid], start_date) >= 0)
+    {
+      start = mid + 1;
+      upper = mid - 1;
+    }
+    else
+    {
+      lower = mid + 1;
+    }
+  }
+
+  lower = 0;
+  upper = n - 1;
+  int end = 0;
+  while (lower <= upper)
+  {
+    int mid = (lower + upper) / 2;
+    if (compare_time_t(dates[mid], end_date) <= 0)
+    {
+      end = mid + 1;
+      lower = mid + 1;
+    }
+    else
+    {
+      upper = mid - 1;
+    }
+  }
+
+  return ftree_range_sum(tree, start, end);
+}
+
+// The airport with the most departures in the range (smallest code on ties), or NULL if none has any
+static const gchar *q3_find_best(GHashTable *airportFtrees, const char *startStr, const char *endStr,
+                                 int *count_out)
 {
   if (!airportFtrees || !startStr || !endStr)
     return NULL;
@@ -48,43 +92,7 @@ gchar *query3(GHashTable *airportFtrees, const Dataset *ds,
   while (g_hash_table_iter_next(&iter, &key, &val))
   {
     const gchar *code = (const gchar *)key;
-    FTree *tree = (FTree *)val;
-    int n = getFtreeN(tree);
-    time_t *dates = getFtreeDates(tree);
-
-    int lower = 0, upper = n - 1, start = n + 1;
-    while (lower <= upper)
-    {
-      int mid = (lower + upper) / 2;
-      if (compare_time_t(dates[mid], start_date) >= 0)
-      {
-        start = mid + 1;
-        upper = mid - 1;
-      }
-      else
-      {
-        lower = mid + 1;
-      }
-    }
-
-    lower = 0;
-    upper = n - 1;
-    int end = 0;
-    while (lower <= upper)
-    {
-      int mid = (lower + upper) / 2;
-      if (compare_time_t(dates[mid], end_date) <= 0)
-      {
-        end = mid + 1;
-        lower = mid + 1;
-      }
-      else
-      {
-        upper = mid - 1;
-      }
-    }
-
-    int count = ftree_range_sum(tree, start, end);
+    int count = q3_count_in((FTree *)val, start_date, end_date);
 
     if (count > bestCount ||
         (count == bestCount &&
@@ -98,6 +106,18 @@ gchar *query3(GHashTable *airportFtrees, const Dataset *ds,
   if (bestCount == 0 || !bestAirport)
     return NULL;
 
+  *count_out = bestCount;
+  return bestAirport;
+}
+
+gchar *query3(GHashTable *airportFtrees, const Dataset *ds,
+              const char *startStr, const char *endStr)
+{
+  int bestCount = 0;
+  const gchar *bestAirport = q3_find_best(airportFtrees, startStr, endStr, &bestCount);
+  if (!bestAirport)
+    return NULL;
+
   gchar *airportName = query3Aux(bestAirport, ds);
   gchar *result = g_strdup_printf("%s;%d", airportName, bestCount);
   g_free(airportName);
@@ -105,52 +125,419 @@ gchar *query3(GHashTable *airportFtrees, const Dataset *ds,
   return result;
 }
 
-static void *q3_init_wrapper(Dataset *ds)
+// --- Range Backends ---
+
+// Dense backend: departures before every day, per airport, while days x airports stays below this (64MB)
+#define Q3_DENSE_MAX_CELLS (16u << 20)
+
+// Sparse backend: the days are split into blocks, and the busiest airport of every run of whole blocks is stored.
+// The number of blocks is bounded by the size of that table and by the work of building it.
+#define Q3_MAX_BLOCKS 512
+#define Q3_BUILD_BUDGET (32u << 20) // Events visited while building the table
+
+typedef struct
 {
-  if (!ds)
-    return NULL;
+  guint32 airport;
+  gint32 count;
+} Q3Event;
 
-  GHashTable *dates = create_date_index(ds);
+typedef struct
+{
+  gint32 airport; // -1 if no airport has departures
+  gint32 count;
+} Q3Leader;
 
-  GHashTable *ftrees = getFTrees(dates, ds);
+typedef struct
+{
+  GHashTable *ftrees;  // Code -> FTree, as built by getFTrees()
+  guint nAirports;
+  const gchar **codes; // Airports in code order, so the tie-break is the smallest index
+  FTree **trees;       // Tree of codes[i]
+  guint nDays;
+  time_t *days;        // Every day with departures from some airport, ascending
+  guint *dayStart;     // Day d owns events[dayStart[d] .. dayStart[d + 1])
+  Q3Event *events;     // The airports with departures on each day, and how many
+  guint blockSize;     // Days per block
+  guint nBlocks;
+  gint32 *prefix;      // Dense: row d holds the departures of each airport before days[d] (nDays + 1 rows)
+  Q3Leader *leaders;   // Sparse: leader of the days of blocks i..j: leaders[i * nBlocks + j], j >= i
+} Q3Context;
 
-  g_hash_table_destroy(dates);
+// A departure count of the trees, with its day
+typedef struct
+{
+  time_t day;
+  Q3Event event;
+} Q3DatedEvent;
 
-  return ftrees;
+static int compare_codes(const void *a, const void *b)
+{
+  return strcmp(*(const gchar *const *)a, *(const gchar *const *)b);
 }
 
-static void q3_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+static int compare_dated_events(const void *a, const void *b)
+{
+  const Q3DatedEvent *ea = a;
+  const Q3DatedEvent *eb = b;
+  if (ea->day != eb->day)
+    return ea->day < eb->day ? -1 : 1;
+  return (ea->event.airport > eb->event.airport) - (ea->event.airport < eb->event.airport);
+}
+
+// Lays the counts of every tree out by day, so the whole network can be swept in time order
+static void q3_build_days(Q3Context *ctx)
+{
+  GArray *dated = g_array_new(FALSE, FALSE, sizeof(Q3DatedEvent));
+  for (guint a = 0; a < ctx->nAirports; a++)
+  {
+    FTree *tree = ctx->trees[a];
+    time_t *dates = getFtreeDates(tree);
+    for (int k = 1; k <= getFtreeN(tree); k++)
+    {
+      // Read back from the tree, so the counts are exactly the ones q3_count_in() sums
+      int count = ftree_range_sum(tree, k, k);
+      if (count <= 0)
+        continue;
+      Q3DatedEvent e = {.day = dates[k - 1], .event = {.airport = a, .count = count}};
+      g_array_append_val(dated, e);
+    }
+  }
+  g_array_sort(dated, (GCompareFunc)compare_dated_events);
+
+  const Q3DatedEvent *all = (const Q3DatedEvent *)dated->data;
+  ctx->events = g_new(Q3Event, MAX(dated->len, 1));
+  ctx->days = g_new(time_t, MAX(dated->len, 1));
+  ctx->dayStart = g_new(guint, dated->len + 1);
+  for (guint i = 0; i < dated->len; i++)
+  {
+    if (ctx->nDays == 0 || ctx->days[ctx->nDays - 1] != all[i].day)
+    {
+      ctx->days[ctx->nDays] = all[i].day;
+      ctx->dayStart[ctx->nDays] = i;
+      ctx->nDays++;
+    }
+    ctx->events[i] = all[i].event;
+  }
+  ctx->dayStart[ctx->nDays] = dated->len;
+  g_array_free(dated, TRUE);
+}
+
+// One contiguous row per day, a column per airport: a range is the difference of two rows
+static gboolean q3_build_dense(Q3Context *ctx)
 {
-  GHashTable *ftrees = (GHashTable *)ctx;
+  guint nAirports = ctx->nAirports;
+  gsize cells = ((gsize)ctx->nDays + 1) * nAirports;
+  if (nAirports == 0 || cells > Q3_DENSE_MAX_CELLS)
+    return FALSE;
 
-  gchar *res = query3(ftrees, ds, arg1, arg2);
+  ctx->prefix = g_new(gint32, cells);
+  memset(ctx->prefix, 0, sizeof(gint32) * nAirports);
+  for (guint d = 0; d < ctx->nDays; d++)
+  {
+    gint32 *row = ctx->prefix + (gsize)(d + 1) * nAirports;
+    memcpy(row, row - nAirports, sizeof(gint32) * nAirports);
+    for (guint i = ctx->dayStart[d]; i < ctx->dayStart[d + 1]; i++)
+      row[ctx->events[i].airport] += ctx->events[i].count;
+  }
 
-  if (res)
+  // Only the rows are needed from now on
+  g_free(ctx->events);
+  g_free(ctx->dayStart);
+  ctx->events = NULL;
+  ctx->dayStart = NULL;
+  return TRUE;
+}
+
+// The airport with the most departures between two rows, the first one on ties, or -1 if none has any.
+// The maximum is a branch-free reduction over contiguous columns, which the compiler vectorizes.
+static gint32 q3_dense_argmax(const gint32 *restrict before, const gint32 *restrict after, guint n, int *count)
+{
+  gint32 best = 0;
+  for (guint a = 0; a < n; a++)
+  {
+    gint32 c = after[a] - before[a];
+    best = c > best ? c : best;
+  }
+  if (best == 0)
+    return -1;
+
+  for (guint a = 0; a < n; a++)
+  {
+    if (after[a] - before[a] == best)
+    {
+      *count = best;
+      return (gint32)a;
+    }
+  }
+  return -1;
+}
+
+// For every first block, sweeps the following ones: counts only grow, so the leader is kept up to date as they do
+static void q3_build_leaders(Q3Context *ctx)
+{
+  guint nEvents = ctx->dayStart[ctx->nDays];
+  guint byBudget = MAX(Q3_BUILD_BUDGET / MAX(nEvents, 1), 1);
+  guint blocks = MIN(MIN((guint)Q3_MAX_BLOCKS, byBudget), ctx->nDays);
+  if (blocks == 0)
+    return;
+  ctx->blockSize = (ctx->nDays + blocks - 1) / blocks;
+  ctx->nBlocks = (ctx->nDays + ctx->blockSize - 1) / ctx->blockSize;
+  ctx->leaders = g_new(Q3Leader, (gsize)ctx->nBlocks * ctx->nBlocks);
+
+  gint32 *counts = g_new(gint32, MAX(ctx->nAirports, 1));
+  for (guint first = 0; first < ctx->nBlocks; first++)
   {
-    if (isSpecial)
+    memset(counts, 0, sizeof(gint32) * ctx->nAirports);
+    Q3Leader leader = {.airport = -1, .count = 0};
+    for (guint last = first; last < ctx->nBlocks; last++)
     {
-      for (char *p = res; *p; p++)
+      guint dayEnd = MIN((last + 1) * ctx->blockSize, ctx->nDays);
+      for (guint i = ctx->dayStart[last * ctx->blockSize]; i < ctx->dayStart[dayEnd]; i++)
       {
-        if (*p == ';')
-          *p = '=';
+        const Q3Event *e = &ctx->events[i];
+        gint32 count = counts[e->airport] += e->count;
+        if (count > leader.count || (count == leader.count && (gint32)e->airport < leader.airport))
+        {
+          leader.airport = (gint32)e->airport;
+          leader.count = count;
+        }
       }
+      ctx->leaders[first * ctx->nBlocks + last] = leader;
     }
-    fprintf(output, "%s\n", res);
-    g_free(res);
+  }
+  g_free(counts);
+}
+
+static void q3_context_free(Q3Context *ctx)
+{
+  if (!ctx)
+    return;
+  if (ctx->ftrees)
+    g_hash_table_destroy(ctx->ftrees);
+  g_free(ctx->codes);
+  g_free(ctx->trees);
+  g_free(ctx->days);
+  g_free(ctx->dayStart);
+  g_free(ctx->events);
+  g_free(ctx->prefix);
+  g_free(ctx->leaders);
+  g_free(ctx);
+}
+
+// Index of the first day not before @p when (nDays if there is none)
+static guint q3_first_day_from(const Q3Context *ctx, time_t when)
+{
+  guint lower = 0, upper = ctx->nDays;
+  while (lower < upper)
+  {
+    guint mid = lower + (upper - lower) / 2;
+    if (ctx->days[mid] < when)
+      lower = mid + 1;
+    else
+      upper = mid;
+  }
+  return lower;
+}
+
+// Counts the departures of a candidate in the whole range and keeps it if it beats the current best
+static void q3_consider(const Q3Context *ctx, gint32 airport, time_t start_date, time_t end_date, gint32 *best,
+                        int *bestCount)
+{
+  if (airport < 0 || airport == *best)
+    return;
+  int count = q3_count_in(ctx->trees[airport], start_date, end_date);
+  if (count > *bestCount || (count == *bestCount && count > 0 && airport < *best))
+  {
+    *best = airport;
+    *bestCount = count;
+  }
+}
+
+static void q3_consider_days(const Q3Context *ctx, guint from, guint to, time_t start_date, time_t end_date,
+                             gint32 *best, int *bestCount)
+{
+  if (from >= to)
+    return;
+  for (guint i = ctx->dayStart[from]; i < ctx->dayStart[to]; i++)
+    q3_consider(ctx, (gint32)ctx->events[i].airport, start_date, end_date, best, bestCount);
+}
+
+// Same answer as q3_find_best(). Dense: the difference of two rows. Sparse: the leader of the whole blocks inside
+// the range and the airports that have departures on the days left over at its ends; any other airport only has
+// departures inside those blocks, so it has no more of them than the leader, and a larger code on a tie
+static const gchar *q3_find_best_indexed(const Q3Context *ctx, const char *startStr, const char *endStr,
+                                         int *count_out)
+{
+  if (!ctx || !startStr || !endStr || ctx->nDays == 0)
+    return NULL;
+
+  time_t start_date = parse_unix_date(startStr, NULL);
+  time_t end_date = parse_unix_date(endStr, NULL);
+
+  // Days lo .. hi - 1 are within the range
+  guint lo = q3_first_day_from(ctx, start_date);
+  guint hi = end_date < G_MAXINT64 ? q3_first_day_from(ctx, end_date + 1) : ctx->nDays;
+  if (lo >= hi)
+    return NULL;
+
+  gint32 best = -1;
+  int bestCount = 0;
+  if (ctx->prefix)
+  {
+    best = q3_dense_argmax(ctx->prefix + (gsize)lo * ctx->nAirports, ctx->prefix + (gsize)hi * ctx->nAirports,
+                           ctx->nAirports, &bestCount);
+    if (best < 0)
+      return NULL;
+    *count_out = bestCount;
+    return ctx->codes[best];
+  }
+
+  guint firstBlock = (lo + ctx->blockSize - 1) / ctx->blockSize;
+  guint endBlock = hi / ctx->blockSize;
+  if (firstBlock < endBlock)
+  {
+    q3_consider(ctx, ctx->leaders[firstBlock * ctx->nBlocks + endBlock - 1].airport, start_date, end_date, &best,
+                &bestCount);
+    q3_consider_days(ctx, lo, firstBlock * ctx->blockSize, start_date, end_date, &best, &bestCount);
+    q3_consider_days(ctx, endBlock * ctx->blockSize, hi, start_date, end_date, &best, &bestCount);
   }
   else
   {
-    fprintf(output, "\n");
+    q3_consider_days(ctx, lo, hi, start_date, end_date, &best, &bestCount);
   }
+
+  if (best < 0 || bestCount == 0)
+    return NULL;
+  *count_out = bestCount;
+  return ctx->codes[best];
 }
 
-static void q3_destroy_wrapper(void *ctx)
+static void *q3_init_wrapper(Dataset *ds)
 {
-  if (ctx)
+  if (!ds)
+    return NULL;
+
+  GHashTable *dates = create_date_index(ds);
+
+  Q3Context *ctx = g_new0(Q3Context, 1);
+  ctx->ftrees = getFTrees(dates, ds);
+
+  g_hash_table_destroy(dates);
+
+  ctx->nAirports = g_hash_table_size(ctx->ftrees);
+  ctx->codes = (const gchar **)g_hash_table_get_keys_as_array(ctx->ftrees, NULL);
+  qsort(ctx->codes, ctx->nAirports, sizeof(gchar *), compare_codes);
+  ctx->trees = g_new(FTree *, MAX(ctx->nAirports, 1));
+  for (guint a = 0; a < ctx->nAirports; a++)
+    ctx->trees[a] = g_hash_table_lookup(ctx->ftrees, ctx->codes[a]);
+
+  q3_build_days(ctx);
+  // The day axis only has the days with departures, so the dense matrix is the norm; a huge one falls back
+  if (!q3_build_dense(ctx))
+    q3_build_leaders(ctx);
+  return ctx;
+}
+
+// Writes a result line given with ';' separators (or an empty line), with the separators of the variant
+static void q3_print(const gchar *res, int isSpecial, FILE *output)
+{
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+  for (const char *p = res; p && *p; p++)
+  {
+    if (*p == ';')
+      output_builder_separator(&b);
+    else
+      output_builder_char(&b, *p);
+  }
+  output_builder_char(&b, '\n');
+  output_builder_flush(&b);
+}
+
+static void q3_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+  char buffer[OUTPUT_BUILDER_SIZE];
+  OutputBuilder b;
+  output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+
+  int bestCount = 0;
+  const gchar *code = q3_find_best_indexed((const Q3Context *)ctx, arg1, arg2, &bestCount);
+  const Airport *airport = code && ds ? dataset_get_airport(ds, code) : NULL;
+  if (airport)
+  {
+    // Same fields as query3()
+    output_builder_string(&b, code);
+    output_builder_separator(&b);
+    output_builder_string(&b, getAirportName(airport));
+    output_builder_separator(&b);
+    output_builder_string(&b, getAirportCity(airport));
+    output_builder_separator(&b);
+    output_builder_string(&b, getAirportCountry(airport));
+    output_builder_separator(&b);
+    output_builder_int(&b, bestCount);
+  }
+  output_builder_char(&b, '\n');
+  output_builder_flush(&b);
+}
+
+// --- Sharded Execution ---
+
+// Departures are counted at their origin, which a single shard owns: each shard sends its best airport
+static void q3_partial_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+  (void)isSpecial;
+
+  int bestCount = 0;
+  const gchar *code = q3_find_best_indexed((const Q3Context *)ctx, arg1, arg2, &bestCount);
+  gchar *res = code ? query3Aux(code, ds) : NULL;
+  if (res)
+    fprintf(output, "%s;%d\n", res, bestCount);
+  g_free(res);
+}
+
+// Compares the airport codes that start two result lines, as strcmp() would compare the codes alone
+static int compare_line_codes(const char *a, const char *b)
+{
+  size_t lenA = strcspn(a, ";");
+  size_t lenB = strcspn(b, ";");
+  int cmp = strncmp(a, b, MIN(lenA, lenB));
+  if (cmp != 0)
+    return cmp;
+  return (lenA > lenB) - (lenA < lenB);
+}
+
+static void q3_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+  (void)arg1;
+  (void)arg2;
+
+  char *best = NULL;
+  int bestCount = 0;
+  for (int s = 0; s < count; s++)
   {
+    char *line = partials[s];
+    line[strcspn(line, "\n")] = '\0';
+    char *countSep = strrchr(line, ';');
+    if (!countSep)
+      continue;
 
-    g_hash_table_destroy((GHashTable *)ctx);
+    // Same tie-break as query3(): the smallest code
+    int lineCount = atoi(countSep + 1);
+    if (lineCount > bestCount || (lineCount == bestCount && best && compare_line_codes(line, best) < 0))
+    {
+      best = line;
+      bestCount = lineCount;
+    }
   }
+
+  q3_print(best, isSpecial, output);
+}
+
+static void q3_destroy_wrapper(void *ctx)
+{
+  q3_context_free((Q3Context *)ctx);
 }
 
 QueryModule get_query3_module(void)
@@ -159,6 +546,8 @@ QueryModule get_query3_module(void)
       .id = 3,
       .init = q3_init_wrapper,
       .run = q3_run_wrapper,
-      .destroy = q3_destroy_wrapper};
+      .destroy = q3_destroy_wrapper,
+      .partial = q3_partial_wrapper,
+      .merge = q3_merge_wrapper};
   return mod;
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <entities/access/flights_access.h>
 #include <entities/access/passengers_access.h>
 #include <core/dataset.h>
+#include <core/dataset_parallel.h>
+#include <io/output_builder.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -50,59 +52,98 @@ static gint compare_spends(gconstpointer a, gconstpointer b)
 
 static void free_weekly_top(gpointer data) { g_free(data); }
 
-Q4Struct *init_Q4_structure(const Dataset *ds)
+// Per-reservation week of the first flight, -1 when the reservation does not count
+typedef struct
 {
-    Q4Struct *q4 = g_new0(Q4Struct, 1);
-    q4->weekly_tops = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_weekly_top);
-    q4->min_week = 2147483647;
-    q4->max_week = -2147483648;
+    const Dataset *ds;
+    int *weeks;
+} Q4WeekJob;
+
+// First flights resolved per batch lookup
+#define Q4_LOOKUP_BATCH 256
 
-    GHashTable *temp_week_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_hash_table_destroy);
+static void resolve_weeks_body(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data)
+{
+    Q4WeekJob *job = user_data;
+    (void)local;
 
-    DatasetIterator *it = dataset_reservation_iterator_new(ds);
-    const Reservation *res;
+    const char *ids[Q4_LOOKUP_BATCH];
+    const Flight *flights[Q4_LOOKUP_BATCH];
 
-    while ((res = (const Reservation *)dataset_iterator_next(it)) != NULL)
+    for (guint base = 0; base < count; base += Q4_LOOKUP_BATCH)
     {
-        gchar **flight_ids = getReservationFlightIds(res);
-        if (!flight_ids || !flight_ids[0])
-            continue;
+        guint n = MIN(Q4_LOOKUP_BATCH, count - base);
+        for (guint i = 0; i < n; i++)
+        {
+            gchar **flight_ids = getReservationFlightIds(rows[base + i]);
+            ids[i] = flight_ids ? flight_ids[0] : NULL;
+        }
+        dataset_get_flights_batch(job->ds, ids, n, flights);
 
-        const Flight *f = dataset_get_flight(ds, flight_ids[0]);
-        if (!f)
-            continue;
+        for (guint i = 0; i < n; i++)
+        {
+            int week_idx = -1;
+            time_t departure = flights[i] ? getFlightDeparture(flights[i]) : 0;
+            if (departure > 0)
+                week_idx = get_week_index(departure);
+            job->weeks[start + base + i] = week_idx;
+        }
+    }
+}
 
-        time_t departure = getFlightDeparture(f);
-        if (departure <= 0)
-            continue;
+// Week of the first flight of every reservation, in row order (-1 when the reservation does not count)
+static int *resolve_weeks(const Dataset *ds, guint *count)
+{
+    *count = 0;
+    dataset_reservation_rows(ds, count);
+    Q4WeekJob job = {.ds = ds, .weeks = g_new(int, *count > 0 ? *count : 1)};
+    DatasetParallelOps ops = {.body = resolve_weeks_body};
+    dataset_parallel_foreach_reservation(ds, &ops, &job);
+    return job.weeks;
+}
 
-        int week_idx = get_week_index(departure);
-        int doc_no = getReservationDocumentNo(res);
-        double price = getReservationPrice(res);
+static Q4Struct *new_Q4_structure(void)
+{
+    Q4Struct *q4 = g_new0(Q4Struct, 1);
+    q4->weekly_tops = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_weekly_top);
+    q4->min_week = 2147483647;
+    q4->max_week = -2147483648;
+    return q4;
+}
+
+static GHashTable *new_week_map(void)
+{
+    return g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_hash_table_destroy);
+}
 
-        if (week_idx < q4->min_week)
-            q4->min_week = week_idx;
-        if (week_idx > q4->max_week)
-            q4->max_week = week_idx;
+// Adds a reservation's price to its passenger's spending of the week
+static void add_spend(Q4Struct *q4, GHashTable *temp_week_map, int week_idx, int doc_no, double price)
+{
+    if (week_idx < q4->min_week)
+        q4->min_week = week_idx;
+    if (week_idx > q4->max_week)
+        q4->max_week = week_idx;
 
-        GHashTable *pax_map = g_hash_table_lookup(temp_week_map, GINT_TO_POINTER(week_idx));
-        if (!pax_map)
-        {
-            pax_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
-            g_hash_table_insert(temp_week_map, GINT_TO_POINTER(week_idx), pax_map);
-        }
+    GHashTable *pax_map = g_hash_table_lookup(temp_week_map, GINT_TO_POINTER(week_idx));
+    if (!pax_map)
+    {
+        pax_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        g_hash_table_insert(temp_week_map, GINT_TO_POINTER(week_idx), pax_map);
+    }
 
-        double *current_spend = g_hash_table_lookup(pax_map, GINT_TO_POINTER(doc_no));
-        if (!current_spend)
-        {
-            current_spend = g_new(double, 1);
-            *current_spend = 0.0;
-            g_hash_table_insert(pax_map, GINT_TO_POINTER(doc_no), current_spend);
-        }
-        *current_spend += price;
+    double *current_spend = g_hash_table_lookup(pax_map, GINT_TO_POINTER(doc_no));
+    if (!current_spend)
+    {
+        current_spend = g_new(double, 1);
+        *current_spend = 0.0;
+        g_hash_table_insert(pax_map, GINT_TO_POINTER(doc_no), current_spend);
     }
-    dataset_iterator_free(it);
+    *current_spend += price;
+}
 
+// Keeps the 10 biggest spenders of every week
+static void rank_weeks(Q4Struct *q4, GHashTable *temp_week_map)
+{
     GHashTableIter week_iter;
     gpointer week_key, week_val;
     g_hash_table_iter_init(&week_iter, temp_week_map);
@@ -132,6 +173,28 @@ Q4Struct *init_Q4_structure(const Dataset *ds)
         g_hash_table_insert(q4->weekly_tops, GINT_TO_POINTER(week_idx), wt);
         g_array_free(arr, TRUE);
     }
+}
+
+Q4Struct *init_Q4_structure(const Dataset *ds)
+{
+    Q4Struct *q4 = new_Q4_structure();
+    GHashTable *temp_week_map = new_week_map();
+
+    // Resolving each reservation's week (flight lookup) is the expensive part and runs in
+    // parallel; the spending fold stays sequential so the floating-point sums keep their order
+    guint resCount = 0;
+    const Reservation *const *rows = dataset_reservation_rows(ds, &resCount);
+    int *weeks = resolve_weeks(ds, &resCount);
+
+    for (guint i = 0; i < resCount; i++)
+    {
+        if (weeks[i] < 0)
+            continue;
+        add_spend(q4, temp_week_map, weeks[i], getReservationDocumentNo(rows[i]), getReservationPrice(rows[i]));
+    }
+    g_free(weeks);
+
+    rank_weeks(q4, temp_week_map);
     g_hash_table_destroy(temp_week_map);
     return q4;
 }
@@ -145,16 +208,9 @@ void destroy_Q4_structure(Q4Struct *q4)
     }
 }
 
-void query4(Q4Struct *q4_data, const Dataset *ds,
-            const char *date_begin, const char *date_end,
-            FILE *output, int isSpecial)
+// Counts, per passenger, the weeks of [date_begin, date_end] that have them in their top 10
+static GHashTable *count_top_weeks(const Q4Struct *q4_data, const char *date_begin, const char *date_end)
 {
-    if (!q4_data)
-    {
-        fprintf(output, "\n");
-        return;
-    }
-
     int start_w, end_w;
     if (date_begin && strlen(date_begin) > 0)
     {
@@ -191,6 +247,29 @@ void query4(Q4Struct *q4_data, const Dataset *ds,
             }
         }
     }
+    return freq_map;
+}
+
+static void format_dob(const Passenger *p, char dob_str[12])
+{
+    time_t dob_t = getPassengerDateOfBirth(p);
+    struct tm info;
+    dob_str[0] = '\0';
+    if (gmtime_r(&dob_t, &info))
+        strftime(dob_str, 12, "%Y-%m-%d", &info);
+}
+
+void query4(Q4Struct *q4_data, const Dataset *ds,
+            const char *date_begin, const char *date_end,
+            FILE *output, int isSpecial)
+{
+    if (!q4_data)
+    {
+        fprintf(output, "\n");
+        return;
+    }
+
+    GHashTable *freq_map = count_top_weeks(q4_data, date_begin, date_end);
 
     int winner_doc = -1;
     int max_freq = -1;
@@ -214,35 +293,220 @@ void query4(Q4Struct *q4_data, const Dataset *ds,
     }
     g_hash_table_destroy(freq_map);
 
-    if (winner_doc != -1)
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+
+    const Passenger *p = winner_doc != -1 ? dataset_get_passenger(ds, winner_doc) : NULL;
+    if (p)
     {
-        const Passenger *p = dataset_get_passenger(ds, winner_doc);
+        output_builder_int_padded(&b, getPassengerDocumentNumber(p), 9);
+        output_builder_separator(&b);
+        output_builder_string(&b, getPassengerFirstName(p));
+        output_builder_separator(&b);
+        output_builder_string(&b, getPassengerLastName(p));
+        output_builder_separator(&b);
+        // The date of birth as "%Y-%m-%d"
+        time_t dob_t = getPassengerDateOfBirth(p);
+        struct tm info;
+        if (gmtime_r(&dob_t, &info))
+        {
+            output_builder_int(&b, info.tm_year + 1900);
+            output_builder_char(&b, '-');
+            output_builder_int_padded(&b, info.tm_mon + 1, 2);
+            output_builder_char(&b, '-');
+            output_builder_int_padded(&b, info.tm_mday, 2);
+        }
+        output_builder_separator(&b);
+        output_builder_string(&b, getPassengerNationality(p));
+        output_builder_separator(&b);
+        output_builder_int(&b, max_freq);
+    }
+    output_builder_char(&b, '\n');
+    output_builder_flush(&b);
+}
+
+// --- Sharded Execution ---
+
+// Weeks are dealt round-robin to the shards. The coordinator resolves the weeks and
+// sends every shard the spendings of its weeks, in reservation row order, so that
+// each weekly ranking is computed from the same sums as on the whole dataset.
+typedef struct
+{
+    gint32 min_week;
+    gint32 max_week;
+} Q4PayloadHeader;
+
+typedef struct
+{
+    gint32 week;
+    gint32 doc_no;
+    gdouble price;
+} Q4PayloadSpend;
+
+static void q4_shard_export(const Dataset *ds, GBytes **payloads, guint nShards)
+{
+    guint resCount = 0;
+    const Reservation *const *rows = dataset_reservation_rows(ds, &resCount);
+    int *weeks = resolve_weeks(ds, &resCount);
+
+    Q4PayloadHeader header = {.min_week = 2147483647, .max_week = -2147483648};
+    GByteArray **bytes = g_new(GByteArray *, nShards);
+    for (guint s = 0; s < nShards; s++)
+        bytes[s] = g_byte_array_new();
+
+    for (guint i = 0; i < resCount; i++)
+    {
+        if (weeks[i] < 0)
+            continue;
+        if (weeks[i] < header.min_week)
+            header.min_week = weeks[i];
+        if (weeks[i] > header.max_week)
+            header.max_week = weeks[i];
+
+        Q4PayloadSpend spend = {.week = weeks[i],
+                                .doc_no = getReservationDocumentNo(rows[i]),
+                                .price = getReservationPrice(rows[i])};
+        g_byte_array_append(bytes[(guint)weeks[i] % nShards], (const guint8 *)&spend, sizeof(spend));
+    }
+    g_free(weeks);
+
+    for (guint s = 0; s < nShards; s++)
+    {
+        // The bounds of the whole dataset, for open-ended date ranges
+        gsize size = sizeof(header) + bytes[s]->len;
+        guint8 *data = g_malloc(size);
+        memcpy(data, &header, sizeof(header));
+        memcpy(data + sizeof(header), bytes[s]->data, bytes[s]->len);
+        payloads[s] = g_bytes_new_take(data, size);
+        g_byte_array_free(bytes[s], TRUE);
+    }
+    g_free(bytes);
+}
+
+static void *q4_shard_init(Dataset *ds, GBytes *payload)
+{
+    (void)ds;
+    gsize size = 0;
+    const guint8 *data = payload ? g_bytes_get_data(payload, &size) : NULL;
+    if (!data || size < sizeof(Q4PayloadHeader))
+        return NULL;
+
+    Q4Struct *q4 = new_Q4_structure();
+    GHashTable *temp_week_map = new_week_map();
+
+    gsize count = (size - sizeof(Q4PayloadHeader)) / sizeof(Q4PayloadSpend);
+    for (gsize i = 0; i < count; i++)
+    {
+        Q4PayloadSpend spend;
+        memcpy(&spend, data + sizeof(Q4PayloadHeader) + i * sizeof(spend), sizeof(spend));
+        add_spend(q4, temp_week_map, spend.week, spend.doc_no, spend.price);
+    }
+    rank_weeks(q4, temp_week_map);
+    g_hash_table_destroy(temp_week_map);
+
+    Q4PayloadHeader header;
+    memcpy(&header, data, sizeof(header));
+    q4->min_week = header.min_week;
+    q4->max_week = header.max_week;
+    return q4;
+}
+
+// Sends the week count of every ranked passenger, with their details since any of them may win
+static void q4_partial_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+    Q4Struct *data = (Q4Struct *)ctx;
+    (void)isSpecial;
+    if (!data)
+        return;
+
+    GHashTable *freq_map = count_top_weeks(data, arg1, arg2);
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, freq_map);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        const Passenger *p = dataset_get_passenger(ds, GPOINTER_TO_INT(key));
+        fprintf(output, "%d\t%d", GPOINTER_TO_INT(key), GPOINTER_TO_INT(value));
         if (p)
         {
-            char separator = isSpecial ? '=' : ';';
-            time_t dob_t = getPassengerDateOfBirth(p);
-            char dob_str[12] = "";
-            struct tm info;
-            if (gmtime_r(&dob_t, &info))
-                strftime(dob_str, sizeof(dob_str), "%Y-%m-%d", &info);
-
-            fprintf(output, "%09d%c%s%c%s%c%s%c%s%c%d\n",
-                    getPassengerDocumentNumber(p), separator,
-                    getPassengerFirstName(p), separator,
-                    getPassengerLastName(p), separator,
-                    dob_str, separator,
-                    getPassengerNationality(p), separator,
-                    max_freq);
+            char dob_str[12];
+            format_dob(p, dob_str);
+            fprintf(output, "\t%s\t%s\t%s\t%s", getPassengerFirstName(p), getPassengerLastName(p), dob_str,
+                    getPassengerNationality(p));
         }
-        else
+        fprintf(output, "\n");
+    }
+    g_hash_table_destroy(freq_map);
+}
+
+static void q4_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+    (void)arg1;
+    (void)arg2;
+
+    // doc -> fields of its first line (frequencies are summed into the second field)
+    GHashTable *byDoc = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_strfreev);
+    GHashTable *freqs = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (int s = 0; s < count; s++)
+    {
+        gchar **lines = g_strsplit(partials[s], "\n", -1);
+        for (int l = 0; lines[l]; l++)
         {
-            fprintf(output, "\n");
+            gchar **fields = g_strsplit(lines[l], "\t", 6);
+            if (g_strv_length(fields) < 2)
+            {
+                g_strfreev(fields);
+                continue;
+            }
+            gpointer doc = GINT_TO_POINTER(atoi(fields[0]));
+            int freq = GPOINTER_TO_INT(g_hash_table_lookup(freqs, doc)) + atoi(fields[1]);
+            g_hash_table_insert(freqs, doc, GINT_TO_POINTER(freq));
+            if (!g_hash_table_lookup(byDoc, doc))
+                g_hash_table_insert(byDoc, doc, fields);
+            else
+                g_strfreev(fields);
         }
+        g_strfreev(lines);
     }
-    else
+
+    int winner_doc = -1;
+    int max_freq = -1;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, freqs);
+    while (g_hash_table_iter_next(&iter, &key, &value))
     {
-        fprintf(output, "\n");
+        int doc = GPOINTER_TO_INT(key);
+        int freq = GPOINTER_TO_INT(value);
+        if (freq > max_freq || (freq == max_freq && doc < winner_doc))
+        {
+            max_freq = freq;
+            winner_doc = doc;
+        }
     }
+
+    gchar **winner = winner_doc != -1 ? g_hash_table_lookup(byDoc, GINT_TO_POINTER(winner_doc)) : NULL;
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+    if (winner && g_strv_length(winner) == 6)
+    {
+        output_builder_int_padded(&b, winner_doc, 9);
+        for (int f = 2; f < 6; f++)
+        {
+            output_builder_separator(&b);
+            output_builder_string(&b, winner[f]);
+        }
+        output_builder_separator(&b);
+        output_builder_int(&b, max_freq);
+    }
+    output_builder_char(&b, '\n');
+    output_builder_flush(&b);
+
+    g_hash_table_destroy(freqs);
+    g_hash_table_destroy(byDoc);
 }
 
 static void *q4_init_wrapper(Dataset *ds)
@@ -268,6 +532,10 @@ QueryModule get_query4_module(void)
         .id = 4,
         .init = q4_init_wrapper,
         .run = q4_run_wrapper,
-        .destroy = q4_destroy_wrapper};
+        .destroy = q4_destroy_wrapper,
+        .partial = q4_partial_wrapper,
+        .merge = q4_merge_wrapper,
+        .shard_export = q4_shard_export,
+        .shard_init = q4_shard_init};
     return mod;
 }
\ No newline at end of file
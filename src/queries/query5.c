@@ -2,9 +2,9 @@
 #include "queries/query_module.h"
 #include "core/dataset.h"
 #include "entities/access/flights_access.h"
+#include "io/output_builder.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include <math.h>
 #include <time.h>
 
@@ -16,53 +16,49 @@ typedef struct
     double avg_delay_rounded;
 } AirlineDelayPrepared;
 
-GList *prepareAirlineDelays(GPtrArray *flightsArray)
+typedef struct
 {
-    GHashTable *table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-    GList *list = NULL;
-
-    for (guint i = 0; i < flightsArray->len; i++)
-    {
-        const Flight *f = g_ptr_array_index(flightsArray, i);
+    const Flight *const *rows;
+    AirlineDelayPrepared *entry;
+} DelaySum;
 
-        if (!f || strcmp(getFlightStatus(f), "Delayed") != 0)
-            continue;
-
-        const gchar *airline = getFlightAirline(f);
-        if (!airline)
-            continue;
+static void add_delay(guint32 row, gpointer user_data)
+{
+    DelaySum *sum = user_data;
+    const Flight *f = sum->rows[row];
+    sum->entry->total_delay += (double)(getFlightActualDeparture(f) - getFlightDeparture(f)) / 60.0;
+}
 
-        double delay_min = (double)(getFlightActualDeparture(f) - getFlightDeparture(f)) / 60.0;
+// Each airline only visits its own delayed flights: the intersection of its
+// bitmap with the "Delayed" bitmap
+GList *prepareAirlineDelays(const Dataset *ds)
+{
+    const Bitmap *delayed = dataset_flight_status_bitmap(ds, "Delayed");
+    guint nFlights = 0;
+    DelaySum sum = {.rows = dataset_flight_rows(ds, &nFlights)};
+    GList *list = NULL;
 
-        AirlineDelayPrepared *entry = g_hash_table_lookup(table, airline);
-        if (!entry)
+    DatasetStringIterator *airlines = dataset_flight_keys_iter_new(ds, FLIGHT_KEY_AIRLINE);
+    const char *airline;
+    while ((airline = dataset_string_iter_next(airlines)) != NULL)
+    {
+        Bitmap *rows = bitmap_and(dataset_flight_bitmap(ds, FLIGHT_KEY_AIRLINE, airline), delayed);
+        guint64 count = bitmap_cardinality(rows);
+        if (count > 0)
         {
-            entry = g_new0(AirlineDelayPrepared, 1);
+            AirlineDelayPrepared *entry = g_new0(AirlineDelayPrepared, 1);
             entry->airline = g_strdup(airline);
-            entry->delayed_count = 1;
-            entry->total_delay = delay_min;
-            g_hash_table_insert(table, g_strdup(airline), entry);
+            entry->delayed_count = (guint)count;
+            sum.entry = entry;
+            bitmap_foreach(rows, add_delay, &sum);
+            entry->avg_delay_rounded = round((entry->total_delay / entry->delayed_count) * 1000.0) / 1000.0;
+            list = g_list_prepend(list, entry);
         }
-        else
-        {
-            entry->delayed_count++;
-            entry->total_delay += delay_min;
-        }
-    }
-
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, table);
-    while (g_hash_table_iter_next(&iter, &key, &value))
-    {
-        AirlineDelayPrepared *entry = value;
-        entry->avg_delay_rounded = round((entry->total_delay / entry->delayed_count) * 1000.0) / 1000.0;
-        list = g_list_prepend(list, entry);
+        bitmap_free(rows);
     }
+    dataset_string_iter_free(airlines);
 
-    list = g_list_reverse(list);
-    g_hash_table_destroy(table);
-    return list;
+    return g_list_reverse(list);
 }
 
 static gint compare_airline_delay(gconstpointer a, gconstpointer b)
@@ -80,7 +76,9 @@ static gint compare_airline_delay(gconstpointer a, gconstpointer b)
 
 int query5(GList *airlineDelays, int N, FILE *output, int isSpecial)
 {
-    char separator = isSpecial ? '=' : ';';
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
 
     GList *listCopy = g_list_copy(airlineDelays);
     listCopy = g_list_sort(listCopy, (GCompareFunc)compare_airline_delay);
@@ -90,14 +88,15 @@ int query5(GList *airlineDelays, int N, FILE *output, int isSpecial)
     for (GList *l = listCopy; l != NULL && count < (guint)N; l = l->next, count++)
     {
         AirlineDelayPrepared *entry = l->data;
-        fprintf(output, "%s%c%u%c%.3f\n",
-                entry->airline,
-                separator,
-                entry->delayed_count,
-                separator,
-                entry->avg_delay_rounded);
+        output_builder_string(&b, entry->airline);
+        output_builder_separator(&b);
+        output_builder_int(&b, entry->delayed_count);
+        output_builder_separator(&b);
+        output_builder_fixed(&b, entry->avg_delay_rounded, 3);
+        output_builder_char(&b, '\n');
         printed++;
     }
+    output_builder_flush(&b);
 
     g_list_free(listCopy);
     return printed;
@@ -119,20 +118,7 @@ static void *q5_init_wrapper(Dataset *ds)
     if (!ds)
         return NULL;
 
-    GPtrArray *flights = g_ptr_array_new();
-    DatasetIterator *it = dataset_flight_iterator_new(ds);
-    const Flight *f;
-    while ((f = dataset_iterator_next(it)) != NULL)
-    {
-        g_ptr_array_add(flights, (gpointer)f);
-    }
-    dataset_iterator_free(it);
-
-    GList *delays_list = prepareAirlineDelays(flights);
-
-    g_ptr_array_free(flights, TRUE);
-
-    return (void *)delays_list;
+    return (void *)prepareAirlineDelays(ds);
 }
 
 static void q5_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
@@ -154,6 +140,74 @@ static void q5_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int i
     }
 }
 
+// --- Sharded Execution ---
+
+// Each shard sends the delayed flights and total delay of every airline; the averages are computed on the sums
+static void q5_partial_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+    (void)ds;
+    (void)arg1;
+    (void)arg2;
+    (void)isSpecial;
+
+    for (GList *l = ctx; l != NULL; l = l->next)
+    {
+        const AirlineDelayPrepared *entry = l->data;
+        fprintf(output, "%s\t%u\t%.17g\n", entry->airline, entry->delayed_count, entry->total_delay);
+    }
+}
+
+static void q5_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+    (void)arg2;
+    if (!arg1 || !*arg1)
+    {
+        fprintf(output, "\n");
+        return;
+    }
+
+    // Totals are whole minutes, so adding them up in any order is exact
+    GHashTable *table = g_hash_table_new(g_str_hash, g_str_equal);
+    GList *list = NULL;
+    for (int s = 0; s < count; s++)
+    {
+        gchar **lines = g_strsplit(partials[s], "\n", -1);
+        for (int l = 0; lines[l]; l++)
+        {
+            gchar **fields = g_strsplit(lines[l], "\t", 3);
+            if (g_strv_length(fields) == 3)
+            {
+                AirlineDelayPrepared *entry = g_hash_table_lookup(table, fields[0]);
+                if (!entry)
+                {
+                    entry = g_new0(AirlineDelayPrepared, 1);
+                    entry->airline = g_strdup(fields[0]);
+                    g_hash_table_insert(table, entry->airline, entry);
+                    list = g_list_prepend(list, entry);
+                }
+                entry->delayed_count += (guint)strtoul(fields[1], NULL, 10);
+                entry->total_delay += g_ascii_strtod(fields[2], NULL);
+            }
+            g_strfreev(fields);
+        }
+        g_strfreev(lines);
+    }
+    g_hash_table_destroy(table);
+
+    for (GList *l = list; l != NULL; l = l->next)
+    {
+        AirlineDelayPrepared *entry = l->data;
+        entry->avg_delay_rounded = round((entry->total_delay / entry->delayed_count) * 1000.0) / 1000.0;
+    }
+
+    if (query5(list, atoi(arg1), output, isSpecial) == 0)
+    {
+        fprintf(output, "\n");
+    }
+    freeAirlineDelays(list);
+}
+
 static void q5_destroy_wrapper(void *ctx)
 {
     freeAirlineDelays((GList *)ctx);
@@ -165,6 +219,8 @@ QueryModule get_query5_module(void)
         .id = 5,
         .init = q5_init_wrapper,
         .run = q5_run_wrapper,
-        .destroy = q5_destroy_wrapper};
+        .destroy = q5_destroy_wrapper,
+        .partial = q5_partial_wrapper,
+        .merge = q5_merge_wrapper};
     return mod;
 }
\ No newline at end of file
@@ -1,77 +1,153 @@
 #include "queries/query6.h"
 #include "queries/query_module.h"
 #include <core/dataset.h>
+#include <core/dataset_parallel.h>
+#include <core/concurrent_map.h>
+#include <io/output_builder.h>
 #include "entities/access/reservations_access.h"
 #include "entities/access/passengers_access.h"
 #include "entities/access/flights_access.h"
 #include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
 typedef struct
 {
+    GMutex lock; // Guards airportCounts while the table is being built
     GHashTable *airportCounts;
 } NationalityData;
 
+static NationalityData *newNationalityData(void)
+{
+    NationalityData *nd = g_new0(NationalityData, 1);
+    g_mutex_init(&nd->lock);
+    nd->airportCounts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    return nd;
+}
+
 static void freeNationalityData(gpointer data)
 {
     NationalityData *nd = data;
     if (!nd)
         return;
+    g_mutex_clear(&nd->lock);
     g_hash_table_destroy(nd->airportCounts);
     g_free(nd);
 }
 
-GHashTable *prepareNationalityData(const Dataset *ds)
+// Read-only dataset and the nationality map shared by every worker
+typedef struct
 {
-    GHashTable *natTable = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeNationalityData);
-    DatasetIterator *it = dataset_reservation_iterator_new(ds);
-    const Reservation *r;
+    const Dataset *ds;
+    ConcurrentMap *natTable;
+} NationalityJob;
 
-    while ((r = (const Reservation *)dataset_iterator_next(it)) != NULL)
+// Finds the entry of a nationality, creating it if no worker has yet
+static NationalityData *nationalityEntry(ConcurrentMap *natTable, const char *nat)
+{
+    NationalityData *nd = concurrent_map_lookup(natTable, nat);
+    if (nd)
+        return nd;
+
+    gchar *key = g_strdup(nat);
+    NationalityData *fresh = newNationalityData();
+    nd = concurrent_map_insert(natTable, key, fresh);
+    if (nd != fresh)
     {
-        int doc = getReservationDocumentNo(r);
-        const Passenger *p = dataset_get_passenger(ds, doc);
-        if (!p)
-            continue;
+        // Another worker got there first (or the map is full)
+        g_free(key);
+        freeNationalityData(fresh);
+    }
+    return nd;
+}
 
-        const char *nat = getPassengerNationality(p);
-        if (!nat)
-            continue;
+// Reservations whose passenger and legs are resolved per batch lookup
+#define Q6_LOOKUP_BATCH 128
 
-        NationalityData *nd = g_hash_table_lookup(natTable, nat);
-        if (!nd)
+static void nationality_body(const void *const *rows, guint start, guint count, gpointer local, gpointer user_data)
+{
+    NationalityJob *job = user_data;
+    (void)start;
+    (void)local;
+
+    int docs[Q6_LOOKUP_BATCH];
+    const Passenger *passengers[Q6_LOOKUP_BATCH];
+    guint legStart[Q6_LOOKUP_BATCH + 1];
+    GPtrArray *legIds = g_ptr_array_new();
+    GPtrArray *legs = g_ptr_array_new();
+
+    for (guint base = 0; base < count; base += Q6_LOOKUP_BATCH)
+    {
+        guint n = MIN(Q6_LOOKUP_BATCH, count - base);
+
+        // Gather the block's passengers and legs, then resolve them in two batches
+        g_ptr_array_set_size(legIds, 0);
+        for (guint b = 0; b < n; b++)
         {
-            nd = g_new0(NationalityData, 1);
-            nd->airportCounts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-            g_hash_table_insert(natTable, g_strdup(nat), nd);
+            const Reservation *r = rows[base + b];
+            docs[b] = getReservationDocumentNo(r);
+            legStart[b] = legIds->len;
+            gchar **flightIds = getReservationFlightIds(r);
+            for (int i = 0; flightIds && flightIds[i]; i++)
+                g_ptr_array_add(legIds, flightIds[i]);
         }
+        legStart[n] = legIds->len;
 
-        gchar **flightIds = getReservationFlightIds(r);
-        if (!flightIds)
-            continue;
-        for (int i = 0; flightIds[i]; i++)
+        dataset_get_passengers_batch(job->ds, docs, n, passengers);
+        g_ptr_array_set_size(legs, legIds->len);
+        dataset_get_flights_batch(job->ds, (const char *const *)legIds->pdata, legIds->len, (const Flight **)legs->pdata);
+
+        for (guint b = 0; b < n; b++)
         {
-            const Flight *f = dataset_get_flight(ds, flightIds[i]);
-            if (!f || strcmp(getFlightStatus(f), "Cancelled") == 0)
+            const Passenger *p = passengers[b];
+            if (!p)
+                continue;
+
+            const char *nat = getPassengerNationality(p);
+            if (!nat)
                 continue;
-            const char *dest = getFlightDestination(f);
-            if (!dest)
+
+            NationalityData *nd = nationalityEntry(job->natTable, nat);
+            if (!nd || legStart[b] == legStart[b + 1])
                 continue;
 
-            gpointer countPtr = g_hash_table_lookup(nd->airportCounts, dest);
-            int count = countPtr ? GPOINTER_TO_INT(countPtr) : 0;
-            g_hash_table_replace(nd->airportCounts, g_strdup(dest), GINT_TO_POINTER(count + 1));
+            g_mutex_lock(&nd->lock);
+            for (guint l = legStart[b]; l < legStart[b + 1]; l++)
+            {
+                const Flight *f = g_ptr_array_index(legs, l);
+                if (!f || strcmp(getFlightStatus(f), "Cancelled") == 0)
+                    continue;
+                const char *dest = getFlightDestination(f);
+                if (!dest)
+                    continue;
+
+                gpointer countPtr = g_hash_table_lookup(nd->airportCounts, dest);
+                int seen = countPtr ? GPOINTER_TO_INT(countPtr) : 0;
+                g_hash_table_replace(nd->airportCounts, g_strdup(dest), GINT_TO_POINTER(seen + 1));
+            }
+            g_mutex_unlock(&nd->lock);
         }
     }
-    dataset_iterator_free(it);
-    return natTable;
+
+    g_ptr_array_free(legIds, TRUE);
+    g_ptr_array_free(legs, TRUE);
+}
+
+LookupTable *prepareNationalityData(const Dataset *ds)
+{
+    const StringDict *nationalities = dataset_nationalities_dict(ds);
+    ConcurrentMap *natTable = concurrent_map_new(LOOKUP_KEY_STRING, string_dict_size(nationalities),
+                                                 g_free, freeNationalityData);
+    NationalityJob job = {.ds = ds, .natTable = natTable};
+    DatasetParallelOps ops = {.body = nationality_body};
+    dataset_parallel_foreach_reservation(ds, &ops, &job);
+    return concurrent_map_seal(natTable);
 }
 
-int query_Q6(GHashTable *natTable, const char *nationality, FILE *output, int isSpecial)
+int query_Q6(const LookupTable *natTable, const char *nationality, FILE *output, int isSpecial)
 {
-    char sep = isSpecial ? '=' : ';';
-    NationalityData *nd = g_hash_table_lookup(natTable, nationality);
+    const NationalityData *nd = lookup_table_get(natTable, nationality);
     if (!nd)
         return 0;
 
@@ -90,12 +166,18 @@ int query_Q6(GHashTable *natTable, const char *nationality, FILE *output, int is
             bestCount = count;
         }
     }
-    if (bestAirport)
-    {
-        fprintf(output, "%s%c%d\n", bestAirport, sep, bestCount);
-        return 1;
-    }
-    return 0;
+    if (!bestAirport)
+        return 0;
+
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+    output_builder_string(&b, bestAirport);
+    output_builder_separator(&b);
+    output_builder_int(&b, bestCount);
+    output_builder_char(&b, '\n');
+    output_builder_flush(&b);
+    return 1;
 }
 
 static void *q6_init_wrapper(Dataset *ds)
@@ -107,7 +189,7 @@ static void q6_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int i
 {
     (void)ds;
     (void)arg2;
-    GHashTable *natTable = (GHashTable *)ctx;
+    const LookupTable *natTable = ctx;
     if (!arg1 || !*arg1)
     {
         fprintf(output, "\n");
@@ -119,15 +201,91 @@ static void q6_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int i
     }
 }
 
+// --- Sharded Execution ---
+
+// A leg is only resolved by the shard owning its flight: each shard sends its destination counts
+static void q6_partial_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+    (void)ds;
+    (void)arg2;
+    (void)isSpecial;
+    const NationalityData *nd = (ctx && arg1) ? lookup_table_get(ctx, arg1) : NULL;
+    if (!nd)
+        return;
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, nd->airportCounts);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+        fprintf(output, "%s\t%d\n", (const char *)key, GPOINTER_TO_INT(value));
+}
+
+static void q6_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+    (void)arg1;
+    (void)arg2;
+
+    GHashTable *airportCounts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (int s = 0; s < count; s++)
+    {
+        gchar **lines = g_strsplit(partials[s], "\n", -1);
+        for (int l = 0; lines[l]; l++)
+        {
+            gchar *tab = strchr(lines[l], '\t');
+            if (!tab)
+                continue;
+            *tab = '\0';
+            int seen = GPOINTER_TO_INT(g_hash_table_lookup(airportCounts, lines[l]));
+            g_hash_table_replace(airportCounts, g_strdup(lines[l]), GINT_TO_POINTER(seen + atoi(tab + 1)));
+        }
+        g_strfreev(lines);
+    }
+
+    char *bestAirport = NULL;
+    int bestCount = 0;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, airportCounts);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        char *airport = (char *)key;
+        int airportCount = GPOINTER_TO_INT(value);
+        if (airportCount > bestCount ||
+            (airportCount == bestCount && (!bestAirport || strcmp(airport, bestAirport) < 0)))
+        {
+            bestAirport = airport;
+            bestCount = airportCount;
+        }
+    }
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+    if (bestAirport)
+    {
+        output_builder_string(&b, bestAirport);
+        output_builder_separator(&b);
+        output_builder_int(&b, bestCount);
+    }
+    output_builder_char(&b, '\n');
+    output_builder_flush(&b);
+    g_hash_table_destroy(airportCounts);
+}
+
 static void q6_destroy_wrapper(void *ctx)
 {
     if (ctx)
-        g_hash_table_destroy((GHashTable *)ctx);
+        lookup_table_free(ctx);
 }
 
 QueryModule get_query6_module(void)
 {
     QueryModule mod = {
-        .id = 6, .init = q6_init_wrapper, .run = q6_run_wrapper, .destroy = q6_destroy_wrapper};
+        .id = 6,
+        .init = q6_init_wrapper,
+        .run = q6_run_wrapper,
+        .destroy = q6_destroy_wrapper,
+        .partial = q6_partial_wrapper,
+        .merge = q6_merge_wrapper};
     return mod;
 }
\ No newline at end of file
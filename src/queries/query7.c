@@ -0,0 +1,355 @@
+#include "queries/query7.h"
+#include "queries/query_module.h"
+#include "core/dataset.h"
+#include "core/time_utils.h"
+#include "entities/access/reservations_access.h"
+#include "entities/access/passengers_access.h"
+#include "entities/access/flights_access.h"
+#include "io/output_builder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Appends a date as "%04d-%02d-%02d %02d:%02d" (see format_time_t()), or "N/A" if it is invalid
+static void append_time(OutputBuilder *b, time_t t)
+{
+    struct tm info;
+    if (t < (time_t)0 || !gmtime_r(&t, &info))
+    {
+        output_builder_string(b, "N/A");
+        return;
+    }
+    output_builder_int_padded(b, info.tm_year + 1900, 4);
+    output_builder_char(b, '-');
+    output_builder_int_padded(b, info.tm_mon + 1, 2);
+    output_builder_char(b, '-');
+    output_builder_int_padded(b, info.tm_mday, 2);
+    output_builder_char(b, ' ');
+    output_builder_int_padded(b, info.tm_hour, 2);
+    output_builder_char(b, ':');
+    output_builder_int_padded(b, info.tm_min, 2);
+}
+
+// Writes one leg of a booking, without the line terminator
+static void print_leg(const Reservation *r, const Flight *f, OutputBuilder *b)
+{
+    output_builder_string(b, getReservationId(r));
+    output_builder_separator(b);
+    output_builder_string(b, getFlightId(f));
+    output_builder_separator(b);
+    output_builder_string(b, getFlightOrigin(f));
+    output_builder_separator(b);
+    output_builder_string(b, getFlightDestination(f));
+    output_builder_separator(b);
+    append_time(b, getFlightDeparture(f));
+    output_builder_separator(b);
+    append_time(b, getFlightArrival(f));
+    output_builder_separator(b);
+    output_builder_string(b, getFlightStatus(f));
+    output_builder_separator(b);
+    output_builder_fixed(b, getReservationPrice(r), 3);
+}
+
+// Writes the passenger line of the result
+static void print_header(OutputBuilder *b, int documentNo, const char *firstName, const char *lastName,
+                         guint count, double total)
+{
+    output_builder_int_padded(b, documentNo, 9);
+    output_builder_separator(b);
+    output_builder_string(b, firstName);
+    output_builder_separator(b);
+    output_builder_string(b, lastName);
+    output_builder_separator(b);
+    output_builder_int(b, count);
+    output_builder_separator(b);
+    output_builder_fixed(b, total, 3);
+    output_builder_char(b, '\n');
+}
+
+int query7(const Dataset *ds, int documentNo, FILE *output, int isSpecial)
+{
+    const Passenger *p = dataset_get_passenger(ds, documentNo);
+    if (!p)
+        return 0;
+
+    guint count = 0;
+    const Reservation *const *bookings = dataset_passenger_reservations(ds, documentNo, &count);
+
+    double total = 0.0;
+    for (guint i = 0; i < count; i++)
+        total += getReservationPrice(bookings[i]);
+
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+    print_header(&b, documentNo, getPassengerFirstName(p), getPassengerLastName(p), count, total);
+
+    for (guint i = 0; i < count; i++)
+    {
+        const Reservation *r = bookings[i];
+        gchar **flightIds = getReservationFlightIds(r);
+        if (!flightIds)
+            continue;
+
+        for (int l = 0; flightIds[l]; l++)
+        {
+            const Flight *f = dataset_get_flight(ds, flightIds[l]);
+            if (!f)
+                continue;
+
+            print_leg(r, f, &b);
+            output_builder_char(&b, '\n');
+        }
+    }
+    output_builder_flush(&b);
+    return 1;
+}
+
+// --- Module Wrappers ---
+
+// Document numbers are purely numeric
+static int is_document_number(const char *arg)
+{
+    if (!arg || !*arg)
+        return 0;
+    for (const char *c = arg; *c; c++)
+    {
+        if (!isdigit((unsigned char)*c))
+            return 0;
+    }
+    return 1;
+}
+
+static void q7_run_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+    (void)ctx;
+    (void)arg2;
+
+    if (!is_document_number(arg1))
+    {
+        fprintf(output, "\n");
+        return;
+    }
+
+    if (query7(ds, atoi(arg1), output, isSpecial) == 0)
+    {
+        fprintf(output, "\n");
+    }
+}
+
+// --- Sharded Execution ---
+
+// A shard holds every booking with at least one of its flights, but only prints the legs it owns.
+// It sends the passenger ("P"), each booking with its price and, when it owns the first leg, its
+// departure ("R"), and each owned leg with its position ("L"); the coordinator rebuilds the order.
+static void q7_partial_wrapper(void *ctx, Dataset *ds, char *arg1, char *arg2, int isSpecial, FILE *output)
+{
+    (void)ctx;
+    (void)arg2;
+
+    if (!is_document_number(arg1))
+        return;
+    int documentNo = atoi(arg1);
+    const Passenger *p = dataset_get_passenger(ds, documentNo);
+    if (!p)
+        return;
+
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder b;
+    output_builder_init(&b, buffer, sizeof(buffer), isSpecial, output);
+    output_builder_string(&b, "P\t");
+    output_builder_string(&b, getPassengerFirstName(p));
+    output_builder_char(&b, '\t');
+    output_builder_string(&b, getPassengerLastName(p));
+    output_builder_char(&b, '\n');
+
+    guint count = 0;
+    const Reservation *const *bookings = dataset_passenger_reservations(ds, documentNo, &count);
+    for (guint i = 0; i < count; i++)
+    {
+        const Reservation *r = bookings[i];
+        gchar **flightIds = getReservationFlightIds(r);
+        const Flight *first = (flightIds && flightIds[0]) ? dataset_get_flight(ds, flightIds[0]) : NULL;
+
+        // The price travels with full precision, so the coordinator sums the same values
+        char price[32];
+        snprintf(price, sizeof(price), "%.17g", getReservationPrice(r));
+        output_builder_string(&b, "R\t");
+        output_builder_string(&b, getReservationId(r));
+        output_builder_char(&b, '\t');
+        output_builder_string(&b, price);
+        output_builder_char(&b, '\t');
+        if (first)
+            output_builder_int(&b, (gint64)getFlightDeparture(first));
+        else
+            output_builder_char(&b, '-');
+        output_builder_char(&b, '\n');
+
+        for (int l = 0; flightIds && flightIds[l]; l++)
+        {
+            const Flight *f = dataset_get_flight(ds, flightIds[l]);
+            if (!f)
+                continue;
+            output_builder_string(&b, "L\t");
+            output_builder_string(&b, getReservationId(r));
+            output_builder_char(&b, '\t');
+            output_builder_int(&b, l);
+            output_builder_char(&b, '\t');
+            print_leg(r, f, &b);
+            output_builder_char(&b, '\n');
+        }
+    }
+    output_builder_flush(&b);
+}
+
+typedef struct
+{
+    gchar *id;
+    double price;
+    gint64 departure; // G_MAXINT64 when no shard knows it, so it sorts last
+    GPtrArray *legs;  // MergedLeg
+} MergedBooking;
+
+typedef struct
+{
+    int index;
+    gchar *line;
+} MergedLeg;
+
+static void free_merged_leg(gpointer data)
+{
+    MergedLeg *leg = data;
+    g_free(leg->line);
+    g_free(leg);
+}
+
+static void free_merged_booking(gpointer data)
+{
+    MergedBooking *b = data;
+    g_free(b->id);
+    g_ptr_array_free(b->legs, TRUE);
+    g_free(b);
+}
+
+static MergedBooking *merged_booking(GHashTable *bookings, const char *id)
+{
+    MergedBooking *b = g_hash_table_lookup(bookings, id);
+    if (!b)
+    {
+        b = g_new0(MergedBooking, 1);
+        b->id = g_strdup(id);
+        b->departure = G_MAXINT64;
+        b->legs = g_ptr_array_new_with_free_func(free_merged_leg);
+        g_hash_table_insert(bookings, b->id, b);
+    }
+    return b;
+}
+
+// Chronological order of the passenger index: first departure, then reservation ID
+static gint compare_merged_bookings(gconstpointer a, gconstpointer b)
+{
+    const MergedBooking *ba = *(MergedBooking *const *)a;
+    const MergedBooking *bb = *(MergedBooking *const *)b;
+    if (ba->departure != bb->departure)
+        return ba->departure < bb->departure ? -1 : 1;
+    return strcmp(ba->id, bb->id);
+}
+
+static gint compare_merged_legs(gconstpointer a, gconstpointer b)
+{
+    const MergedLeg *la = *(MergedLeg *const *)a;
+    const MergedLeg *lb = *(MergedLeg *const *)b;
+    return (la->index > lb->index) - (la->index < lb->index);
+}
+
+static void q7_merge_wrapper(char *const *partials, int count, char *arg1, char *arg2, int isSpecial,
+                             FILE *output)
+{
+    (void)arg2;
+
+    gchar **names = NULL;
+    GHashTable *bookings = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_merged_booking);
+    for (int s = 0; s < count; s++)
+    {
+        gchar **lines = g_strsplit(partials[s], "\n", -1);
+        for (int l = 0; lines[l]; l++)
+        {
+            gchar **fields = g_strsplit(lines[l], "\t", 4);
+            guint n = g_strv_length(fields);
+            if (n == 3 && strcmp(fields[0], "P") == 0 && !names)
+            {
+                names = fields;
+                continue;
+            }
+            if (n == 4 && strcmp(fields[0], "R") == 0)
+            {
+                MergedBooking *b = merged_booking(bookings, fields[1]);
+                b->price = g_ascii_strtod(fields[2], NULL);
+                if (strcmp(fields[3], "-") != 0)
+                    b->departure = g_ascii_strtoll(fields[3], NULL, 10);
+            }
+            else if (n == 4 && strcmp(fields[0], "L") == 0)
+            {
+                MergedLeg *leg = g_new(MergedLeg, 1);
+                leg->index = atoi(fields[2]);
+                leg->line = g_strdup(fields[3]);
+                g_ptr_array_add(merged_booking(bookings, fields[1])->legs, leg);
+            }
+            g_strfreev(fields);
+        }
+        g_strfreev(lines);
+    }
+
+    if (!names)
+    {
+        fprintf(output, "\n");
+        g_hash_table_destroy(bookings);
+        return;
+    }
+
+    GPtrArray *ordered = g_ptr_array_sized_new(g_hash_table_size(bookings));
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, bookings);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+        g_ptr_array_add(ordered, value);
+    g_ptr_array_sort(ordered, compare_merged_bookings);
+
+    double total = 0.0;
+    for (guint i = 0; i < ordered->len; i++)
+        total += ((MergedBooking *)g_ptr_array_index(ordered, i))->price;
+
+    char buffer[OUTPUT_BUILDER_SIZE];
+    OutputBuilder out;
+    output_builder_init(&out, buffer, sizeof(buffer), isSpecial, output);
+    print_header(&out, atoi(arg1), names[1], names[2], ordered->len, total);
+
+    for (guint i = 0; i < ordered->len; i++)
+    {
+        MergedBooking *b = g_ptr_array_index(ordered, i);
+        g_ptr_array_sort(b->legs, compare_merged_legs);
+        for (guint l = 0; l < b->legs->len; l++)
+        {
+            output_builder_string(&out, ((MergedLeg *)g_ptr_array_index(b->legs, l))->line);
+            output_builder_char(&out, '\n');
+        }
+    }
+    output_builder_flush(&out);
+
+    g_ptr_array_free(ordered, TRUE);
+    g_hash_table_destroy(bookings);
+    g_strfreev(names);
+}
+
+QueryModule get_query7_module(void)
+{
+    QueryModule mod = {
+        .id = 7,
+        .init = NULL,
+        .run = q7_run_wrapper,
+        .destroy = NULL,
+        .partial = q7_partial_wrapper,
+        .merge = q7_merge_wrapper};
+    return mod;
+}
@@ -0,0 +1,447 @@
+#include "queries/server.h"
+#include "core/dataset_parallel.h"
+#include <glib.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+extern QueryManager *query_manager_create(Dataset *ds);
+extern void query_manager_destroy(QueryManager *qm);
+extern int query_manager_execute(QueryManager *qm, int queryId, char *arg1, char *arg2,
+                                 int isSpecial, FILE *output, Dataset *ds, gboolean *cached);
+
+typedef struct
+{
+    Dataset *ds;
+    QueryManager *qm;
+    GThreadPool *pool;
+    GMutex lock; // Guards clients
+    GCond idle;  // Signalled whenever a client goes away
+    GHashTable *clients;
+} QueryServer;
+
+typedef struct
+{
+    QueryServer *server;
+    int fd;
+    gint refCount; // The reading thread, plus one per command not yet answered
+    GMutex sendLock;
+} ClientConnection;
+
+// One line of a client, waiting for a pool thread
+typedef struct
+{
+    ClientConnection *client;
+    guint32 sequence;
+    gchar *line;
+} ServerTask;
+
+// --- Transport ---
+
+static gboolean send_all(int fd, gconstpointer data, gsize len)
+{
+    const guint8 *p = data;
+    while (len > 0)
+    {
+        // MSG_NOSIGNAL: a client that went away is an error, not a SIGPIPE
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+static gboolean recv_all(int fd, gpointer data, gsize len)
+{
+    guint8 *p = data;
+    while (len > 0)
+    {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+static gboolean socket_address(const char *socketPath, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr->sun_path))
+        return FALSE;
+    strcpy(addr->sun_path, socketPath);
+    return TRUE;
+}
+
+// --- Server ---
+
+static void client_unref(ClientConnection *client)
+{
+    if (!g_atomic_int_dec_and_test(&client->refCount))
+        return;
+
+    QueryServer *server = client->server;
+    g_mutex_lock(&server->lock);
+    g_hash_table_remove(server->clients, client);
+    close(client->fd);
+    g_cond_broadcast(&server->idle);
+    g_mutex_unlock(&server->lock);
+
+    g_mutex_clear(&client->sendLock);
+    g_free(client);
+}
+
+// Runs on a pool thread; concurrent tasks only share the read-only contexts
+static void run_task(gpointer data, gpointer user_data)
+{
+    ServerTask *task = data;
+    QueryServer *server = user_data;
+
+    QueryCommand cmd;
+    int status = query_command_parse(task->line, &cmd);
+    char *result = NULL;
+    size_t resultSize = 0;
+    gboolean cached = FALSE;
+    if (status > 0)
+    {
+        FILE *output = open_memstream(&result, &resultSize);
+        if (output)
+        {
+            if (query_manager_execute(server->qm, cmd.queryNumber, cmd.arg1, cmd.arg2, cmd.isSpecial, output,
+                                      server->ds, &cached) != 0)
+            {
+                fprintf(output, "\n");
+            }
+            fclose(output);
+        }
+    }
+
+    QueryReplyHeader header = {
+        .sequence = task->sequence, .status = status, .length = (guint32)resultSize, .cached = (guint32)cached};
+    ClientConnection *client = task->client;
+    g_mutex_lock(&client->sendLock);
+    if (send_all(client->fd, &header, sizeof(header)))
+        send_all(client->fd, result, resultSize);
+    g_mutex_unlock(&client->sendLock);
+
+    free(result);
+    g_free(task->line);
+    g_free(task);
+    client_unref(client);
+}
+
+// Reads the client's lines and hands them to the pool, until the client stops sending
+static gpointer client_thread(gpointer data)
+{
+    ClientConnection *client = data;
+    int readFd = dup(client->fd);
+    FILE *input = readFd >= 0 ? fdopen(readFd, "r") : NULL;
+
+    if (input)
+    {
+        char line[1024];
+        guint32 sequence = 0;
+        while (fgets(line, sizeof(line), input))
+        {
+            ServerTask *task = g_new(ServerTask, 1);
+            task->client = client;
+            task->sequence = sequence++;
+            task->line = g_strdup(line);
+            g_atomic_int_inc(&client->refCount);
+            g_thread_pool_push(client->server->pool, task, NULL);
+        }
+        fclose(input);
+    }
+    else if (readFd >= 0)
+    {
+        close(readFd);
+    }
+
+    // The connection closes once its last command is answered
+    client_unref(client);
+    return NULL;
+}
+
+static int listen_on(const char *socketPath)
+{
+    struct sockaddr_un addr;
+    if (!socket_address(socketPath, &addr))
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    unlink(socketPath);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+gboolean query_server_run(Dataset *ds, const char *socketPath)
+{
+    if (!ds || !socketPath)
+        return FALSE;
+
+    // Stop signals are read from a descriptor, so they are blocked before any thread starts
+    sigset_t stopSignals, previousMask;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+
+    int signalFd = signalfd(-1, &stopSignals, SFD_CLOEXEC);
+    int listenFd = signalFd >= 0 ? listen_on(socketPath) : -1;
+    if (listenFd < 0)
+    {
+        if (signalFd >= 0)
+            close(signalFd);
+        pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+        return FALSE;
+    }
+
+    QueryServer server = {.ds = ds};
+    g_mutex_init(&server.lock);
+    g_cond_init(&server.idle);
+    server.clients = g_hash_table_new(g_direct_hash, g_direct_equal);
+    server.qm = query_manager_create(ds);
+
+    // Clients may ask anything: every context is built before the first one connects
+    int queryIds[QUERY_MODULE_COUNT];
+    for (int i = 0; i < QUERY_MODULE_COUNT; i++)
+        queryIds[i] = i + 1;
+    query_manager_prepare(server.qm, queryIds, QUERY_MODULE_COUNT);
+
+    server.pool = g_thread_pool_new(run_task, &server, (gint)dataset_parallel_get_workers(), FALSE, NULL);
+
+    struct pollfd fds[2] = {{.fd = listenFd, .events = POLLIN}, {.fd = signalFd, .events = POLLIN}};
+    while (TRUE)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+        {
+            // Consumed, so that it is not delivered once the signals are unblocked
+            struct signalfd_siginfo info;
+            if (read(signalFd, &info, sizeof(info)) < 0)
+                continue;
+            break;
+        }
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        int clientFd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (clientFd < 0)
+            continue;
+
+        ClientConnection *client = g_new0(ClientConnection, 1);
+        client->server = &server;
+        client->fd = clientFd;
+        client->refCount = 1;
+        g_mutex_init(&client->sendLock);
+        g_mutex_lock(&server.lock);
+        g_hash_table_add(server.clients, client);
+        g_mutex_unlock(&server.lock);
+        g_thread_unref(g_thread_new("query-client", client_thread, client));
+    }
+
+    close(listenFd);
+    unlink(socketPath);
+
+    // No new commands are read; those already received are still answered
+    g_mutex_lock(&server.lock);
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, server.clients);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+        shutdown(((ClientConnection *)key)->fd, SHUT_RD);
+    while (g_hash_table_size(server.clients) > 0)
+        g_cond_wait(&server.idle, &server.lock);
+    g_mutex_unlock(&server.lock);
+
+    g_thread_pool_free(server.pool, FALSE, TRUE);
+    query_manager_destroy(server.qm);
+    g_hash_table_destroy(server.clients);
+    g_cond_clear(&server.idle);
+    g_mutex_clear(&server.lock);
+
+    close(signalFd);
+    pthread_sigmask(SIG_SETMASK, &previousMask, NULL);
+    return TRUE;
+}
+
+// --- Client ---
+
+typedef struct
+{
+    gchar *line; // As read, newline included
+    int queryNumber;
+    int lineNumber;
+    gint64 sentAt; // Monotonic, in microseconds
+    gdouble elapsed;
+    gboolean cached;
+    gboolean answered;
+} ClientCommand;
+
+typedef struct
+{
+    int fd;
+    GArray *commands;
+    GMutex timesLock; // sentAt is written by the sender and read on replies
+} ClientSession;
+
+// Numbers the lines as runAllQueries() does, keeping only those holding a command
+static GArray *read_client_commands(FILE *inputFile)
+{
+    GArray *commands = g_array_new(FALSE, TRUE, sizeof(ClientCommand));
+    char line[1024];
+    int lineNumber = 1;
+
+    while (fgets(line, sizeof(line), inputFile))
+    {
+        gchar *parsedLine = g_strdup(line);
+        QueryCommand cmd;
+        int parsed = query_command_parse(parsedLine, &cmd);
+        g_free(parsedLine);
+        if (parsed <= 0)
+        {
+            if (parsed == 0)
+                lineNumber++;
+            continue;
+        }
+
+        ClientCommand c = {.queryNumber = cmd.queryNumber, .lineNumber = lineNumber++};
+        gsize len = strlen(line);
+        c.line = len > 0 && line[len - 1] == '\n' ? g_strdup(line) : g_strconcat(line, "\n", NULL);
+        g_array_append_val(commands, c);
+    }
+    return commands;
+}
+
+// Streams the commands while the calling thread reads the replies
+static gpointer sender_thread(gpointer data)
+{
+    ClientSession *session = data;
+    for (guint i = 0; i < session->commands->len; i++)
+    {
+        ClientCommand *c = &g_array_index(session->commands, ClientCommand, i);
+        g_mutex_lock(&session->timesLock);
+        c->sentAt = g_get_monotonic_time();
+        g_mutex_unlock(&session->timesLock);
+        if (!send_all(session->fd, c->line, strlen(c->line)))
+            break;
+    }
+    shutdown(session->fd, SHUT_WR);
+    return NULL;
+}
+
+// Copies a reply body straight into the command's output buffer
+static gboolean receive_result(int fd, guint32 length, FILE *output)
+{
+    char chunk[65536];
+    while (length > 0)
+    {
+        gsize n = length < sizeof(chunk) ? length : sizeof(chunk);
+        if (!recv_all(fd, chunk, n))
+            return FALSE;
+        fwrite(chunk, 1, n, output);
+        length -= (guint32)n;
+    }
+    return TRUE;
+}
+
+gboolean query_client_run(const char *socketPath, const char *filePath, OutputWriter *writer,
+                          QueryStatsCallback callback, void *ctx)
+{
+    if (!socketPath || !filePath || !writer)
+        return FALSE;
+
+    struct sockaddr_un addr;
+    if (!socket_address(socketPath, &addr))
+        return FALSE;
+
+    FILE *inputFile = fopen(filePath, "r");
+    if (!inputFile)
+        return FALSE;
+    GArray *commands = read_client_commands(inputFile);
+    fclose(inputFile);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        for (guint i = 0; i < commands->len; i++)
+            g_free(g_array_index(commands, ClientCommand, i).line);
+        g_array_free(commands, TRUE);
+        return FALSE;
+    }
+
+    ClientSession session = {.fd = fd, .commands = commands};
+    g_mutex_init(&session.timesLock);
+    GThread *sender = g_thread_new("query-sender", sender_thread, &session);
+
+    guint answered = 0;
+    while (answered < commands->len)
+    {
+        QueryReplyHeader header;
+        if (!recv_all(fd, &header, sizeof(header)) || header.sequence >= commands->len)
+            break;
+
+        ClientCommand *c = &g_array_index(commands, ClientCommand, header.sequence);
+        OutputBuffer *buffer = output_writer_acquire(writer, c->lineNumber);
+        gboolean received = receive_result(fd, header.length, output_buffer_stream(buffer));
+        output_writer_submit(writer, buffer);
+        if (!received)
+            break;
+
+        g_mutex_lock(&session.timesLock);
+        c->elapsed = (gdouble)(g_get_monotonic_time() - c->sentAt) / G_USEC_PER_SEC;
+        g_mutex_unlock(&session.timesLock);
+        c->cached = header.cached != 0;
+        c->answered = TRUE;
+        answered++;
+    }
+
+    // A server gone mid-run must not leave the sender blocked
+    shutdown(fd, SHUT_RDWR);
+    g_thread_join(sender);
+    close(fd);
+    g_mutex_clear(&session.timesLock);
+
+    // Callbacks fire in command order, once the results are on disk
+    output_writer_flush(writer);
+    for (guint i = 0; i < commands->len; i++)
+    {
+        ClientCommand *c = &g_array_index(commands, ClientCommand, i);
+        if (callback && c->answered)
+            callback(c->queryNumber, c->lineNumber, c->elapsed, c->cached, ctx);
+        g_free(c->line);
+    }
+
+    gboolean complete = answered == commands->len;
+    g_array_free(commands, TRUE);
+    return complete;
+}
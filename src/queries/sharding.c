@@ -0,0 +1,469 @@
+#include "queries/sharding.h"
+#include "queries/query_module.h"
+#include "core/dataset_parallel.h"
+#include "io/dataset_image.h"
+#include "entities/access/flights_access.h"
+#include "entities/access/reservations_access.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+struct shard_pool
+{
+    guint nShards;
+    int *fds; // Coordinator end of each worker's socket, -1 once the worker is lost
+    pid_t *pids;
+    QueryModule modules[QUERY_MODULE_COUNT];
+};
+
+// Fixed part of a command; the arguments follow (a length of -1 stands for NULL)
+typedef struct
+{
+    gint32 queryNumber; // 0 asks the worker to exit
+    gint32 isSpecial;
+    gint32 arg1Len;
+    gint32 arg2Len;
+} ShardRequest;
+
+// --- Transport ---
+
+static gboolean send_all(int fd, gconstpointer data, gsize len)
+{
+    const guint8 *p = data;
+    while (len > 0)
+    {
+        // MSG_NOSIGNAL: a lost peer is an error, not a SIGPIPE
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+static gboolean recv_all(int fd, gpointer data, gsize len)
+{
+    guint8 *p = data;
+    while (len > 0)
+    {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        len -= (gsize)n;
+    }
+    return TRUE;
+}
+
+// A message is its length followed by its bytes
+static gboolean send_message(int fd, gconstpointer data, guint64 len)
+{
+    return send_all(fd, &len, sizeof(len)) && send_all(fd, data, len);
+}
+
+// Returns the bytes of a message, NUL-terminated (free with g_free()), or NULL on failure
+static gchar *recv_message(int fd, guint64 *len)
+{
+    guint64 size;
+    if (!recv_all(fd, &size, sizeof(size)) || size >= G_MAXSIZE)
+        return NULL;
+
+    gchar *data = g_malloc(size + 1);
+    if (!recv_all(fd, data, size))
+    {
+        g_free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    if (len)
+        *len = size;
+    return data;
+}
+
+// --- Partitioning ---
+
+typedef struct
+{
+    const Dataset *ds;
+    guint shard;
+    guint nShards;
+} ShardSlice;
+
+static guint shard_of_airport(const char *code, guint nShards)
+{
+    return code ? g_str_hash(code) % nShards : 0;
+}
+
+static gboolean keep_flight(const Flight *f, gpointer user_data)
+{
+    const ShardSlice *slice = user_data;
+    return shard_of_airport(getFlightOrigin(f), slice->nShards) == slice->shard;
+}
+
+static gboolean keep_reservation(const Reservation *r, gpointer user_data)
+{
+    const ShardSlice *slice = user_data;
+    gboolean resolved = FALSE;
+    gchar **flightIds = getReservationFlightIds(r);
+    for (int l = 0; flightIds && flightIds[l]; l++)
+    {
+        const Flight *f = dataset_get_flight(slice->ds, flightIds[l]);
+        if (!f)
+            continue;
+        if (keep_flight(f, user_data))
+            return TRUE;
+        resolved = TRUE;
+    }
+
+    // A booking with no known flight still belongs to exactly one shard
+    return !resolved && g_str_hash(getReservationId(r)) % slice->nShards == slice->shard;
+}
+
+// --- Worker ---
+
+// Attaches the slice sent by the coordinator and builds the query contexts over it
+static gboolean receive_slice(int fd, Dataset *ds, const QueryModule *mods, void **contexts)
+{
+    guint64 size = 0;
+    gchar *image = recv_message(fd, &size);
+    if (!image)
+        return FALSE;
+
+    DatasetImage *img = dataset_image_wrap(image, size, g_free, image);
+    if (!img)
+    {
+        g_free(image);
+        return FALSE;
+    }
+    if (!dataset_image_attach(ds, img))
+        return FALSE;
+
+    for (int i = 0; i < QUERY_MODULE_COUNT; i++)
+    {
+        if (mods[i].shard_export)
+        {
+            guint64 len = 0;
+            gchar *data = recv_message(fd, &len);
+            if (!data)
+                return FALSE;
+            GBytes *payload = g_bytes_new_take(data, len);
+            contexts[i] = mods[i].shard_init(ds, payload);
+            g_bytes_unref(payload);
+        }
+        else if (mods[i].init)
+        {
+            contexts[i] = mods[i].init(ds);
+        }
+    }
+    return TRUE;
+}
+
+static gchar *receive_argument(int fd, gint32 len)
+{
+    if (len < 0)
+        return NULL;
+    gchar *arg = g_malloc((gsize)len + 1);
+    if (!recv_all(fd, arg, (gsize)len))
+    {
+        g_free(arg);
+        return NULL;
+    }
+    arg[len] = '\0';
+    return arg;
+}
+
+static void serve_commands(int fd, Dataset *ds, const QueryModule *mods, void **contexts)
+{
+    ShardRequest req;
+    while (recv_all(fd, &req, sizeof(req)) && req.queryNumber != 0)
+    {
+        gchar *arg1 = receive_argument(fd, req.arg1Len);
+        gchar *arg2 = receive_argument(fd, req.arg2Len);
+        if ((req.arg1Len >= 0 && !arg1) || (req.arg2Len >= 0 && !arg2))
+        {
+            g_free(arg1);
+            g_free(arg2);
+            return;
+        }
+
+        char *partial = NULL;
+        size_t partialLen = 0;
+        FILE *output = open_memstream(&partial, &partialLen);
+        for (int i = 0; output && i < QUERY_MODULE_COUNT; i++)
+        {
+            if (mods[i].id == req.queryNumber && mods[i].partial)
+                mods[i].partial(contexts[i], ds, arg1, arg2, req.isSpecial, output);
+        }
+        if (output)
+            fclose(output);
+
+        gboolean sent = send_message(fd, partial ? partial : "", partialLen);
+        free(partial);
+        g_free(arg1);
+        g_free(arg2);
+        if (!sent)
+            return;
+    }
+}
+
+// Never returns: the worker exits once the coordinator stops it (or goes away)
+static void shard_worker_run(int fd, guint nShards)
+{
+    // The shards share the machine: split the scan threads between them
+    dataset_parallel_set_workers(MAX(1, dataset_parallel_get_workers() / nShards));
+
+    Dataset *ds = initDataset();
+    QueryModule mods[QUERY_MODULE_COUNT];
+    void *contexts[QUERY_MODULE_COUNT] = {NULL};
+    query_modules_collect(mods);
+
+    gboolean ready = receive_slice(fd, ds, mods, contexts);
+    if (ready)
+        serve_commands(fd, ds, mods, contexts);
+
+    for (int i = 0; i < QUERY_MODULE_COUNT; i++)
+    {
+        if (mods[i].destroy && contexts[i])
+            mods[i].destroy(contexts[i]);
+    }
+    cleanupDataset(ds);
+    close(fd);
+    _exit(ready ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+// --- Coordinator ---
+
+static void drop_worker(ShardPool *pool, guint s)
+{
+    if (pool->fds[s] >= 0)
+    {
+        close(pool->fds[s]);
+        pool->fds[s] = -1;
+    }
+}
+
+ShardPool *shard_pool_spawn(guint nShards)
+{
+    if (nShards == 0)
+        return NULL;
+
+    ShardPool *pool = g_new0(ShardPool, 1);
+    pool->fds = g_new(int, nShards);
+    pool->pids = g_new(pid_t, nShards);
+    query_modules_collect(pool->modules);
+
+    // Nothing buffered may be written twice by the children
+    fflush(stdout);
+    fflush(stderr);
+
+    for (guint s = 0; s < nShards; s++)
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        {
+            shard_pool_free(pool);
+            return NULL;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(sv[0]);
+            for (guint prev = 0; prev < s; prev++)
+                close(pool->fds[prev]);
+            shard_worker_run(sv[1], nShards);
+        }
+
+        close(sv[1]);
+        if (pid < 0)
+        {
+            close(sv[0]);
+            shard_pool_free(pool);
+            return NULL;
+        }
+        pool->fds[s] = sv[0];
+        pool->pids[s] = pid;
+        pool->nShards = s + 1;
+    }
+    return pool;
+}
+
+gboolean shard_pool_distribute(ShardPool *pool, const Dataset *ds)
+{
+    if (!pool || !ds)
+        return FALSE;
+
+    // 1. The image of each slice, built and sent one at a time
+    for (guint s = 0; s < pool->nShards; s++)
+    {
+        ShardSlice slice = {.ds = ds, .shard = s, .nShards = pool->nShards};
+        DatasetImageFilter filter = {.keep_flight = keep_flight, .keep_reservation = keep_reservation,
+                                     .user_data = &slice};
+        DatasetImage *img = dataset_image_build_filtered(ds, &filter);
+        gsize size = 0;
+        gconstpointer data = dataset_image_data(img, &size);
+        if (!img || pool->fds[s] < 0 || !send_message(pool->fds[s], data, size))
+            drop_worker(pool, s);
+        dataset_image_free(img);
+    }
+
+    // 2. The payloads of the modules computed over the whole dataset
+    GBytes **payloads = g_new0(GBytes *, pool->nShards);
+    for (int i = 0; i < QUERY_MODULE_COUNT; i++)
+    {
+        if (!pool->modules[i].shard_export)
+            continue;
+
+        pool->modules[i].shard_export(ds, payloads, pool->nShards);
+        for (guint s = 0; s < pool->nShards; s++)
+        {
+            gsize size = 0;
+            gconstpointer data = payloads[s] ? g_bytes_get_data(payloads[s], &size) : NULL;
+            if (pool->fds[s] >= 0 && !send_message(pool->fds[s], data ? data : "", size))
+                drop_worker(pool, s);
+            if (payloads[s])
+                g_bytes_unref(payloads[s]);
+            payloads[s] = NULL;
+        }
+    }
+    g_free(payloads);
+
+    for (guint s = 0; s < pool->nShards; s++)
+    {
+        if (pool->fds[s] < 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean send_request(int fd, const QueryCommand *cmd)
+{
+    ShardRequest req = {.queryNumber = cmd->queryNumber,
+                        .isSpecial = cmd->isSpecial,
+                        .arg1Len = cmd->arg1 ? (gint32)strlen(cmd->arg1) : -1,
+                        .arg2Len = cmd->arg2 ? (gint32)strlen(cmd->arg2) : -1};
+    return send_all(fd, &req, sizeof(req)) &&
+           (!cmd->arg1 || send_all(fd, cmd->arg1, (gsize)req.arg1Len)) &&
+           (!cmd->arg2 || send_all(fd, cmd->arg2, (gsize)req.arg2Len));
+}
+
+// Scatters a command to every worker, then gathers and merges their partial results into
+// the result of command `lineNumber`. Returns FALSE, writing nothing, if a worker did not answer
+static gboolean execute_sharded(ShardPool *pool, const QueryCommand *cmd, OutputWriter *writer, int lineNumber)
+{
+    const QueryModule *mod = NULL;
+    for (int i = 0; i < QUERY_MODULE_COUNT; i++)
+    {
+        if (pool->modules[i].id == cmd->queryNumber && pool->modules[i].partial && pool->modules[i].merge)
+            mod = &pool->modules[i];
+    }
+    if (!mod || cmd->queryNumber == 0)
+    {
+        OutputBuffer *buffer = output_writer_acquire(writer, lineNumber);
+        fprintf(output_buffer_stream(buffer), "\n");
+        output_writer_submit(writer, buffer);
+        return TRUE;
+    }
+
+    for (guint s = 0; s < pool->nShards; s++)
+    {
+        if (pool->fds[s] >= 0 && !send_request(pool->fds[s], cmd))
+            drop_worker(pool, s);
+    }
+
+    gboolean complete = TRUE;
+    gchar **partials = g_new0(gchar *, pool->nShards);
+    for (guint s = 0; s < pool->nShards; s++)
+    {
+        partials[s] = pool->fds[s] >= 0 ? recv_message(pool->fds[s], NULL) : NULL;
+        if (!partials[s])
+        {
+            drop_worker(pool, s);
+            complete = FALSE;
+        }
+    }
+
+    // A missing slice would give a wrong answer: the command gets no result at all
+    if (complete)
+    {
+        OutputBuffer *buffer = output_writer_acquire(writer, lineNumber);
+        mod->merge(partials, (int)pool->nShards, cmd->arg1, cmd->arg2, cmd->isSpecial,
+                   output_buffer_stream(buffer));
+        output_writer_submit(writer, buffer);
+    }
+
+    for (guint s = 0; s < pool->nShards; s++)
+        g_free(partials[s]);
+    g_free(partials);
+    return complete;
+}
+
+gboolean runShardedQueries(ShardPool *pool, const char *filePath, OutputWriter *writer,
+                           QueryStatsCallback callback, void *ctx)
+{
+    if (!pool || !writer)
+        return FALSE;
+
+    // As in runAllQueriesWith(), a missing commands file is no command at all
+    FILE *inputFile = fopen(filePath, "r");
+    if (!inputFile)
+        return TRUE;
+
+    gboolean answered = TRUE;
+    char line[1024];
+    int lineNumber = 1;
+
+    while (answered && fgets(line, sizeof(line), inputFile))
+    {
+        QueryCommand cmd;
+        int parsed = query_command_parse(line, &cmd);
+        if (parsed < 0)
+            continue;
+        if (parsed == 0)
+        {
+            lineNumber++;
+            continue;
+        }
+
+        // The next command goes to the workers while the writer thread writes this one out
+        GTimer *timer = g_timer_new();
+        answered = execute_sharded(pool, &cmd, writer, lineNumber);
+        gdouble elapsed = g_timer_elapsed(timer, NULL);
+        g_timer_destroy(timer);
+        if (answered && callback)
+        {
+            output_writer_flush(writer);
+            callback(cmd.queryNumber, lineNumber, elapsed, FALSE, ctx);
+        }
+        lineNumber++;
+    }
+
+    fclose(inputFile);
+    return answered;
+}
+
+void shard_pool_free(ShardPool *pool)
+{
+    if (!pool)
+        return;
+
+    ShardRequest stop = {0};
+    for (guint s = 0; s < pool->nShards; s++)
+    {
+        if (pool->fds[s] >= 0)
+            send_all(pool->fds[s], &stop, sizeof(stop));
+        drop_worker(pool, s);
+    }
+    for (guint s = 0; s < pool->nShards; s++)
+        waitpid(pool->pids[s], NULL, 0);
+
+    g_free(pool->fds);
+    g_free(pool->pids);
+    g_free(pool);
+}
@@ -21,11 +21,11 @@ struct test_runner
 };
 
 static void on_query_complete(int queryNum, int lineNum, double elapsed,
-                              void *ctx)
+                              gboolean cached, void *ctx)
 {
   TestContext *tc = (TestContext *)ctx;
 
-  stats_add_timing(tc->stats, queryNum, elapsed);
+  stats_add_timing(tc->stats, queryNum, elapsed, cached);
   char generated_file[256];
   char expected_file[256];
 
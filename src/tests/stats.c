@@ -7,6 +7,7 @@ typedef struct
 {
     int total_runs;
     int correct_runs;
+    int cached_runs;
     double total_time;
     GPtrArray *errors;
 } QueryMetrics;
@@ -79,10 +80,14 @@ void stats_add_result(TestStats *stats, int query_type, int command_number, int
     }
 }
 
-void stats_add_timing(TestStats *stats, int query_type, double time_seconds)
+void stats_add_timing(TestStats *stats, int query_type, double time_seconds, gboolean cached)
 {
     QueryMetrics *m = get_or_create_metrics(stats, query_type);
-    m->total_time += time_seconds;
+    // A cached answer costs a copy, not the query: it would hide the real runtime
+    if (cached)
+        m->cached_runs++;
+    else
+        m->total_time += time_seconds;
 }
 
 void stats_print_report(TestStats *stats, double total_time_seconds)
@@ -115,7 +120,11 @@ void stats_print_report(TestStats *stats, double total_time_seconds)
     {
         int q_type = GPOINTER_TO_INT(l->data);
         QueryMetrics *m = g_hash_table_lookup(stats->metrics_map, l->data);
-        printf("Q%d: %.1f ms\n", q_type, m->total_time * 1000.0);
+        if (m->cached_runs > 0)
+            printf("Q%d: %.1f ms (%d of %d answered from the result cache, not timed)\n", q_type,
+                   m->total_time * 1000.0, m->cached_runs, m->total_runs);
+        else
+            printf("Q%d: %.1f ms\n", q_type, m->total_time * 1000.0);
     }
 
     printf("Total time: %.0f ms\n", total_time_seconds * 1000.0);